@@ -0,0 +1,210 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "Json.hpp"
+#include "JsonArena.hpp"
+#include "JsonStringPool.hpp"
+#include "JsonParser.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace json;
+
+namespace
+{
+    // A small deterministic random generator so that every run uses the same corpus.
+    class Random
+    {
+    public:
+        Random() : state(0x2545F4914F6CDD1DULL)
+        {
+        }
+
+        uint32_t next()
+        {
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+            return static_cast<uint32_t>((state * 0x2545F4914F6CDD1DULL) >> 32);
+        }
+
+        size_t below(size_t limit)
+        {
+            return next() % limit;
+        }
+
+    private:
+        uint64_t state;
+    };
+
+    // Most arrays have 0-4 elements and most objects have fewer than 8 members,
+    // but now and then a container is a lot larger.
+    size_t containerSize(Random &random, size_t common)
+    {
+        return random.below(20) == 0 ? 8 + random.below(32) : random.below(common + 1);
+    }
+
+    void writeValue(std::ostream &output, Random &random, int depth);
+
+    void writeArray(std::ostream &output, Random &random, int depth)
+    {
+        size_t size = containerSize(random, 4);
+        output << '[';
+        for (size_t i = 0; i < size; i++)
+        {
+            if (i > 0)
+                output << ',';
+            writeValue(output, random, depth + 1);
+        }
+        output << ']';
+    }
+
+    void writeObject(std::ostream &output, Random &random, int depth)
+    {
+        static const char *names[] = {"id", "name", "type", "value", "tags", "created", "enabled", "owner", "items", "meta"};
+        size_t size = containerSize(random, 7);
+        output << '{';
+        for (size_t i = 0; i < size; i++)
+        {
+            if (i > 0)
+                output << ',';
+            output << '"' << names[i % 10];
+            if (i >= 10)
+                output << i;
+            output << "\":";
+            writeValue(output, random, depth + 1);
+        }
+        output << '}';
+    }
+
+    void writeValue(std::ostream &output, Random &random, int depth)
+    {
+        size_t kind = depth < 4 ? random.below(8) : 2 + random.below(6);
+
+        if (kind == 0)
+            writeArray(output, random, depth);
+        else if (kind == 1)
+            writeObject(output, random, depth);
+        else if (kind == 2 || kind == 3)
+            output << random.below(100000);
+        else if (kind == 4)
+            output << (random.below(2) ? "true" : "false");
+        else if (kind == 5)
+            output << "null";
+        else
+            output << "\"value-" << random.below(1000) << '"';
+    }
+
+    // Visits every node and looks up a few names in every object.
+    size_t visit(const JsonNode &node)
+    {
+        size_t count = 1;
+
+        if (node.getType() == JsonNodeType::Array)
+        {
+            for (const JsonNode &child : node.toArray())
+                count += visit(child);
+        }
+        else if (node.getType() == JsonNodeType::Object)
+        {
+            const JsonObject &object = node.toObject();
+            count += object.hasChild("id") + object.hasChild("meta") + object.hasChild("missing");
+            for (const auto &pair : object)
+                count += visit(pair.second);
+        }
+        return count;
+    }
+
+    double millisecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    // The number of top level records in the corpus.
+    size_t records = argc > 1 ? std::stoul(argv[1]) : 20000;
+
+    Random random;
+    std::stringstream corpus;
+    corpus << '[';
+    for (size_t i = 0; i < records; i++)
+    {
+        if (i > 0)
+            corpus << ',';
+        writeObject(corpus, random, 0);
+    }
+    corpus << ']';
+
+    std::string text = corpus.str();
+    std::cout << "Corpus: " << records << " records, " << text.size() << " bytes" << std::endl;
+
+    // Parse into an arena like a JsonDocument does, the whole document is released at once.
+    {
+        JsonArena *arena = new JsonArena();
+        arena->setStringPool(std::make_shared<JsonStringPool>());
+        std::istringstream input(text);
+
+        auto start = std::chrono::steady_clock::now();
+        const JsonNode *root = JsonParser::parse(input, *arena);
+        std::cout << "Arena parse:    " << millisecondsSince(start) << " ms, "
+                  << arena->getBytesUsed() << " bytes used, " << arena->getChunkCount() << " chunks, "
+                  << arena->getStringPool()->getBytesUsed() << " bytes in the string pool" << std::endl;
+
+        start = std::chrono::steady_clock::now();
+        size_t visited = visit(*root);
+        std::cout << "Arena traverse: " << millisecondsSince(start) << " ms (" << visited << " visits)" << std::endl;
+
+        start = std::chrono::steady_clock::now();
+        delete arena;
+        std::cout << "Arena destroy:  " << millisecondsSince(start) << " ms" << std::endl;
+    }
+
+    // Parse with every node allocated on its own.
+    {
+        std::istringstream input(text);
+
+        auto start = std::chrono::steady_clock::now();
+        JsonNodePtr root = JsonParser::parse(input);
+        std::cout << "Heap parse:     " << millisecondsSince(start) << " ms" << std::endl;
+
+        start = std::chrono::steady_clock::now();
+        size_t visited = visit(*root);
+        std::cout << "Heap traverse:  " << millisecondsSince(start) << " ms (" << visited << " visits)" << std::endl;
+
+        JsonDocument document(std::move(root));
+        start = std::chrono::steady_clock::now();
+        size_t written = document.toString().size();
+        std::cout << "Heap write:     " << millisecondsSince(start) << " ms (" << written << " bytes)" << std::endl;
+
+        start = std::chrono::steady_clock::now();
+        document = JsonDocument();
+        std::cout << "Heap destroy:   " << millisecondsSince(start) << " ms" << std::endl;
+    }
+}
\ No newline at end of file
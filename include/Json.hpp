@@ -33,5 +33,14 @@ THE SOFTWARE.
 #include "JsonNull.hpp"
 #include "JsonNumber.hpp"
 #include "JsonString.hpp"
+#include "JsonStringView.hpp"
+#include "JsonKey.hpp"
+#include "JsonVisitor.hpp"
+#include "JsonStringPool.hpp"
+#include "JsonReclaimer.hpp"
+#include "JsonMemoryResource.hpp"
+#include "JsonSerializer.hpp"
+#include "JsonParallelSerializer.hpp"
+#include "JsonWriter.hpp"
 
 #endif
\ No newline at end of file
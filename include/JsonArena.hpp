@@ -0,0 +1,329 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef JSON_ARENA_HPP
+#define JSON_ARENA_HPP
+
+#include "JsonStringView.hpp"
+#include "JsonMemoryUsage.hpp"
+#include "JsonMemoryResource.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace json
+{
+    class JsonNode;
+    class JsonStringPool;
+
+    /**
+     * A chunked bump-pointer allocator. A JsonDocument owns one JsonArena and every node,
+     * container buffer, key and string value of the document is allocated from it.
+     * The chunks are taken from a JsonMemoryResource. Memory is never handed back to the resource
+     * one allocation at a time, instead all chunks are released together when the arena is destroyed.
+    */
+    class JsonArena
+    {
+    public:
+        /**
+         * Creates a new JsonArena. No memory is reserved until the first allocation.
+        */
+        JsonArena();
+
+        /**
+         * Creates a new JsonArena where the first chunk will have a specific size.
+         * Every following chunk is twice as large as the previous one (up to a limit).
+        */
+        explicit JsonArena(size_t initialChunkSize);
+
+        /**
+         * Creates a new JsonArena that takes its chunks from a memory resource.
+         * An initial chunk size of 0 means the default size. The resource must outlive the arena.
+        */
+        JsonArena(size_t initialChunkSize, JsonMemoryResource *resource);
+
+        /**
+         * Runs all registered cleanups and releases every chunk.
+        */
+        ~JsonArena();
+
+        JsonArena(const JsonArena &) = delete;
+        JsonArena &operator=(const JsonArena &) = delete;
+
+        /**
+         * Creates a new JsonArena owned by a shared_ptr. Only such arenas can share subtrees with other arenas.
+        */
+        static std::shared_ptr<JsonArena> createShared();
+
+        /**
+         * Creates a new JsonArena owned by a shared_ptr where the first chunk will have a specific size.
+        */
+        static std::shared_ptr<JsonArena> createShared(size_t initialChunkSize);
+
+        /**
+         * Creates a new JsonArena owned by a shared_ptr that takes its chunks, and the memory
+         * of the shared_ptr itself, from a memory resource.
+        */
+        static std::shared_ptr<JsonArena> createShared(size_t initialChunkSize, JsonMemoryResource *resource);
+
+        /**
+         * Returns the resource the chunks are taken from.
+        */
+        JsonMemoryResource *getMemoryResource() const noexcept;
+
+        /**
+         * Returns a shared_ptr to this arena, or nullptr if the arena was not created with createShared().
+        */
+        std::shared_ptr<JsonArena> getShared() const noexcept;
+
+        /**
+         * Keeps another arena alive as long as this arena exists.
+         * This is needed when a subtree allocated from the other arena is moved into a tree that uses this arena.
+         * If the other arena already keeps this arena alive then a runtime_error is thrown, since neither would ever be released.
+        */
+        void retain(std::shared_ptr<JsonArena> other);
+
+        /**
+         * Returns true if this arena keeps the other arena alive, directly or through another arena.
+        */
+        bool isRetaining(const JsonArena *other) const;
+
+        /**
+         * Returns a pointer to a block of memory with a specific size and alignment.
+         * The alignment must be a power of two. The bytes are counted as the given category, see getMemoryUsage().
+        */
+        void *allocate(size_t size, size_t alignment = alignof(std::max_align_t),
+                       JsonMemoryCategory category = JsonMemoryCategory::ContainerStorage);
+
+        /**
+         * Makes allocate() take the same lock as allocateConcurrently(). This is needed when one thread modifies
+         * a tree while other threads read trees sharing the arena, since reading may allocate.
+        */
+        void setSynchronized(bool synchronized) noexcept;
+
+        /**
+         * Same as allocate() but may be called by several threads at the same time.
+         * This is used when a const method needs to allocate memory, for example to cache a decoded value.
+        */
+        void *allocateConcurrently(size_t size, size_t alignment = alignof(std::max_align_t),
+                                   JsonMemoryCategory category = JsonMemoryCategory::ContainerStorage);
+
+        /**
+         * Copies the characters into the arena and returns a view of the copy.
+        */
+        JsonStringView copyString(JsonStringView str, JsonMemoryCategory category = JsonMemoryCategory::ValueStrings);
+
+        /**
+         * Registers a function that will be called with the object as argument when the arena is destroyed.
+         * This is needed for objects living in the arena that hold memory which is not owned by the arena.
+         * This method may be called by several threads at the same time.
+        */
+        void addCleanup(void (*function)(void *), void *object);
+
+        /**
+         * Counts memory that the arena keeps alive but did not allocate, for example a node allocated with new
+         * that is released by a cleanup. This method may be called by several threads at the same time.
+        */
+        void account(const JsonMemoryUsage &usage);
+
+        /**
+         * Sets the pool that interns the names (and short string values if enabled) of the objects
+         * allocated from this arena. The arena keeps the pool alive. A nullptr disables interning.
+        */
+        void setStringPool(std::shared_ptr<JsonStringPool> pool) noexcept;
+
+        /**
+         * Returns the string pool used by this arena, or nullptr if strings are not interned.
+        */
+        JsonStringPool *getStringPool() const noexcept;
+
+        /**
+         * Returns the string pool so that it can be shared with another arena.
+        */
+        const std::shared_ptr<JsonStringPool> &getSharedStringPool() const noexcept;
+
+        /**
+         * Returns the number of bytes that have been handed out by allocate().
+        */
+        size_t getBytesUsed() const noexcept;
+
+        /**
+         * Returns the number of bytes that the arena has reserved from its memory resource.
+        */
+        size_t getBytesReserved() const noexcept;
+
+        /**
+         * Returns the number of chunks the arena has reserved.
+        */
+        size_t getChunkCount() const noexcept;
+
+        /**
+         * Returns the memory used by this arena, the arenas it keeps alive and their string pools.
+         * Running counters are kept for every category, so this does not depend on the size of the trees.
+         * The slack is the memory reserved by the arenas that holds nothing. Memory is never handed back
+         * one allocation at a time, so a buffer left behind when a container grew still counts as used.
+        */
+        JsonMemoryUsage getMemoryUsage() const;
+
+        /**
+         * Creates an object of type T. If the arena is nullptr the object is allocated with new instead.
+        */
+        template <typename T, typename... Args>
+        static T *create(JsonArena *arena, Args &&... args);
+
+        /**
+         * Copies the characters into the arena, or into a block allocated with new[] if the arena is nullptr.
+        */
+        static JsonStringView copyString(JsonArena *arena, JsonStringView str,
+                                         JsonMemoryCategory category = JsonMemoryCategory::ValueStrings);
+
+        /**
+         * Releases characters copied with copyString(). Characters living in an arena are not released individually.
+        */
+        static void destroyString(JsonArena *arena, JsonStringView str) noexcept;
+
+    private:
+        struct Chunk
+        {
+            Chunk *previous;
+            size_t size;
+        };
+
+        struct Cleanup
+        {
+            void (*function)(void *);
+            void *object;
+            Cleanup *next;
+        };
+
+        // Allocates without taking the lock.
+        void *allocateUnsynchronized(size_t size, size_t alignment, JsonMemoryCategory category);
+
+        // Reserves a new chunk that can hold at least the requested size and allocates from it.
+        void *allocateSlow(size_t size, size_t alignment, JsonMemoryCategory category);
+
+        // Reserves a chunk from the memory resource.
+        Chunk *allocateChunk(size_t size);
+
+        JsonMemoryResource *resource;
+        Chunk *chunks;
+        char *position;
+        char *end;
+        size_t nextChunkSize;
+        size_t chunkCount;
+        size_t bytesUsed;
+        size_t bytesReserved;
+        Cleanup *cleanups;
+
+        // The bytes handed out for every category, and the memory passed to account().
+        JsonMemoryUsage allocated;
+        JsonMemoryUsage accounted;
+
+        std::shared_ptr<JsonStringPool> stringPool;
+
+        // Set by setSynchronized().
+        std::atomic<bool> synchronized;
+
+        // Set by createShared().
+        std::weak_ptr<JsonArena> self;
+
+        // The arenas that hold subtrees of the trees using this arena.
+        std::vector<std::shared_ptr<JsonArena>> retained;
+
+        // Guards allocateConcurrently(), addCleanup(), account() and retained.
+        mutable std::mutex mutex;
+    };
+
+    /**
+     * A standard allocator that takes its memory from a JsonArena.
+     * If no arena is given the allocator falls back to operator new and operator delete.
+    */
+    template <typename T>
+    class JsonArenaAllocator
+    {
+    public:
+        typedef T value_type;
+
+        JsonArenaAllocator(JsonArena *arena = nullptr) noexcept : arena(arena)
+        {
+        }
+
+        template <typename U>
+        JsonArenaAllocator(const JsonArenaAllocator<U> &other) noexcept : arena(other.getArena())
+        {
+        }
+
+        T *allocate(size_t n)
+        {
+            if (arena)
+                return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T)));
+            return static_cast<T *>(::operator new(n * sizeof(T)));
+        }
+
+        void deallocate(T *pointer, size_t) noexcept
+        {
+            if (!arena)
+                ::operator delete(pointer);
+        }
+
+        JsonArena *getArena() const noexcept
+        {
+            return arena;
+        }
+
+    private:
+        JsonArena *arena;
+    };
+
+    template <typename T, typename U>
+    bool operator==(const JsonArenaAllocator<T> &lhs, const JsonArenaAllocator<U> &rhs) noexcept
+    {
+        return lhs.getArena() == rhs.getArena();
+    }
+
+    template <typename T, typename U>
+    bool operator!=(const JsonArenaAllocator<T> &lhs, const JsonArenaAllocator<U> &rhs) noexcept
+    {
+        return lhs.getArena() != rhs.getArena();
+    }
+
+    template <typename T, typename... Args>
+    T *JsonArena::create(JsonArena *arena, Args &&... args)
+    {
+        if (arena)
+        {
+            JsonMemoryCategory category = std::is_base_of<JsonNode, T>::value ? JsonMemoryCategory::NodeHeaders : JsonMemoryCategory::ContainerStorage;
+            return new (arena->allocate(sizeof(T), alignof(T), category)) T(std::forward<Args>(args)...);
+        }
+        return new T(std::forward<Args>(args)...);
+    }
+} // namespace json
+
+#endif
\ No newline at end of file
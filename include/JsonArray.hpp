@@ -26,14 +26,20 @@ THE SOFTWARE.
 #define JSON_ARRAY_HPP
 
 #include "JsonNode.hpp"
+#include "JsonArena.hpp"
+#include "JsonSmallVector.hpp"
+#include "JsonSpan.hpp"
 
-#include <vector>
-#include <memory>
+#include <atomic>
 
 namespace json
 {
+    class JsonDocument;
+
     /**
      * Represents a node that holds a collection of child nodes. Each child node can be accessed using a numeric index.
+     * An array that only holds numbers can be packed, then the numbers are stored in one contiguous buffer
+     * and a JsonNumber node is only created for a number when it is accessed as a node.
     */
     class JsonArray : public JsonNode
     {
@@ -47,9 +53,9 @@ namespace json
         {
         public:
             /**
-             * Creates a new iterator object.
+             * Creates a new iterator object referring to the child at a specific index.
             */
-            iterator(std::vector<std::unique_ptr<JsonNode>>::iterator it);
+            iterator(JsonArray *array, size_t index);
 
             /**
              * The prefix operator will return an iterator object referring to the next element in the array.
@@ -107,7 +113,8 @@ namespace json
             JsonNode &operator*();
 
         private:
-            std::vector<std::unique_ptr<JsonNode>>::iterator it;
+            JsonArray *array;
+            size_t index;
         };
 
         /**
@@ -119,9 +126,9 @@ namespace json
         {
         public:
             /**
-             * Creates a new const_iterator object.
+             * Creates a new const_iterator object referring to the child at a specific index.
             */
-            const_iterator(std::vector<std::unique_ptr<JsonNode>>::const_iterator it);
+            const_iterator(const JsonArray *array, size_t index);
 
             /**
              * The prefix operator will return a const_iterator object referring to the next element in the array.
@@ -179,7 +186,8 @@ namespace json
             const JsonNode &operator*() const;
 
         private:
-            std::vector<std::unique_ptr<JsonNode>>::const_iterator it;
+            const JsonArray *array;
+            size_t index;
         };
 
         /**
@@ -193,31 +201,27 @@ namespace json
         JsonArray(JsonNode *parent);
 
         /**
-         * Returns JsonNodeType::Array.
-        */
-        JsonNodeType getType() const noexcept override;
-
-        /**
-         * Returns a reference to this JsonArray.
+         * Creates a new JsonArray with a parent. All children will be allocated from the arena.
+         * If the arena is nullptr the children are allocated with new.
         */
-        JsonArray &toArray() override;
+        JsonArray(JsonNode *parent, JsonArena *arena);
 
         /**
-         * Returns a const reference to this JsonArray.
+         * Destroys the JsonArray and all its children.
         */
-        const JsonArray &toArray() const override;
+        ~JsonArray();
 
         /**
          * Returns the child node at a specific index. 
          * No range checks are done so make sure the index is within the boundaries.
         */
-        JsonNode &operator[](size_t index) override;
+        JsonNode &operator[](size_t index);
 
         /**
          * Returns the immutable child node at a specific index. 
          * No range checks are done so make sure the index is within the boundaries.
         */
-        const JsonNode &operator[](size_t index) const override;
+        const JsonNode &operator[](size_t index) const;
 
         /**
          * Will add a new JsonArray object to the child collection and return a reference to the new object.
@@ -254,6 +258,12 @@ namespace json
         */
         JsonString &addString(std::string &&value);
 
+        /**
+         * Adds numbers without creating a JsonNumber node for each of them.
+         * If the array is empty or packed the numbers are stored in the packed buffer.
+        */
+        void addNumbers(JsonSpan<const double> numbers);
+
         /**
          * Replace the current node at a specific index with a new JsonArray object.
         */
@@ -318,6 +328,66 @@ namespace json
         */
         void removeChild(size_t index);
 
+        /**
+         * Makes room for a specific number of children, so that adding them does not have to grow the storage again.
+        */
+        void reserve(size_t capacity);
+
+        /**
+         * Removes the child at a specific index and returns a JsonDocument that owns it. No nodes are copied.
+         * If the array lives in an arena the returned document keeps that arena alive, the whole arena and not only the
+         * memory of the subtree, until the document and every container the subtree is attached to are gone.
+        */
+        JsonDocument detach(size_t index);
+
+        /**
+         * Moves the root of the document to the end of this array and returns a reference to it.
+         * No nodes are copied, the document is empty afterwards. The arena of this array keeps the arena of the subtree alive,
+         * unless that arena already keeps this one alive, for example after subtrees were moved in the other direction.
+         * Then the subtree is copied into the arena of this array, so the two arenas do not keep each other alive forever.
+        */
+        JsonNode &attach(JsonDocument &&subtree);
+
+        /**
+         * Moves the root of the document into this array before a specific index and returns a reference to it.
+         * No nodes are copied, the document is empty afterwards. The arena of this array keeps the arena of the subtree alive,
+         * unless that arena already keeps this one alive, for example after subtrees were moved in the other direction.
+         * Then the subtree is copied into the arena of this array, so the two arenas do not keep each other alive forever.
+        */
+        JsonNode &attach(size_t index, JsonDocument &&subtree);
+
+        /**
+         * Moves a child of another array (or of this array) into this array before a specific index.
+         * The index refers to the position after the child has been removed from the source.
+        */
+        JsonNode &splice(size_t index, JsonArray &source, size_t sourceIndex);
+
+        /**
+         * Returns true if the children are numbers stored in one contiguous buffer.
+         * Adding a child that is not a number moves the numbers back into JsonNumber nodes.
+        */
+        bool isPacked() const noexcept;
+
+        /**
+         * Moves the children into a packed buffer if they are all numbers and returns true,
+         * otherwise the array is left as it is and false is returned. Parsed numbers whose text differs from
+         * the text of their value, such as 1e5 or 1.50, are not packed either, since their text would be lost.
+         * References to the children of the array are no longer valid after the array has been packed.
+        */
+        bool pack();
+
+        /**
+         * Returns the numbers of a packed array. Changing a number is seen by the JsonNumber nodes of the array.
+         * If the array is not packed then an error will be thrown.
+        */
+        JsonSpan<double> getNumbers();
+
+        /**
+         * Returns the immutable numbers of a packed array.
+         * If the array is not packed then an error will be thrown.
+        */
+        JsonSpan<const double> getNumbers() const;
+
         /**
          * Returns an iterator referring to the beginning.
          * The begin() and end() methods are needed for the range-based for loop.
@@ -343,7 +413,63 @@ namespace json
         const_iterator end() const;
 
     private:
-        std::vector<std::unique_ptr<JsonNode>> children;
+        friend class JsonNode;
+        friend class JsonParser;
+
+        // Appends a node created with this array as parent. The node is not destroyed if this fails.
+        void appendChild(JsonNode *child);
+
+        // Creates a new child in the arena of this JsonArray.
+        template <typename ChildType, typename... Args>
+        ChildType &addChild(Args &&... args);
+
+        // The buffer of a packed array.
+        struct Packed
+        {
+            double *numbers;
+            size_t count;
+            size_t capacity;
+
+            // The JsonNumber nodes of the numbers, created when a number is accessed as a node.
+            // The array has room for capacity nodes and is nullptr until the first node is created.
+            std::atomic<std::atomic<JsonNumber *> *> boxes;
+        };
+
+        // Returns the child node at a specific index, creating it if the array is packed.
+        JsonNode &childAt(size_t index) const;
+
+        // Returns the child node at a specific index for a caller that may modify it, see JsonNode::unshare().
+        JsonNode &writableChild(size_t index);
+
+        // Returns a copy of this array that shares the children, see JsonNode::copy().
+        JsonArray *copy(JsonArena *target, JsonNode *parent) const;
+
+        // Adds the memory of the buffers of this array, but not of its children, see JsonNode::memoryUsage().
+        void addMemoryUsage(JsonMemoryUsage &usage) const noexcept;
+
+        // Returns the node of a number in a packed array, creating it the first time. This may be called by several threads at the same time.
+        JsonNumber &box(size_t index) const;
+
+        // Makes sure the packed buffer has room for a specific number of numbers.
+        void reservePacked(size_t capacity);
+
+        // Moves the numbers of a packed array into JsonNumber nodes.
+        void unpack();
+
+        // Releases the packed buffer and the nodes created for it.
+        void destroyPacked() noexcept;
+
+        // Replaces the child at a specific index with a new child.
+        template <typename ChildType, typename... Args>
+        ChildType &setChild(size_t index, Args &&... args);
+
+        JsonArena *arena;
+
+        // Most arrays are small, so the first few children are stored inside the JsonArray itself.
+        JsonSmallVector<JsonNode *, 4> children;
+
+        // Not nullptr while the array is packed, children is empty in that case.
+        Packed *packed;
     };
 } // namespace json
 
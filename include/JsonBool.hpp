@@ -46,24 +46,16 @@ namespace json
         JsonBool(JsonNode *parent, bool value);
 
         /**
-         * Returns JsonNodeType::Bool.
+         * Replaces the boolean value this JsonBool is storing.
+         * Throws a std::runtime_error if the node is shared with a snapshot, see JsonNode::isShared().
         */
-        JsonNodeType getType() const noexcept override;
-
-        /**
-         * Returns a reference to this JsonBool.
-        */
-        JsonBool &toBool() override;
-
-        /**
-         * Returns a const reference to this JsonBool.
-        */
-        const JsonBool &toBool() const override;
+        JsonBool &operator=(bool value);
 
         /**
          * Returns a reference to the boolean value this JsonBool is storing.
+         * Throws a std::runtime_error if the node is shared with a snapshot, since the value may be changed through the reference.
         */
-        bool &data() noexcept;
+        bool &data();
 
         /**
          * Returns a const reference to the boolean value this JsonBool is storing.
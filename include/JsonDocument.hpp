@@ -26,6 +26,9 @@ THE SOFTWARE.
 #define JSON_DOCUMENT_HPP
 
 #include "JsonNode.hpp"
+#include "JsonArena.hpp"
+#include "JsonStringPool.hpp"
+#include "JsonFormat.hpp"
 
 #include <memory>
 
@@ -33,6 +36,14 @@ namespace json
 {
     /**
      * Represents a JSON document and stores the root node.
+     * The document owns a JsonArena that all nodes created through the document are allocated from,
+     * so destroying a document only has to release the chunks of the arena.
+     * The names of all objects in the document are interned in a JsonStringPool.
+     * Subtrees can be moved between documents without copying them with the detach() and attach() methods
+     * of JsonArray and JsonObject. A document that receives a subtree keeps the arena of the other document alive,
+     * so the two documents share memory and must not be modified by different threads at the same time.
+     * The whole arena is kept alive, even if the subtree is a small part of it. If the other arena already keeps
+     * the arena of the document alive, the subtree is copied instead, see JsonArray::attach().
     */
     class JsonDocument
     {
@@ -45,7 +56,22 @@ namespace json
         /**
          * Creates a new JsonDocument with a root node.
         */
-        JsonDocument(std::unique_ptr<JsonNode> root);
+        JsonDocument(JsonNodePtr root);
+
+        /**
+         * Moves the root node and the arena from another JsonDocument.
+        */
+        JsonDocument(JsonDocument &&other) noexcept;
+
+        /**
+         * Moves the root node and the arena from another JsonDocument.
+        */
+        JsonDocument &operator=(JsonDocument &&other) noexcept;
+
+        /**
+         * Destroys the JsonDocument and releases all memory used by its nodes.
+        */
+        ~JsonDocument();
 
         /**
          * Will set a JsonArray object as root replacing the previous root node if necessary. 
@@ -89,34 +115,141 @@ namespace json
 
         /**
          * Returns a reference to the current root node.
+         * If the root is shared with a snapshot the document first takes a copy of it, see snapshot().
         */
         JsonNode &getRoot();
 
+        /**
+         * Returns a const reference to the current root node.
+        */
+        const JsonNode &getRoot() const;
+
+        /**
+         * Returns a new document that shares all nodes with this document, no nodes are copied.
+         * The shared nodes are never modified again. When a container is reached through the non-const methods
+         * of a document (getRoot(), operator[], getChild() and the iterators) and it is shared, the document
+         * replaces it with a copy of its own first. So a change copies the containers on the path from the root
+         * to the changed node and the rest of the tree stays shared.
+         * The snapshot may be read through const references by other threads while this document is modified,
+         * but a reference obtained before the snapshot was taken refers to a shared node, and a change made through it
+         * throws a std::runtime_error. The node has to be reached again through the document.
+        */
+        JsonDocument snapshot() const;
+
+        /**
+         * Returns a deep copy of this document with an arena and a string pool of its own.
+         * The copy can be modified by another thread while this document is used.
+        */
+        JsonDocument clone() const;
+
+        /**
+         * Returns a deep copy of this document that interns its names in a specific pool.
+         * Passing the pool of this document is the fastest way to copy, since the objects of the copy share
+         * the shapes of the original, but then the two documents must not be modified at the same time.
+        */
+        JsonDocument clone(std::shared_ptr<JsonStringPool> pool) const;
+
+        /**
+         * Rebuilds the tree in a new arena and releases the old one, so the memory of removed and replaced nodes is
+         * given back. The children of every container are placed next to each other in one contiguous region,
+         * together with their strings, which makes traversing the document faster after many changes.
+         * Returns the number of bytes reclaimed, measured with memoryUsage(). An arena that is still used by a snapshot
+         * or by another document is only released once they are gone. References to nodes of the document are invalidated.
+        */
+        size_t compact();
+
+        /**
+         * Rebuilds the tree like compact(), but stores subtrees that are equal only once and shares them between all the
+         * places where they occur. Catalogs that repeat the same objects many times become a lot smaller.
+         * A shared subtree is copied when it is modified through the document, just like after snapshot(), so the
+         * document behaves as before. Two subtrees are equal if they hold the same values with the names in the same order.
+         * Returns the number of bytes reclaimed, measured with memoryUsage().
+        */
+        size_t deduplicate();
+
+        /**
+         * Returns the pool that interns the names of this document.
+         * It can be passed to createFromStream() so that several documents store their names only once.
+        */
+        std::shared_ptr<JsonStringPool> getStringPool();
+
+        /**
+         * Returns the memory used by this document, broken down by category.
+         * For a document whose root lives in the arena this reads running counters kept by the arena and
+         * does not visit the tree, otherwise the tree is visited as with JsonNode::memoryUsage().
+         * The counts include the arenas this document keeps alive and their string pools, so documents sharing
+         * an arena or a pool, such as a snapshot and its document, each count the shared memory.
+        */
+        JsonMemoryUsage memoryUsage() const;
+
         /**
          * Will write the contents of this document to an output stream with a desirable tab size.
         */
         void writeToStream(std::ostream &output, size_t tabSize = 4) const;
 
+        /**
+         * Will write the contents of this document to an output stream with a specific format, for example JsonFormat::compact().
+         * The text is handed to the stream in large blocks. With JsonFormat::threads a large document is written by several threads.
+         * Throws a std::runtime_error for a number that is infinity or NaN, unless it was parsed and still has its text.
+        */
+        void writeToStream(std::ostream &output, const JsonFormat &format) const;
+
+        /**
+         * Will replace the contents of a string with the contents of this document. The capacity of the string is reused,
+         * so writing many documents into the same string allocates no memory once it is large enough.
+        */
+        void writeToString(std::string &output, const JsonFormat &format = JsonFormat()) const;
+
         /**
          * Will write the contents of this document to a file.
         */
         void saveToFile(const std::string &filePath, size_t tabSize = 4) const;
 
+        /**
+         * Will write the contents of this document to a file with a specific format.
+        */
+        void saveToFile(const std::string &filePath, const JsonFormat &format) const;
+
         /**
          * Will return the contents of this document as a string. 
         */
         std::string toString(size_t tabSize = 4) const;
 
+        /**
+         * Will return the contents of this document as a string with a specific format.
+        */
+        std::string toString(const JsonFormat &format) const;
+
         /**
          * Creates a new empty JsonDocument.
         */
         static JsonDocument create();
 
+        /**
+         * Creates a new empty JsonDocument where every node, container buffer and string is allocated from a memory resource.
+         * The names are interned in a pool that allocates from the same resource. The resource must outlive the document
+         * and every document sharing its arena, such as snapshots and clones.
+        */
+        static JsonDocument create(JsonMemoryResource *resource);
+
         /**
          * Creates a new JsonDocument from an input stream.
         */
         static JsonDocument createFromStream(std::istream &input);
 
+        /**
+         * Creates a new JsonDocument from an input stream. The names are interned in a pool
+         * that can be shared with other documents, such as the documents of an NDJSON stream.
+         * If the pool is nullptr no strings are interned.
+        */
+        static JsonDocument createFromStream(std::istream &input, std::shared_ptr<JsonStringPool> pool);
+
+        /**
+         * Creates a new JsonDocument from an input stream where the tree is allocated from a memory resource,
+         * see create(JsonMemoryResource *). The pool may use another resource, see JsonStringPool::createShared().
+        */
+        static JsonDocument createFromStream(std::istream &input, std::shared_ptr<JsonStringPool> pool, JsonMemoryResource *resource);
+
         /**
          * Creates a new JsonDocument from a file.
         */
@@ -127,11 +260,114 @@ namespace json
         */
         static JsonDocument createFromString(const std::string &jsonText);
 
+        /**
+         * Creates a new JsonDocument from a string. The names are interned in a pool
+         * that can be shared with other documents, for example one document per line of an NDJSON file.
+        */
+        static JsonDocument createFromString(const std::string &jsonText, std::shared_ptr<JsonStringPool> pool);
+
+        /**
+         * Creates a new JsonDocument from a string where the tree is allocated from a memory resource.
+        */
+        static JsonDocument createFromString(const std::string &jsonText, std::shared_ptr<JsonStringPool> pool, JsonMemoryResource *resource);
+
+        /**
+         * Creates a new JsonDocument by parsing JSON text in place. The strings are not copied, they refer to the buffer,
+         * where strings with escape sequences are unescaped, so the buffer is modified. It must not be changed afterwards
+         * and must outlive the document and every document sharing its arena, such as snapshots.
+         * A file mapped into memory with private pages can be parsed this way. clone() and compact() copy the strings
+         * out of the buffer.
+        */
+        static JsonDocument createInSitu(char *buffer, size_t size);
+
+        /**
+         * Creates a new JsonDocument by parsing JSON text in place, with the names interned in a pool.
+        */
+        static JsonDocument createInSitu(char *buffer, size_t size, std::shared_ptr<JsonStringPool> pool);
+
+        /**
+         * Creates a new JsonDocument by parsing JSON text in place, where the nodes are allocated from a memory resource.
+        */
+        static JsonDocument createInSitu(char *buffer, size_t size, std::shared_ptr<JsonStringPool> pool, JsonMemoryResource *resource);
+
+        /**
+         * Creates a new JsonDocument by parsing JSON text in place. The document takes over the string
+         * and keeps it for as long as its arena lives.
+        */
+        static JsonDocument createInSitu(std::string &&jsonText);
+
+        /**
+         * Creates a new JsonDocument by parsing JSON text in place, with the names interned in a pool.
+         * The document takes over the string and keeps it for as long as its arena lives.
+        */
+        static JsonDocument createInSitu(std::string &&jsonText, std::shared_ptr<JsonStringPool> pool);
+
     private:
-        // Recursive method that writes a node and all its child nodes to an output stream.
-        static void writeNode(std::ostream &output, const JsonNode &node, std::string indent, size_t tabSize);
+        friend class JsonNode;
+        friend class JsonArray;
+        friend class JsonObject;
+        friend class JsonReclaimer;
+
+        /**
+         * Moves the root of a document into a container. The container creates a Transfer before it adds the node
+         * and calls commit() once the node has been added, so the document keeps its root if adding the node fails.
+        */
+        class Transfer
+        {
+        public:
+            /**
+             * Checks that the root of the document can be added to the container, which allocates from the arena.
+            */
+            Transfer(JsonDocument &document, const JsonNode &container, JsonArena *arena);
+
+            Transfer(const Transfer &) = delete;
+            Transfer &operator=(const Transfer &) = delete;
+
+            /**
+             * Returns the root of the document.
+            */
+            JsonNode *getNode() const noexcept;
+
+            /**
+             * Hands the root over to the container.
+            */
+            void commit() noexcept;
+
+        private:
+            // Deletes the root held by a holder, this is registered as a cleanup of the arena.
+            static void release(void *holder);
+
+            JsonDocument &document;
+
+            // Releases a root allocated with new when the arena of the container is destroyed.
+            JsonNode **holder;
+        };
+
+        // Creates a document that owns a node removed from a container which allocates from the arena.
+        static JsonDocument adopt(JsonArena *arena, JsonNode *node);
+
+        // Creates a document holding a deep copy of a node. The first chunk of the arena has a specific size,
+        // or the default size if it is 0, and is taken from the memory resource.
+        static JsonDocument clone(const JsonNode &node, std::shared_ptr<JsonStringPool> pool, size_t initialChunkSize,
+                                  JsonMemoryResource *resource);
+
+        // Returns the resource of the arena, or the default resource if there is no arena yet.
+        JsonMemoryResource *getMemoryResource() const noexcept;
+
+        // Replaces the tree with a copy in a new arena, see compact() and deduplicate(). Returns the bytes reclaimed.
+        size_t rebuild(bool deduplicate);
+
+        // Returns the arena, creating it the first time it is needed.
+        JsonArena &getArena();
+
+        // Releases the reference to the root, the root is destroyed unless it lives in the arena or is shared.
+        void destroyRoot() noexcept;
+
+        std::shared_ptr<JsonArena> arena;
+        JsonNode *root;
 
-        std::unique_ptr<JsonNode> root;
+        // True if the root was allocated from the arena, false if it was handed to us by the user.
+        bool rootInArena;
     };
 } // namespace json
 
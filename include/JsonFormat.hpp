@@ -0,0 +1,82 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef JSON_FORMAT_HPP
+#define JSON_FORMAT_HPP
+
+#include <cstddef>
+
+namespace json
+{
+    /**
+     * Describes how a document is written as text, see JsonDocument::writeToStream().
+     * By default every value is written on a line of its own and indented with four spaces per level.
+    */
+    struct JsonFormat
+    {
+        JsonFormat() noexcept : pretty(true), tabSize(4), decimals(-1), ensureAscii(false), threads(1)
+        {
+        }
+
+        /**
+         * Returns a format with one value per line, indented with a specific number of spaces per level.
+        */
+        static JsonFormat indented(size_t tabSize) noexcept
+        {
+            JsonFormat format;
+            format.tabSize = tabSize;
+            return format;
+        }
+
+        /**
+         * Returns a format without any whitespace, which gives the smallest output.
+        */
+        static JsonFormat compact() noexcept
+        {
+            JsonFormat format;
+            format.pretty = false;
+            format.tabSize = 0;
+            return format;
+        }
+
+        // If false no newlines, indentation or spaces after the colons are written.
+        bool pretty;
+
+        // The number of spaces per level when pretty is true.
+        size_t tabSize;
+
+        // If not negative, numbers that are not integers are written with exactly this many decimals, see JsonNumber::format().
+        // Otherwise every number is written with the shortest text that reads back as the same value.
+        int decimals;
+
+        // If true every character beyond ASCII is written as an escape sequence, see JsonString::escape().
+        bool ensureAscii;
+
+        // The number of threads writing a large document at the same time, see JsonParallelSerializer.
+        // 0 uses one thread per core, and 1 writes on the calling thread only. Small documents are always written on the calling thread.
+        size_t threads;
+    };
+} // namespace json
+
+#endif
\ No newline at end of file
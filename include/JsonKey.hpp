@@ -0,0 +1,81 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef JSON_KEY_HPP
+#define JSON_KEY_HPP
+
+#include "JsonStringView.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace json
+{
+    class JsonStringPool;
+    class JsonShape;
+
+    /**
+     * A name that is looked up in many objects, for example inside a loop over an array of objects.
+     * The hash of the name is computed once. After the first successful lookup the key also remembers
+     * the interned characters of the name and the shape and slot it was found in, so looking it up in
+     * another object with the same shape takes constant time and other objects only compare pointers.
+     * Lookups update the key even through const methods, so a key must not be used by several threads at the same time.
+     * The key keeps the pool of the last object it was found in alive.
+    */
+    class JsonKey
+    {
+    public:
+        /**
+         * Creates a key for a name, the characters are copied into the key.
+        */
+        explicit JsonKey(JsonStringView name);
+
+        /**
+         * Returns the name of the key.
+        */
+        JsonStringView view() const noexcept;
+
+        /**
+         * Returns the hash of the name, the same value as JsonStringView::hash().
+        */
+        size_t hash() const noexcept;
+
+    private:
+        friend class JsonObject;
+
+        std::string name;
+        size_t hashValue;
+
+        // The pool the name was last found interned in, and the interned characters.
+        mutable std::shared_ptr<JsonStringPool> pool;
+        mutable const char *interned;
+
+        // The shape the name was last found in, and its slot in that shape. The shape belongs to the pool.
+        mutable const JsonShape *shape;
+        mutable size_t slot;
+    };
+} // namespace json
+
+#endif
\ No newline at end of file
@@ -25,6 +25,8 @@ THE SOFTWARE.
 #ifndef JSON_LEXER_HPP
 #define JSON_LEXER_HPP
 
+#include "JsonStringView.hpp"
+
 #include <string>
 
 namespace json
@@ -58,6 +60,10 @@ namespace json
         // This field is used when we find a number or string in the JSON text.
         std::string value;
 
+        // The characters of a string or number. For a token read from a stream it refers to value,
+        // for a token read from a buffer it refers to the buffer.
+        JsonStringView text;
+
         JsonToken(JsonTokenType type);
         JsonToken(JsonTokenType type, std::string &&value);
     };
@@ -73,6 +79,19 @@ namespace json
         */
         static JsonToken nextToken(std::istream &input);
 
+        /**
+         * Reads the next token from the input stream into an existing token.
+         * The memory held by the value of the token is reused, which avoids an allocation for every string and number.
+        */
+        static void nextToken(std::istream &input, JsonToken &token);
+
+        /**
+         * Reads the next token from a buffer and moves the position past it. A string is unescaped in place,
+         * the text of the token refers to the characters in the buffer, so reading a string never copies it.
+         * The unescaped string is never longer than the escaped one, so it only overwrites its own escape sequences.
+        */
+        static void nextToken(char *&position, char *end, JsonToken &token);
+
     private:
         /**
          * Will read characters from the stream and make sure they match the desired string that was passed in with this method.
@@ -81,7 +100,12 @@ namespace json
         static void read(std::istream &input, const std::string &str);
 
         /**
-         * Will read a number from the stream and return it as a string.
+         * Will read characters from the buffer and make sure they match the desired string.
+        */
+        static void read(char *&position, char *end, const char *str);
+
+        /**
+         * Will read a number from the stream and append it to a string.
          * The number must satisfy the following ABNF rules (taken from RFC 8259):
          * 
          * number = [ minus ] int [ frac ] [ exp ]
@@ -97,25 +121,35 @@ namespace json
          * 
          * Upon violation a std::runtime_error will be thrown.
         */
-        static std::string readNumber(std::istream &input, char previous);
+        static void readNumber(std::istream &input, char previous, std::string &number);
+
+        /**
+         * Will read a number from the buffer, starting at its first character. The view refers to its characters in the buffer.
+        */
+        static void readNumber(char *&position, char *end, JsonStringView &number);
+
+        /**
+         * Will skip the digits in the buffer.
+        */
+        static void skipDigits(char *&position, char *end) noexcept;
 
         /**
-         * Will read digits from the input stream and returns them as a string.
+         * Will read digits from the input stream and append them to a string.
         */
-        static std::string readDigits(std::istream &input);
+        static void readDigits(std::istream &input, std::string &digits);
 
         /**
          * Will read a fraction.
         */
-        static std::string readFraction(std::istream &input);
+        static void readFraction(std::istream &input, std::string &fraction);
 
         /**
          * Will read an exponent.
         */
-        static std::string readExponent(std::istream &input);
+        static void readExponent(std::istream &input, std::string &exponent);
 
         /**
-         * Will read a "json-string" from the stream and return it as a string.
+         * Will read a "json-string" from the stream and append it to a string.
          * The "json-string" must satisfy the following ABNF rules (taken from RFC 8259):
          * 
          * string = quotation-mark *char quotation-mark
@@ -137,17 +171,43 @@ namespace json
          * 
          * Upon violation a std::runtime_error will be thrown.
         */
-        static std::string readString(std::istream &input);
+        static void readString(std::istream &input, std::string &string);
+
+        /**
+         * Will read a "json-string" from the buffer, after the opening quotation mark, and unescape it in place.
+        */
+        static void readString(char *&position, char *end, JsonStringView &string);
 
         /**
          * Will read an escape sequence and unescape it.
         */
-        static std::string readEscapeSequence(std::istream &input);
+        static void readEscapeSequence(std::istream &input, std::string &string);
+
+        /**
+         * Will read an escape sequence from the buffer and write the unescaped characters to output.
+         * Returns the position after the written characters.
+        */
+        static char *readEscapeSequence(char *&position, char *end, char *output);
+
+        /**
+         * Will read an unicode escape sequence for exampe \u2661. A surrogate pair such as \ud83d\ude00 becomes one character.
+        */
+        static void readUnicodeEscapeSequence(std::istream &input, std::string &string);
+
+        /**
+         * Will return the code of a low surrogate encoded as UTF-8, or -1 if it is something else.
+        */
+        static int decodeUtf8Surrogate(const std::string &utf8);
+
+        /**
+         * Will read the four hexadecimal digits of an unicode escape sequence from the buffer.
+        */
+        static int readHexCode(char *&position, char *end);
 
         /**
-         * Will read an unicode escape sequence for exampe \u2661.
+         * Will convert the code of an unicode escape sequence into UTF-8 and returns the number of characters written.
         */
-        static std::string readUnicodeEscapeSequence(std::istream &input);
+        static size_t encodeUtf8(int code, char *output);
     };
 } // namespace json
 
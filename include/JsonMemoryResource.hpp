@@ -0,0 +1,283 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef JSON_MEMORY_RESOURCE_HPP
+#define JSON_MEMORY_RESOURCE_HPP
+
+#include <cstddef>
+#include <mutex>
+
+namespace json
+{
+    /**
+     * An interface for the memory a document is built from, modeled on std::pmr::memory_resource.
+     * A JsonArena takes its chunks from a resource, so every node, container buffer and string of a document
+     * comes from the resource given when the document is created. The string pool and the parser use it as well.
+     * A resource must outlive every document, arena and pool that uses it.
+    */
+    class JsonMemoryResource
+    {
+    public:
+        virtual ~JsonMemoryResource();
+
+        /**
+         * Returns a block of memory with a specific size and alignment, the alignment must be a power of two.
+         * Throws std::bad_alloc if there is no memory.
+        */
+        void *allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+        /**
+         * Gives back a block returned by allocate() with the same size and alignment.
+        */
+        void deallocate(void *pointer, size_t bytes, size_t alignment = alignof(std::max_align_t)) noexcept;
+
+        /**
+         * Returns true if memory allocated from one resource can be deallocated by the other.
+        */
+        bool isEqual(const JsonMemoryResource &other) const noexcept;
+
+        /**
+         * Returns the resource used when no resource is given, initially getMalloc().
+        */
+        static JsonMemoryResource *getDefault() noexcept;
+
+        /**
+         * Replaces the resource used when no resource is given and returns the previous one.
+         * A nullptr restores getMalloc(). Documents that already exist keep the resource they were created with.
+        */
+        static JsonMemoryResource *setDefault(JsonMemoryResource *resource) noexcept;
+
+        /**
+         * Returns a resource that allocates with std::malloc() and std::free(). It may be used by several threads
+         * at the same time and is never destroyed, so documents in static storage can be released at exit.
+        */
+        static JsonMemoryResource *getMalloc() noexcept;
+
+    private:
+        virtual void *doAllocate(size_t bytes, size_t alignment) = 0;
+        virtual void doDeallocate(void *pointer, size_t bytes, size_t alignment) noexcept = 0;
+        virtual bool doIsEqual(const JsonMemoryResource &other) const noexcept = 0;
+    };
+
+    /**
+     * A resource that hands out memory by moving a pointer through blocks taken from an upstream resource,
+     * like std::pmr::monotonic_buffer_resource. Deallocating does nothing, all memory is given back by release()
+     * or when the resource is destroyed. It suits the memory of one request, which is thrown away as a whole.
+     * The resource is not synchronized, it must not be used by several threads at the same time.
+    */
+    class JsonMonotonicResource : public JsonMemoryResource
+    {
+    public:
+        /**
+         * Creates a new JsonMonotonicResource that takes its blocks from an upstream resource.
+        */
+        explicit JsonMonotonicResource(JsonMemoryResource *upstream = getDefault());
+
+        /**
+         * Creates a new JsonMonotonicResource where the first block taken from the upstream resource has a specific size.
+        */
+        JsonMonotonicResource(size_t initialSize, JsonMemoryResource *upstream = getDefault());
+
+        /**
+         * Creates a new JsonMonotonicResource that uses a buffer first, for example one on the stack,
+         * and then takes blocks from the upstream resource. The buffer is not owned by the resource.
+        */
+        JsonMonotonicResource(void *buffer, size_t size, JsonMemoryResource *upstream = getDefault());
+
+        /**
+         * Gives all blocks back to the upstream resource.
+        */
+        ~JsonMonotonicResource();
+
+        JsonMonotonicResource(const JsonMonotonicResource &) = delete;
+        JsonMonotonicResource &operator=(const JsonMonotonicResource &) = delete;
+
+        /**
+         * Gives all blocks back to the upstream resource, every allocation made so far becomes invalid.
+         * The buffer passed to the constructor is used again.
+        */
+        void release() noexcept;
+
+        /**
+         * Returns the resource the blocks are taken from.
+        */
+        JsonMemoryResource *getUpstream() const noexcept;
+
+    private:
+        struct Block
+        {
+            Block *previous;
+            size_t size;
+        };
+
+        void *doAllocate(size_t bytes, size_t alignment) override;
+        void doDeallocate(void *pointer, size_t bytes, size_t alignment) noexcept override;
+        bool doIsEqual(const JsonMemoryResource &other) const noexcept override;
+
+        JsonMemoryResource *upstream;
+
+        // The buffer passed to the constructor, it is used again after release().
+        char *buffer;
+        size_t bufferSize;
+
+        Block *blocks;
+        char *position;
+        char *end;
+        size_t initialSize;
+        size_t nextSize;
+    };
+
+    /**
+     * A resource that keeps blocks which have been deallocated in lists by size and hands them out again,
+     * like std::pmr::synchronized_pool_resource. The sizes are powers of two, larger blocks and blocks with
+     * a larger alignment than std::max_align_t come directly from the upstream resource and go back to it when deallocated.
+     * The memory of the lists is only given back to the upstream resource by release() or when the resource is destroyed.
+     * It suits many documents of similar sizes that are created and destroyed over and over again.
+     * The resource may be used by several threads at the same time.
+    */
+    class JsonPoolResource : public JsonMemoryResource
+    {
+    public:
+        /**
+         * Creates a new JsonPoolResource that takes its memory from an upstream resource.
+        */
+        explicit JsonPoolResource(JsonMemoryResource *upstream = getDefault());
+
+        /**
+         * Gives all memory back to the upstream resource.
+        */
+        ~JsonPoolResource();
+
+        JsonPoolResource(const JsonPoolResource &) = delete;
+        JsonPoolResource &operator=(const JsonPoolResource &) = delete;
+
+        /**
+         * Gives all memory back to the upstream resource, every block allocated so far becomes invalid.
+        */
+        void release() noexcept;
+
+        /**
+         * Returns the resource the memory is taken from.
+        */
+        JsonMemoryResource *getUpstream() const noexcept;
+
+        /**
+         * Returns the largest block that is kept in a list, larger blocks come directly from the upstream resource.
+        */
+        static size_t getMaximumBlockSize() noexcept;
+
+    private:
+        // A block in a list of free blocks.
+        struct FreeBlock
+        {
+            FreeBlock *next;
+        };
+
+        // A block taken from the upstream resource. Slabs are cut into blocks of one size,
+        // blocks that are too large for a list are single allocations.
+        struct Slab
+        {
+            Slab *previous;
+            Slab *next;
+            size_t size;
+            size_t alignment;
+        };
+
+        // The sizes are the powers of two from 16 bytes up to the maximum block size.
+        static const size_t classCount = 17;
+
+        void *doAllocate(size_t bytes, size_t alignment) override;
+        void doDeallocate(void *pointer, size_t bytes, size_t alignment) noexcept override;
+        bool doIsEqual(const JsonMemoryResource &other) const noexcept override;
+
+        // Returns the list for a size, or classCount if the block comes from the upstream resource.
+        static size_t getClass(size_t bytes, size_t alignment) noexcept;
+
+        // Takes memory from the upstream resource and records it, so that release() can give it back.
+        void *allocateSlab(size_t size, size_t alignment);
+
+        // Gives a slab back to the upstream resource before release().
+        void deallocateSlab(void *pointer, size_t alignment) noexcept;
+
+        // Returns the size of the slab header, the memory after it keeps the alignment.
+        static size_t getSlabHeaderSize(size_t alignment) noexcept;
+
+        JsonMemoryResource *upstream;
+        FreeBlock *freeBlocks[classCount];
+        Slab *slabs;
+        std::mutex mutex;
+    };
+
+    /**
+     * A standard allocator that takes its memory from a JsonMemoryResource, like std::pmr::polymorphic_allocator.
+     * It lets the containers of the library use the resource of a document.
+    */
+    template <typename T>
+    class JsonResourceAllocator
+    {
+    public:
+        typedef T value_type;
+
+        JsonResourceAllocator(JsonMemoryResource *resource = JsonMemoryResource::getDefault()) noexcept : resource(resource)
+        {
+        }
+
+        template <typename U>
+        JsonResourceAllocator(const JsonResourceAllocator<U> &other) noexcept : resource(other.getResource())
+        {
+        }
+
+        T *allocate(size_t n)
+        {
+            return static_cast<T *>(resource->allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T *pointer, size_t n) noexcept
+        {
+            resource->deallocate(pointer, n * sizeof(T), alignof(T));
+        }
+
+        JsonMemoryResource *getResource() const noexcept
+        {
+            return resource;
+        }
+
+    private:
+        JsonMemoryResource *resource;
+    };
+
+    template <typename T, typename U>
+    bool operator==(const JsonResourceAllocator<T> &lhs, const JsonResourceAllocator<U> &rhs) noexcept
+    {
+        return lhs.getResource() == rhs.getResource() || lhs.getResource()->isEqual(*rhs.getResource());
+    }
+
+    template <typename T, typename U>
+    bool operator!=(const JsonResourceAllocator<T> &lhs, const JsonResourceAllocator<U> &rhs) noexcept
+    {
+        return !(lhs == rhs);
+    }
+} // namespace json
+
+#endif
\ No newline at end of file
@@ -0,0 +1,119 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef JSON_MEMORY_USAGE_HPP
+#define JSON_MEMORY_USAGE_HPP
+
+#include <cstddef>
+
+namespace json
+{
+    /**
+     * The kinds of memory a document is made of. JsonArena keeps a running count of the bytes it hands out for each of them.
+    */
+    enum class JsonMemoryCategory : unsigned char
+    {
+        NodeHeaders,
+        ContainerStorage,
+        KeyStrings,
+        ValueStrings
+    };
+
+    /**
+     * The memory used by a document or a subtree in bytes, broken down by category.
+     * The slack is memory that has been reserved but holds nothing, such as the unused end of an arena chunk
+     * or the unused capacity of a container.
+    */
+    struct JsonMemoryUsage
+    {
+        JsonMemoryUsage() noexcept : nodeHeaders(0), containerStorage(0), keyStrings(0), valueStrings(0), slack(0)
+        {
+        }
+
+        /**
+         * Returns the number of bytes that hold nodes, containers and strings.
+        */
+        size_t getBytesUsed() const noexcept
+        {
+            return nodeHeaders + containerStorage + keyStrings + valueStrings;
+        }
+
+        /**
+         * Returns the number of bytes used plus the slack.
+        */
+        size_t getBytesReserved() const noexcept
+        {
+            return getBytesUsed() + slack;
+        }
+
+        /**
+         * Adds the bytes of a specific category.
+        */
+        void add(JsonMemoryCategory category, size_t bytes) noexcept
+        {
+            switch (category)
+            {
+            case JsonMemoryCategory::NodeHeaders:
+                nodeHeaders += bytes;
+                break;
+            case JsonMemoryCategory::ContainerStorage:
+                containerStorage += bytes;
+                break;
+            case JsonMemoryCategory::KeyStrings:
+                keyStrings += bytes;
+                break;
+            case JsonMemoryCategory::ValueStrings:
+                valueStrings += bytes;
+                break;
+            }
+        }
+
+        JsonMemoryUsage &operator+=(const JsonMemoryUsage &rhs) noexcept
+        {
+            nodeHeaders += rhs.nodeHeaders;
+            containerStorage += rhs.containerStorage;
+            keyStrings += rhs.keyStrings;
+            valueStrings += rhs.valueStrings;
+            slack += rhs.slack;
+            return *this;
+        }
+
+        // The JsonNode objects themselves.
+        size_t nodeHeaders;
+
+        // The buffers of arrays and objects, including the names and indexes of large objects.
+        size_t containerStorage;
+
+        // The characters of the names, and the tables of the string pool that interns them.
+        size_t keyStrings;
+
+        // The characters of the string values.
+        size_t valueStrings;
+
+        // Memory that is reserved but not used.
+        size_t slack;
+    };
+} // namespace json
+
+#endif
\ No newline at end of file
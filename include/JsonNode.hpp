@@ -25,14 +25,22 @@ THE SOFTWARE.
 #ifndef JSON_NODE_HPP
 #define JSON_NODE_HPP
 
+#include "JsonStringView.hpp"
+#include "JsonMemoryUsage.hpp"
+
 #include <string>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+#include <unordered_map>
 
 namespace json
 {
     /**
      * In order to identify the node type during runtime we have a list of all possible node types.
     */
-    enum class JsonNodeType
+    enum class JsonNodeType : unsigned char
     {
         Array,
         Object,
@@ -51,107 +59,138 @@ namespace json
     class JsonNumber;
     class JsonString;
 
+    class JsonArena;
+    class JsonKey;
+    class JsonVisitor;
+    class JsonDocument;
+    class JsonStringPool;
+
     /**
-     * This is an abstract base class for all different types of values that can exist in JSON text.
+     * This is the base class for all different types of values that can exist in JSON text.
+     * The type of the node is stored in the node itself instead of being found through virtual functions,
+     * so no node carries a vtable pointer. A JsonNode is only ever created as one of the derived classes.
     */
     class JsonNode
     {
     public:
         /**
-         * Creates a new JsonNode without a parent.
+         * Returns true if the node has a parent, otherwise false.
         */
-        JsonNode();
+        bool hasParent() const noexcept;
 
         /**
-         * Creates a new JsonNode with a parent.
+         * Returns a reference to the parent.
         */
-        JsonNode(JsonNode *parent);
+        JsonNode &getParent() noexcept;
 
         /**
-         * Destroys the JsonNode.
+         * Returns a const reference to the parent.
         */
-        virtual ~JsonNode();
+        const JsonNode &getParent() const noexcept;
 
         /**
-         * Returns true if the node has a parent, otherwise false.
+         * Returns the type of the node.
+         * This is always one of the derived classes: JsonArray, JsonObject, JsonBool, JsonNumber or JsonString.
         */
-        bool hasParent() const noexcept;
+        JsonNodeType getType() const noexcept;
 
         /**
-         * Returns a reference to the parent.
+         * Returns true if the node has been part of more than one version of a document, see JsonDocument::snapshot().
+         * A shared node is never modified again, even after the other versions are gone. It has to be reached again
+         * through the document, which gives the document a copy of its own.
         */
-        JsonNode &getParent() noexcept;
+        bool isShared() const noexcept;
 
         /**
-         * Returns a const reference to the parent.
+         * Returns the memory used by this node and all its descendants. Every node of the subtree is visited,
+         * use JsonDocument::memoryUsage() to get the memory of a whole document without visiting it.
+         * Names interned in a string pool belong to the pool and are not counted. The slack is the unused
+         * capacity of the containers, a subtree living in an arena does not own any part of the free space in the arena.
+         * A node shared by several containers is counted every time it is reached.
         */
-        const JsonNode &getParent() const noexcept;
+        JsonMemoryUsage memoryUsage() const;
 
         /**
-         * Returns the type of the node.
-         * This is always one of the derived classes: JsonArray, JsonObject, JsonBool, JsonNumber or JsonString.
+         * Visits this node and all its descendants in document order, see JsonVisitor.
+        */
+        void accept(JsonVisitor &visitor) const;
+
+        /**
+         * Returns true if both trees hold the same values. The members of two objects may be in different orders.
+        */
+        bool equals(const JsonNode &other) const;
+
+        /**
+         * Returns a new document holding a deep copy of this node and all its descendants.
+         * The copy has an arena and a string pool of its own.
         */
-        virtual JsonNodeType getType() const noexcept = 0;
+        JsonDocument clone() const;
+
+        /**
+         * Returns a new document holding a deep copy of this node that interns its names in a specific pool,
+         * see JsonDocument::clone().
+        */
+        JsonDocument clone(std::shared_ptr<JsonStringPool> pool) const;
 
         /**
          * Converts this object to a JsonArray reference. If that is not possible then this method will throw a runtime_error.
         */
-        virtual JsonArray &toArray();
+        JsonArray &toArray();
 
         /**
          * Converts this object to a const JsonArray reference. If that is not possible then this method will throw a runtime_error.
         */
-        virtual const JsonArray &toArray() const;
+        const JsonArray &toArray() const;
 
         /**
          * Converts this object to a JsonObject reference. If that is not possible then this method will throw a runtime_error.
         */
-        virtual JsonObject &toObject();
+        JsonObject &toObject();
 
         /**
          * Converts this object to a const JsonObject reference. If that is not possible then this method will throw a runtime_error.
         */
-        virtual const JsonObject &toObject() const;
+        const JsonObject &toObject() const;
 
         /**
          * Converts this object to a JsonBool reference. If that is not possible then this method will throw a runtime_error.
         */
-        virtual JsonBool &toBool();
+        JsonBool &toBool();
 
         /**
          * Converts this object to a const JsonBool reference. If that is not possible then this method will throw a runtime_error.
         */
-        virtual const JsonBool &toBool() const;
+        const JsonBool &toBool() const;
 
         /**
          * Converts this object to a JsonNull reference. If that is not possible then this method will throw a runtime_error.
         */
-        virtual JsonNull &toNull();
+        JsonNull &toNull();
 
         /**
          * Converts this object to a const JsonNull reference. If that is not possible then this method will throw a runtime_error.
         */
-        virtual const JsonNull &toNull() const;
+        const JsonNull &toNull() const;
 
         /**
          * Converts this object to a JsonNumber reference. If that is not possible then this method will throw a runtime_error.
         */
-        virtual JsonNumber &toNumber();
+        JsonNumber &toNumber();
 
         /**
          * Converts this object to a const JsonNumber reference. If that is not possible then this method will throw a runtime_error.
         */
-        virtual const JsonNumber &toNumber() const;
+        const JsonNumber &toNumber() const;
 
         /**
          * Converts this object to a JsonString reference. If that is not possible then this method will throw a runtime_error.
         */
-        virtual JsonString &toString();
+        JsonString &toString();
 
         /**
          * Converts this object to a const JsonString reference. If that is not possible then this method will throw a runtime_error.
         */
-        virtual const JsonString &toString() const;
+        const JsonString &toString() const;
 
         /**
          * Implicit conversion to a JsonArray reference if this fails then a runtime_error will be thrown. 
@@ -216,27 +255,175 @@ namespace json
         /**
          * Returns a child at a specific index. This only works if the object is of type JsonArray. 
         */
-        virtual JsonNode &operator[](size_t);
+        JsonNode &operator[](size_t);
 
         /**
          * Returns an immutable child at a specific index. This only works if the object is of type JsonArray. 
         */
-        virtual const JsonNode &operator[](size_t) const;
+        const JsonNode &operator[](size_t) const;
 
         /**
          * Returns a child with a specific name. This only works if the object is of type JsonObject. 
+         * The name is not copied, so a string literal can be passed without allocating memory.
         */
-        virtual JsonNode &operator[](const std::string &);
+        JsonNode &operator[](JsonStringView);
 
         /**
          * Returns an immutable child with a specific name. This only works if the object is of type JsonObject. 
+         * The name is not copied, so a string literal can be passed without allocating memory.
+        */
+        const JsonNode &operator[](JsonStringView) const;
+
+        /**
+         * Returns a child with the name of a key. This only works if the object is of type JsonObject. 
+        */
+        JsonNode &operator[](const JsonKey &);
+
+        /**
+         * Returns an immutable child with the name of a key. This only works if the object is of type JsonObject. 
+        */
+        const JsonNode &operator[](const JsonKey &) const;
+
+    protected:
+        /**
+         * Creates a new JsonNode of a specific type without a parent.
         */
-        virtual const JsonNode &operator[](const std::string &) const;
+        JsonNode(JsonNodeType type);
+
+        /**
+         * Creates a new JsonNode of a specific type with a parent.
+        */
+        JsonNode(JsonNode *parent, JsonNodeType type);
+
+        /**
+         * Destroys the JsonNode. The destructor is not virtual, use destroy() to delete a node through a base pointer.
+        */
+        ~JsonNode();
+
+        /**
+         * Releases a reference to a node of any type, the node is destroyed together with the last reference.
+         * Nodes living in an arena are not destroyed individually, their memory is released together with the arena.
+        */
+        static void destroy(JsonArena *arena, JsonNode *node) noexcept;
+
+        /**
+         * Changes the parent of a node, this is used when a subtree is moved to another container.
+        */
+        static void setParent(JsonNode *node, JsonNode *parent) noexcept;
+
+        /**
+         * Adds a reference to a node that is going to be held by one more container.
+        */
+        static JsonNode *share(JsonNode *node) noexcept;
+
+        /**
+         * Copies a node into an arena (or onto the heap if the arena is nullptr). The children of a container
+         * are shared with the copy, except when a container allocated with new is copied into an arena,
+         * then its children are copied as well.
+        */
+        static JsonNode *copy(JsonArena *arena, JsonNode *parent, const JsonNode &node);
+
+        /**
+         * Returns a child that the parent may modify. A shared child is replaced by a copy in the arena of the parent.
+        */
+        static JsonNode &unshare(JsonArena *arena, JsonNode *parent, JsonNode *&child);
+
+        /**
+         * Throws a runtime_error if the node or a container above it is shared, this is called before a node is modified.
+         * The containers above the node are only visited again after a snapshot has been taken.
+        */
+        void checkWritable() const;
 
     private:
+        friend struct JsonNodeDeleter;
+        friend class JsonDocument;
+        friend class JsonReclaimer;
+
+        // Releases a reference to a node and returns true if it was the last one.
+        static bool release(JsonNode *node) noexcept;
+
+        // Deletes up to limit nodes allocated with new. The nodes are a list linked through their parent pointers
+        // and their last reference has been released. Returns the nodes that are left.
+        static JsonNode *destroyPending(JsonNode *node, size_t limit) noexcept;
+
+        // Copies a node and all its descendants into an arena without recursion.
+        static JsonNode *copyTree(JsonArena *arena, JsonNode *parent, const JsonNode &node);
+
+        // Maps every node that is equal to a node found earlier to that node, which maps to itself.
+        typedef std::unordered_map<const JsonNode *, const JsonNode *> DuplicateMap;
+
+        // Adds the memory of a node, but not of its children, see memoryUsage().
+        static void addNodeMemoryUsage(const JsonNode &node, JsonMemoryUsage &usage) noexcept;
+
+        // Finds the subtrees that are equal to a subtree found earlier, visiting the tree bottom-up without recursion.
+        // Returns the memory the tree uses when each of them is stored only once.
+        static JsonMemoryUsage findDuplicates(const JsonNode &node, DuplicateMap &duplicates);
+
+        // Copies a node and all its descendants into an arena so that the children of a container are allocated
+        // next to each other, together with their strings. The containers are filled in depth-first order.
+        // A node that is reached several times, or that is in duplicates, is copied once and shared.
+        static JsonNode *relayout(JsonArena *arena, const JsonNode &node, const DuplicateMap *duplicates);
+
+        // Starts a new epoch, so checkWritable() visits the containers above a node again.
+        // This is called when nodes the user may hold references to become shared.
+        static void beginEpoch() noexcept;
+
         JsonNode *parent;
+        JsonNodeType type;
+
+        // The epoch in which no container above this node was shared, a node starts with the epoch of its parent.
+        mutable uint16_t checkedEpoch;
+
+        // The number of containers and documents holding this node. The highest bit is set once the node is shared.
+        std::atomic<uint32_t> references;
+
+        static const uint32_t sharedBit = 0x80000000u;
+
+        // The current epoch. It stops at the largest value, after which the containers above a node are always visited.
+        static std::atomic<uint16_t> epoch;
+        static const uint16_t lastEpoch = 0xFFFF;
+    };
+
+    /**
+     * A deleter for nodes allocated with new, it calls the destructor of the derived class.
+    */
+    struct JsonNodeDeleter
+    {
+        void operator()(JsonNode *node) const noexcept;
     };
 
 } // namespace json
 
+namespace std
+{
+    /**
+     * Nodes have no virtual destructor, so a std::unique_ptr<JsonNode> destroys its node through JsonNodeDeleter,
+     * which calls the destructor of the derived class.
+    */
+    template <>
+    struct default_delete<json::JsonNode>
+    {
+        default_delete() noexcept = default;
+
+        template <typename T, typename = typename enable_if<is_convertible<T *, json::JsonNode *>::value>::type>
+        default_delete(const default_delete<T> &) noexcept
+        {
+        }
+
+        void operator()(json::JsonNode *node) const noexcept
+        {
+            json::JsonNodeDeleter()(node);
+        }
+    };
+} // namespace std
+
+namespace json
+{
+    /**
+     * A unique_ptr that owns a node allocated with new.
+    */
+    typedef std::unique_ptr<JsonNode> JsonNodePtr;
+
+} // namespace json
+
 #endif
\ No newline at end of file
@@ -44,21 +44,6 @@ namespace json
          * Creates a new JsonNull with a parent.
         */
         JsonNull(JsonNode *parent);
-
-        /**
-         * Returns JsonNodeType::Null.
-        */
-        JsonNodeType getType() const noexcept override;
-
-        /**
-         * Returns a reference to this JsonNull.
-        */
-        JsonNull &toNull() override;
-
-        /**
-         * Returns a const reference to this JsonNull.
-        */
-        const JsonNull &toNull() const override;
     };
 } // namespace json
 
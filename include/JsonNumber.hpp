@@ -26,11 +26,17 @@ THE SOFTWARE.
 #define JSON_NUMBER_HPP
 
 #include "JsonNode.hpp"
+#include "JsonString.hpp"
+
+#include <atomic>
+#include <cstdint>
 
 namespace json
 {
     /**
      * Represents a node that can store a decimal value.
+     * A number read by the parser keeps the text it was written with and is only converted to a double when its value
+     * is first read. The text is written unchanged when the document is serialized, until the number is modified.
     */
     class JsonNumber : public JsonNode
     {
@@ -46,32 +52,107 @@ namespace json
         JsonNumber(JsonNode *parent, double value);
 
         /**
-         * Returns JsonNodeType::Number.
+         * Creates a new JsonNumber with a parent from the text of a number, which must be valid JSON.
+         * The text is copied into the arena or refers to characters that live as long as the arena.
+         * If the arena is nullptr the number keeps a copy of the text of its own.
         */
-        JsonNodeType getType() const noexcept override;
+        JsonNumber(JsonNode *parent, JsonArena *arena, JsonStringView text, JsonStringStorage storage);
 
         /**
-         * Returns a reference to this JsonNumber.
+         * Destroys the JsonNumber and the copy of its text, if it has one.
         */
-        JsonNumber &toNumber() override;
+        ~JsonNumber();
 
         /**
-         * Returns a const reference to this JsonNumber.
+         * Replaces the value this JsonNumber is storing, the text of a parsed number is no longer used.
+         * Throws a std::runtime_error if the node is shared with a snapshot, see JsonNode::isShared().
         */
-        const JsonNumber &toNumber() const override;
+        JsonNumber &operator=(double value);
 
         /**
          * Returns a reference to the double value this JsonNumber is storing.
+         * The value may be changed through the reference, so the text of a parsed number is no longer used,
+         * and a std::runtime_error is thrown if the node is shared with a snapshot.
         */
-        double &data() noexcept;
+        double &data();
 
         /**
          * Returns a const reference to the double value this JsonNumber is storing.
+         * A number too large for a double is infinity.
         */
         const double &data() const noexcept;
 
+        /**
+         * Returns true if the number still has the text it was parsed from.
+        */
+        bool hasText() const noexcept;
+
+        /**
+         * Returns the text the number was parsed from, or an empty view if it has no text.
+        */
+        JsonStringView getText() const noexcept;
+
+        /**
+         * Returns true if the value is an integer. The text of a parsed number must not have a fraction or an exponent.
+        */
+        bool isInteger() const noexcept;
+
+        /**
+         * Returns the value as an integer. The text of a parsed integer is converted exactly, even beyond
+         * the 53 bits a double can hold. Throws a std::runtime_error if the value is not an integer or does not fit.
+        */
+        int64_t getInteger() const;
+
+        /**
+         * Converts the text of a number, which must be valid JSON, to a double. A number too large for a double is infinity.
+        */
+        static double parse(JsonStringView text);
+
+        /**
+         * Writes the shortest text that parse() reads back as exactly the same value, and returns the end of the text.
+         * Integers below 2^64 are written with all their digits, very large and very small values with an exponent.
+         * Infinity and NaN have no JSON text, they are written as null here, while JsonDocument and JsonWriter throw a
+         * std::runtime_error instead of writing them. The output must have room for maximumFormatSize characters.
+        */
+        static char *format(double value, char *output) noexcept;
+
+        /**
+         * Writes a value with a specific number of decimals, at most maximumDecimals, and returns the end of the text.
+         * The shortest text of the value is rounded half up, so 1.005 with two decimals is 1.01, and a value that rounds
+         * to zero is written without a minus sign.
+         * Values of 1e21 and above are written as with format(double, char *).
+        */
+        static char *format(double value, int decimals, char *output) noexcept;
+
+        /**
+         * Writes every digit of an integer, and returns the end of the text. The output must have room for 20 characters.
+        */
+        static char *formatInteger(int64_t value, char *output) noexcept;
+
+        /**
+         * Writes every digit of an unsigned integer, and returns the end of the text. The output must have room for 20 characters.
+        */
+        static char *formatInteger(uint64_t value, char *output) noexcept;
+
+        /**
+         * Returns true if format() writes exactly the given text for a value, so the value can be stored without its text,
+         * as in a packed JsonArray, and still be written the way it was read.
+        */
+        static bool formatsAs(double value, JsonStringView text) noexcept;
+
+        /**
+         * The largest number of characters format() writes.
+        */
+        static const size_t maximumFormatSize = 48;
+
+        /**
+         * The largest number of decimals format() writes.
+        */
+        static const int maximumDecimals = 20;
+
         /**
          * Implicit conversion to a double reference.
+         * The value may be changed through the reference, so the text of a parsed number is no longer used.
         */
         operator double &();
 
@@ -81,7 +162,49 @@ namespace json
         operator const double &() const;
 
     private:
-        double value;
+        friend class JsonNode;
+        friend class JsonArray;
+
+        // Selects the constructor used by a packed JsonArray.
+        struct ExternalSlot
+        {
+        };
+
+        // Creates a JsonNumber that refers to a value in the buffer of a packed JsonArray.
+        JsonNumber(JsonNode *parent, double *slot, ExternalSlot) noexcept;
+
+        // Returns a copy of this number that keeps its text, see JsonNode::copy().
+        JsonNumber *copy(JsonArena *target, JsonNode *parent) const;
+
+        // Converts the text to a double the first time the value is read.
+        void decode() const noexcept;
+
+        // What value holds for a number with text. Several threads may read a number that is not decoded yet,
+        // the one that gets to decode it marks it with Decoding and the others wait for it.
+        enum State : unsigned char
+        {
+            Decoded,
+            Encoded,
+            Decoding
+        };
+
+        // True if the value is stored in the buffer of a packed JsonArray.
+        bool external;
+
+        mutable std::atomic<unsigned char> state;
+
+        // True if the text was allocated with new for a number without an arena.
+        bool ownsText;
+
+        // The text of a parsed number, textSize is zero if the number has no text.
+        uint32_t textSize;
+        const char *text;
+
+        union
+        {
+            mutable double value;
+            double *slot;
+        };
     };
 } // namespace json
 
@@ -26,29 +26,28 @@ THE SOFTWARE.
 #define JSON_OBJECT_HPP
 
 #include "JsonNode.hpp"
+#include "JsonArena.hpp"
+#include "JsonStringView.hpp"
+#include "JsonSmallVector.hpp"
+#include "JsonShape.hpp"
+#include "JsonKey.hpp"
 
+#include <cstdint>
 #include <unordered_map>
-#include <memory>
 #include <vector>
 
 namespace json
 {
+    class JsonDocument;
+
+    class JsonStringPool;
+
     /**
      * Represents a node that holds a collection of child nodes. Every child is associated with a name.
     */
     class JsonObject : public JsonNode
     {
     public:
-        struct Value
-        {
-            // The child node.
-            std::unique_ptr<JsonNode> node;
-
-            // An index indicating when this node was added.
-            // We need this if we want to be able to sort based on insertion order.
-            size_t orderIndex;
-        };
-
         /**
          * An iterator that lets the user iterate over all children.
          * The main purpose of this class is to make sure 
@@ -58,12 +57,12 @@ namespace json
         {
         public:
             /**
-             * Creates a new iterator object.
+             * Creates a new iterator object referring to the child at a specific position.
             */
-            iterator(std::unordered_map<std::string, Value>::iterator it);
+            iterator(JsonObject *object, size_t index);
 
             /**
-             * The prefix operator will return an iterator object referring to the next pair in the map.
+             * The prefix operator will return an iterator object referring to the next pair.
             */
             iterator operator++();
 
@@ -85,10 +84,11 @@ namespace json
             /**
              * Returns the pair that the iterator object is referring to.
             */
-            std::pair<const std::string &, JsonNode &> operator*();
+            std::pair<JsonStringView, JsonNode &> operator*();
 
         private:
-            std::unordered_map<std::string, Value>::iterator it;
+            JsonObject *object;
+            size_t index;
         };
 
         /**
@@ -100,12 +100,12 @@ namespace json
         {
         public:
             /**
-             * Creates a new const_iterator object.
+             * Creates a new const_iterator object referring to the child at a specific position.
             */
-            const_iterator(std::unordered_map<std::string, Value>::const_iterator it);
+            const_iterator(const JsonObject *object, size_t index);
 
             /**
-             * The prefix operator will return a const_iterator object referring to the next pair in the map.
+             * The prefix operator will return a const_iterator object referring to the next pair.
             */
             const_iterator operator++();
 
@@ -127,10 +127,11 @@ namespace json
             /**
              * Returns the pair that the const_iterator object is referring to.
             */
-            std::pair<const std::string &, const JsonNode &> operator*() const;
+            std::pair<JsonStringView, const JsonNode &> operator*() const;
 
         private:
-            std::unordered_map<std::string, Value>::const_iterator it;
+            const JsonObject *object;
+            size_t index;
         };
 
         /**
@@ -144,31 +145,39 @@ namespace json
         JsonObject(JsonNode *parent);
 
         /**
-         * Returns JsonNodeType::Object.
+         * Creates a new JsonObject with a parent. All children and names will be allocated from the arena.
+         * If the arena is nullptr they are allocated with new.
         */
-        JsonNodeType getType() const noexcept override;
+        JsonObject(JsonNode *parent, JsonArena *arena);
 
         /**
-         * Returns a reference to this JsonObject.
+         * Destroys the JsonObject and all its children.
         */
-        JsonObject &toObject() override;
+        ~JsonObject();
 
         /**
-         * Returns a const reference to this JsonObject.
+         * Returns the child node with a specific name.
+         * If no child has the specified name then an error will be thrown.
         */
-        const JsonObject &toObject() const override;
+        JsonNode &operator[](JsonStringView name);
 
         /**
-         * Returns the child node with a specific name.
+         * Returns the immutable child node with a specific name.
          * If no child has the specified name then an error will be thrown.
         */
-        JsonNode &operator[](const std::string &name) override;
+        const JsonNode &operator[](JsonStringView name) const;
 
         /**
-         * Returns the immutable child node with a specific name.
+         * Returns the child node with the name of a key.
          * If no child has the specified name then an error will be thrown.
         */
-        const JsonNode &operator[](const std::string &name) const override;
+        JsonNode &operator[](const JsonKey &key);
+
+        /**
+         * Returns the immutable child node with the name of a key.
+         * If no child has the specified name then an error will be thrown.
+        */
+        const JsonNode &operator[](const JsonKey &key) const;
 
         /**
          * Will set a new JsonArray object with a specific name.
@@ -267,89 +276,218 @@ namespace json
         /**
          * Returns true if a child in this JsonObject is associated with the specified name.
         */
-        bool hasChild(const std::string &name) const noexcept;
+        bool hasChild(JsonStringView name) const noexcept;
+
+        /**
+         * Returns true if a child in this JsonObject is associated with the name of a key.
+        */
+        bool hasChild(const JsonKey &key) const noexcept;
 
         /**
          * Returns the child node with a specific name.
          * If no child has the specified name then an error will be thrown.
          * This method is equivalent to the subscript operator.
         */
-        JsonNode &getChild(const std::string &name);
+        JsonNode &getChild(JsonStringView name);
 
         /**
          * Returns the immutable child node with a specific name.
          * If no child has the specified name then an error will be thrown.
          * This method is equivalent to the subscript operator.
         */
-        const JsonNode &getChild(const std::string &name) const;
+        const JsonNode &getChild(JsonStringView name) const;
+
+        /**
+         * Returns the child node with the name of a key.
+         * If no child has the specified name then an error will be thrown.
+         * This method is equivalent to the subscript operator.
+        */
+        JsonNode &getChild(const JsonKey &key);
+
+        /**
+         * Returns the immutable child node with the name of a key.
+         * If no child has the specified name then an error will be thrown.
+         * This method is equivalent to the subscript operator.
+        */
+        const JsonNode &getChild(const JsonKey &key) const;
+
+        /**
+         * Returns the child at a specific position, the children are numbered in insertion order.
+         * If the index is out of bounds then an error will be thrown.
+        */
+        JsonNode &getChildAt(size_t index);
+
+        /**
+         * Returns the immutable child at a specific position, the children are numbered in insertion order.
+         * If the index is out of bounds then an error will be thrown.
+        */
+        const JsonNode &getChildAt(size_t index) const;
+
+        /**
+         * Returns the name of the child at a specific position.
+         * If the index is out of bounds then an error will be thrown.
+        */
+        JsonStringView getNameAt(size_t index) const;
+
+        /**
+         * Returns the shape shared by all objects with the same names, or nullptr if this object stores its own names.
+         * A loop over many objects can remember the shape and the slot of a name found with JsonShape::find(),
+         * and use getChildAt() directly for every object with the same shape.
+        */
+        const JsonShape *getShape() const noexcept;
 
         /**
          * Removes a child node with a specific name. 
+         * An object that shares its shape with other objects will store its own names after a removal.
+        */
+        void removeChild(JsonStringView name);
+
+        /**
+         * Makes room for a specific number of children, so that adding them does not have to grow the storage
+         * or rebuild the index again.
+        */
+        void reserve(size_t capacity);
+
+        /**
+         * Removes the child with a specific name and returns a JsonDocument that owns it. No nodes are copied.
+         * If the object lives in an arena the returned document keeps that arena alive, the whole arena and not only the
+         * memory of the subtree, until the document and every container the subtree is attached to are gone.
+         * Throws std::out_of_range if there is no child with that name.
         */
-        void removeChild(const std::string &name);
+        JsonDocument detach(const std::string &name);
+
+        /**
+         * Moves the root of the document into this object under a specific name and returns a reference to it.
+         * A child with the same name is replaced. No nodes are copied, the document is empty afterwards.
+         * The arena of this object keeps the arena of the subtree alive, unless that arena already keeps this one alive,
+         * for example after subtrees were moved in the other direction. Then the subtree is copied into the arena of
+         * this object, so the two arenas do not keep each other alive forever.
+        */
+        JsonNode &attach(const std::string &name, JsonDocument &&subtree);
+
+        /**
+         * Moves a child of another object (or of this object) into this object under a specific name.
+         * Throws std::out_of_range if the source has no child with that name.
+        */
+        JsonNode &splice(const std::string &name, JsonObject &source, const std::string &sourceName);
 
         /**
          * Returns an iterator referring to the beginning.
          * The begin() and end() methods are needed for the range-based for loop.
-         * Note that the iterator will iterate through the pairs in seemingly random order.
-         * Consider the sort() method if you would like to iterate through the pairs based on the insertion order.
+         * The pairs are visited in insertion order.
         */
         iterator begin();
 
         /**
          * Returns an iterator referring to the end.
          * The begin() and end() methods are needed for the range-based for loop.
-         * Note that the iterator will iterate through the pairs in seemingly random order.
-         * Consider the sort() method if you would like to iterate through the pairs based on the insertion order.
+         * The pairs are visited in insertion order.
         */
         iterator end();
 
         /**
          * Returns a const_iterator referring to the beginning.
          * The begin() and end() methods are needed for the range-based for loop.
-         * Note that the iterator will iterate through the pairs in seemingly random order.
-         * Consider the sort() method if you would like to iterate through the pairs based on the insertion order.
+         * The pairs are visited in insertion order.
         */
         const_iterator begin() const;
 
         /**
          * Returns a const_iterator referring to the end.
          * The begin() and end() methods are needed for the range-based for loop.
-         * Note that the iterator will iterate through the pairs in seemingly random order.
-         * Consider the sort() method if you would like to iterate through the pairs based on the insertion order.
+         * The pairs are visited in insertion order.
         */
         const_iterator end() const;
 
         /**
-         * Will move the pairs into a vector and sort the vector based on the insertion order of each pair.
-         * The vector is then returned.
+         * Returns a vector of the pairs in insertion order.
+         * The pairs are stored in insertion order, so iterating over the object directly is cheaper.
         */
-        std::vector<std::pair<const std::string &, JsonNode &>> sort();
+        std::vector<std::pair<JsonStringView, JsonNode &>> sort();
 
         /**
-         * Will move the pairs into a vector and sort the vector based on the insertion order of each pair.
-         * The vector is then returned.
+         * Returns a vector of the pairs in insertion order.
+         * The pairs are stored in insertion order, so iterating over the object directly is cheaper.
         */
-        std::vector<std::pair<const std::string &, const JsonNode &>> sort() const;
+        std::vector<std::pair<JsonStringView, const JsonNode &>> sort() const;
 
     private:
-        // In order to keep track of the insertion order we have a counter
-        // that is incremented every time we add a new child.
-        size_t childCounter;
-        std::unordered_map<std::string, Value> children;
+        friend class JsonNode;
+        friend class JsonParser;
+
+        // The names of an object that does not use a shape.
+        struct Dictionary
+        {
+            Dictionary() noexcept : index(nullptr), indexCapacity(0)
+            {
+            }
+
+            JsonSmallVector<JsonStringView, 4> names;
+
+            // An open addressing table of slot + 1 for every name, zero marks an empty entry.
+            // It is only created when there are too many names for a linear search, otherwise it is nullptr.
+            uint32_t *index;
+            size_t indexCapacity;
+        };
+
+        JsonArena *arena;
+
+        // When the arena has a string pool the names are stored once in a shape shared with other objects.
+        // Otherwise, or after a removal or when the object grows too large, shape is nullptr and the names live in the dictionary.
+        const JsonShape *shape;
+        Dictionary *dictionary;
+
+        // The children in insertion order, values[i] belongs to the i-th name.
+        JsonSmallVector<JsonNode *, 4> values;
+
+        // Private helper method that can be used to set a new child.
+        template <typename ChildType, typename... Args>
+        ChildType &setChild(JsonStringView name, Args &&... args);
+
+        // Puts a node under a specific name, replacing the old child with that name.
+        // The node is not destroyed if this fails.
+        void insertChild(JsonStringView name, JsonNode *child);
+
+        // Removes the child in a specific slot together with its name and returns it.
+        JsonNode *takeChild(size_t slot);
+
+        // Returns the child in a specific slot for a caller that may modify it, see JsonNode::unshare().
+        JsonNode &writableChild(size_t slot);
+
+        // Returns a copy of this object that shares the children, see JsonNode::copy().
+        JsonObject *copy(JsonArena *target, JsonNode *parent) const;
+
+        // The shapes of one pool translated to the shapes with the same names in another pool.
+        typedef std::unordered_map<const JsonShape *, const JsonShape *> ShapeMap;
+
+        // Gives this empty object the names of another object. If shapes is not nullptr it remembers
+        // the shapes that have been translated, so objects with the same names are only translated once.
+        void copyNames(const JsonObject &source, ShapeMap *shapes);
+
+        // Adds the memory of the names and buffers of this object, but not of its children, see JsonNode::memoryUsage().
+        void addMemoryUsage(JsonMemoryUsage &usage) const noexcept;
+
+        // Returns the slot of a name, or the number of children if there is no such child.
+        // Interned names are compared by pointer only.
+        size_t findSlot(JsonStringView name, bool interned) const noexcept;
+
+        // Returns the slot of the name of a key and remembers what was found in the key.
+        size_t findSlot(const JsonKey &key) const noexcept;
+
+        // Looks up a name with a specific hash in the index of the dictionary.
+        size_t findInIndex(JsonStringView name, size_t hash, bool interned) const noexcept;
 
-        // Private helper methods that can be used to set a new child.
-        template <typename ChildType>
-        ChildType &setChild(const std::string &name);
+        // Appends a name that is not in the object yet.
+        void addName(JsonStringView name, JsonStringPool *pool);
 
-        template <typename ChildType>
-        ChildType &setChild(std::string &&name);
+        // Moves the names from the shape into a dictionary owned by this object.
+        void createDictionary();
 
-        template <typename ChildType, typename ArgType>
-        ChildType &setChild(const std::string &name, ArgType arg);
+        // Replaces the index of the dictionary with a new index with a specific capacity, which must be a power of two.
+        void createIndex(size_t capacity);
 
-        template <typename ChildType, typename ArgType>
-        ChildType &setChild(std::string &&name, ArgType arg);
+        // Adds the name in a specific slot to the index.
+        void addToIndex(size_t slot) noexcept;
     };
 } // namespace json
 
@@ -0,0 +1,155 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef JSON_OUTPUT_BUFFER_HPP
+#define JSON_OUTPUT_BUFFER_HPP
+
+#include "JsonStringView.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+namespace json
+{
+    /**
+     * A contiguous buffer that JSON text is written into before it reaches its destination.
+     * Writing to a std::string appends to it directly, growing it as needed and reusing the capacity it already has.
+     * Writing to a std::ostream collects the text in a block of a fixed size, which is handed to the stream
+     * with a single write() whenever it is full, so the stream is not called once per token.
+    */
+    class JsonOutputBuffer
+    {
+    public:
+        /**
+         * Creates a new JsonOutputBuffer that appends to a string. The string must not be used until flush() is called.
+        */
+        explicit JsonOutputBuffer(std::string &output);
+
+        /**
+         * Creates a new JsonOutputBuffer that writes to a stream in blocks of a specific size.
+        */
+        explicit JsonOutputBuffer(std::ostream &output, size_t blockSize = 64 * 1024);
+
+        /**
+         * Flushes the text that has not been written yet.
+        */
+        ~JsonOutputBuffer();
+
+        JsonOutputBuffer(const JsonOutputBuffer &) = delete;
+        JsonOutputBuffer &operator=(const JsonOutputBuffer &) = delete;
+
+        /**
+         * Writes a character.
+        */
+        void write(char c)
+        {
+            if (position == end)
+                makeRoom(1);
+            *position++ = c;
+        }
+
+        /**
+         * Writes a specific number of characters.
+        */
+        void write(const char *data, size_t size)
+        {
+            if (size > static_cast<size_t>(end - position))
+            {
+                writeSlow(data, size);
+                return;
+            }
+            if (size == 0)
+                return;
+            std::memcpy(position, data, size);
+            position += size;
+        }
+
+        /**
+         * Writes the characters of a view.
+        */
+        void write(JsonStringView str)
+        {
+            write(str.data(), str.size());
+        }
+
+        /**
+         * Returns a pointer where at least a specific number of characters can be written.
+         * The characters are added by passing the end of what was written to commit().
+        */
+        char *reserve(size_t size)
+        {
+            if (size > static_cast<size_t>(end - position))
+                makeRoom(size);
+            return position;
+        }
+
+        /**
+         * Adds the characters written after a pointer returned by reserve(), up to the given end.
+        */
+        void commit(char *last) noexcept
+        {
+            position = last;
+        }
+
+        /**
+         * Hands everything written so far to the string or the stream.
+        */
+        void flush();
+
+        /**
+         * Returns the number of characters written so far.
+        */
+        size_t size() const noexcept;
+
+    private:
+        // Makes sure that the buffer has room for a specific number of characters.
+        void makeRoom(size_t size);
+
+        // Writes characters that do not fit in the remaining room.
+        void writeSlow(const char *data, size_t size);
+
+        // Hands a full block to the stream.
+        void flushBlock();
+
+        // Exactly one of them is set.
+        std::string *string;
+        std::ostream *stream;
+
+        // The block collecting the text for the stream.
+        std::string block;
+        size_t blockSize;
+
+        // The part of the string or the block that is being written.
+        char *begin;
+        char *position;
+        char *end;
+
+        // The characters written before begin.
+        size_t written;
+    };
+} // namespace json
+
+#endif
\ No newline at end of file
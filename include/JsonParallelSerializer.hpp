@@ -0,0 +1,87 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef JSON_PARALLEL_SERIALIZER_HPP
+#define JSON_PARALLEL_SERIALIZER_HPP
+
+#include "JsonFormat.hpp"
+#include "JsonOutputBuffer.hpp"
+
+#include <string>
+#include <vector>
+
+namespace json
+{
+    class JsonNode;
+
+    /**
+     * Writes a tree with several threads at the same time. The array or object at the top of the tree is split into chunks
+     * of consecutive children, which are written into buffers of their own by a number of threads, see JsonFormat::threads.
+     * The chunks are handed to the output in order as soon as they are done, so the text is exactly the text of JsonSerializer.
+     * If the top of the tree is a container with a single array or object in it, that container is split instead.
+     * This is what JsonDocument::writeToStream() and JsonDocument::toString() use. The tree must not be changed while it is written.
+    */
+    class JsonParallelSerializer
+    {
+    public:
+        /**
+         * Creates a new JsonParallelSerializer that writes into a buffer with a specific format.
+        */
+        JsonParallelSerializer(JsonOutputBuffer &output, const JsonFormat &format);
+
+        /**
+         * Writes a node and everything below it. With one thread, when there is nothing to split, or when the container that
+         * would be split holds fewer than 16384 nodes, it is written by a JsonSerializer on the calling thread.
+        */
+        void write(const JsonNode &node);
+
+    private:
+        // The text of the children first to last - 1 of the container that is split.
+        struct Chunk
+        {
+            size_t first;
+            size_t last;
+            std::string text;
+            bool done;
+        };
+
+        // Writes the children of a container on several threads and hands the chunks to the output in order.
+        void writeChunks(const JsonNode &container, size_t depth, size_t threads);
+
+        // Writes the bracket that starts a container with children, and the newline after it.
+        void open(const JsonNode &container);
+
+        // Writes the bracket that ends a container.
+        void close(const JsonNode &container);
+
+        // Writes the spaces in front of a line, nothing in compact mode.
+        void indent(size_t depth);
+
+        JsonOutputBuffer &output;
+        JsonFormat format;
+        std::string spaces;
+    };
+} // namespace json
+
+#endif
\ No newline at end of file
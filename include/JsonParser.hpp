@@ -27,8 +27,10 @@ THE SOFTWARE.
 
 #include "JsonNode.hpp"
 #include "JsonLexer.hpp"
+#include "JsonString.hpp"
 
 #include <memory>
+#include <vector>
 
 namespace json
 {
@@ -41,28 +43,122 @@ namespace json
         /**
          * Will parse the JSON text and return the root node.
         */
-        static std::unique_ptr<JsonNode> parse(std::istream &input);
+        static JsonNodePtr parse(std::istream &input);
+
+        /**
+         * Will parse the JSON text and return the root node. Every node is allocated from the arena.
+         * Returns nullptr if the JSON text is empty.
+        */
+        static JsonNode *parse(std::istream &input, JsonArena &arena);
+
+        /**
+         * Will parse the JSON text in a buffer in place and return the root node. Every node is allocated from the arena.
+         * The strings are unescaped inside the buffer and refer to it, so the buffer must live as long as the arena.
+         * Returns nullptr if the JSON text is empty.
+        */
+        static JsonNode *parse(char *buffer, size_t size, JsonArena &arena);
 
     private:
         /**
-         * Recursive method that parses a JsonArray and all its child nodes.
+         * A container that is being parsed, with the positions of its first pending child and name.
+        */
+        struct Frame
+        {
+            JsonNode *container;
+            size_t first;
+            size_t firstName;
+        };
+
+        /**
+         * The state of the parser while parsing one JSON text.
+         * The token and the name buffers are reused so that reading strings does not allocate for every value.
+         * The number texts collect the leading numbers of the array being parsed, the numbers buffer holds their values
+         * if the array is stored packed.
+         * The children of the containers being parsed are kept on a stack until the end of the container,
+         * then the container takes all of them at once with its storage sized exactly.
+        */
+        struct Context
+        {
+            Context(std::istream *input, char *position, char *end, JsonArena *arena, JsonStringStorage storage);
+
+            // The text is read from the stream, or from the buffer between position and end if input is nullptr.
+            std::istream *input;
+            char *position;
+            char *end;
+
+            JsonArena *arena;
+            JsonStringStorage storage;
+            JsonToken current;
+            std::vector<double> numbers;
+
+            // The texts of numbers read from a stream are copied to the scratch string, one after another.
+            std::vector<JsonStringView> numberTexts;
+            std::string numberScratch;
+            std::vector<JsonNode *> children;
+
+            // The names of the pending object members, only the first nameCount are in use.
+            // Names read from a buffer are not copied, they are kept in borrowedNames instead.
+            std::vector<std::string> names;
+            std::vector<JsonStringView> borrowedNames;
+            size_t nameCount;
+
+            // The containers from the root down to the one being parsed.
+            std::vector<Frame> frames;
+        };
+
+        /**
+         * Parses the root value. If the arena is nullptr the nodes are allocated with new.
+        */
+        static JsonNode *parseRoot(Context &context);
+
+        /**
+         * Reads the next token from the stream or the buffer into the current token.
+        */
+        static void nextToken(Context &context);
+
+        /**
+         * Parses a JsonArray or JsonObject and all its child nodes without recursion.
+         * The current token must be the first token of the container.
+        */
+        static void parseContainers(Context &context, JsonNode &root);
+
+        /**
+         * Pushes a container on the frames stack and reads its first tokens. Returns true if the current token
+         * is the first token of a child, false if it follows the children that have been read.
+        */
+        static bool openContainer(Context &context, JsonNode &container);
+
+        /**
+         * Parses the child that starts with the current token and adds it to the pending children.
+         * Returns the child if it is a container that still has to be parsed, otherwise nullptr.
+        */
+        static JsonNode *parseValue(Context &context, JsonNode &parent);
+
+        /**
+         * Reads the name of an object member and the name separator, the current token is then the first token of the value.
+        */
+        static void parseMemberName(Context &context);
+
+        /**
+         * Checks that the current token ends the innermost container, hands the pending children to it and pops it.
         */
-        static void parseArray(std::istream &input, JsonArray &parent);
+        static void closeContainer(Context &context);
 
         /**
-         * Recursive method that will parse one child to a JsonArray node.
+         * Creates a node and pushes it on the stack of pending children.
         */
-        static void parseArrayValue(std::istream &input, JsonToken &current, JsonArray &parent);
+        template <typename NodeType, typename... Args>
+        static NodeType &createChild(Context &context, Args &&... args);
 
         /**
-         * Recursive method that parses a JsonObject and all its child nodes.
+         * Moves the pending children from a specific position of the stack into a JsonArray.
         */
-        static void parseObject(std::istream &input, JsonObject &parent);
+        static void finishArray(Context &context, JsonArray &parent, size_t first);
 
         /**
-         * Recursive method that will parse one child to a JsonObject node.
+         * Moves the pending children and names from specific positions of the stacks into a JsonObject.
         */
-        static void parseObjectMember(std::istream &input, JsonToken &current, JsonObject &parent);
+        static void finishObject(Context &context, JsonObject &parent, size_t first, size_t firstName);
     };
 } // namespace json
 
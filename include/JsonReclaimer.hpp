@@ -0,0 +1,108 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef JSON_RECLAIMER_HPP
+#define JSON_RECLAIMER_HPP
+
+#include "JsonDocument.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace json
+{
+    /**
+     * Frees documents on a background thread, so that dropping a large document does not stall the thread using it.
+     * A document handed to reclaim() is freed a few thousand nodes at a time, and its arena is released afterwards.
+     * At most a fixed number of documents wait to be freed, reclaim() blocks while that many are pending.
+     * Using a reclaimer is optional, a document that is simply destroyed is freed right away as before.
+    */
+    class JsonReclaimer
+    {
+    public:
+        /**
+         * Starts the background thread. At most maximumPending documents wait to be freed at the same time.
+        */
+        explicit JsonReclaimer(size_t maximumPending = 16);
+
+        /**
+         * Frees every pending document and stops the background thread.
+        */
+        ~JsonReclaimer();
+
+        JsonReclaimer(const JsonReclaimer &) = delete;
+        JsonReclaimer &operator=(const JsonReclaimer &) = delete;
+
+        /**
+         * Takes the root and the arena of a document and frees them on the background thread, the document is left empty.
+         * Nodes that are still shared with a snapshot are left to the snapshot. If maximumPending documents are
+         * already waiting this method blocks until the background thread has freed one of them.
+        */
+        void reclaim(JsonDocument &&document);
+
+        /**
+         * Blocks until every document handed to reclaim() has been freed, for example before shutting down.
+        */
+        void drain();
+
+        /**
+         * Returns the number of documents that have not been freed yet.
+        */
+        size_t getPendingCount() const;
+
+    private:
+        // What is left to free of one document.
+        struct Garbage
+        {
+            // The nodes allocated with new, see JsonNode::destroyPending().
+            JsonNode *nodes;
+            std::shared_ptr<JsonArena> arena;
+        };
+
+        // The body of the background thread.
+        void run();
+
+        size_t maximumPending;
+
+        // The documents waiting to be freed and the number of documents being freed right now.
+        std::deque<Garbage> queue;
+        size_t active;
+        bool stopping;
+
+        mutable std::mutex mutex;
+
+        // Signals the background thread that there is garbage or that it should stop.
+        std::condition_variable available;
+
+        // Signals reclaim() and drain() that a document has been freed.
+        std::condition_variable freed;
+
+        std::thread thread;
+    };
+} // namespace json
+
+#endif
\ No newline at end of file
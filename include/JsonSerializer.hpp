@@ -0,0 +1,111 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef JSON_SERIALIZER_HPP
+#define JSON_SERIALIZER_HPP
+
+#include "JsonVisitor.hpp"
+#include "JsonFormat.hpp"
+#include "JsonOutputBuffer.hpp"
+
+#include <string>
+#include <vector>
+
+namespace json
+{
+    class JsonNode;
+
+    /**
+     * Writes a tree as JSON text into a JsonOutputBuffer. This is what JsonDocument::writeToStream() and
+     * JsonDocument::toString() use. A serializer can be used for several trees, one after another.
+    */
+    class JsonSerializer : public JsonVisitor
+    {
+    public:
+        /**
+         * Creates a new JsonSerializer that writes into a buffer with a specific format.
+        */
+        JsonSerializer(JsonOutputBuffer &output, const JsonFormat &format);
+
+        /**
+         * Writes a node and everything below it.
+        */
+        void write(const JsonNode &node);
+
+        /**
+         * Writes a node as if it was nested a number of levels deep, so in pretty mode its lines are indented further.
+         * The first character is not indented, it follows whatever was written before it.
+        */
+        void write(const JsonNode &node, size_t depth);
+
+        /**
+         * Writes the children first to last - 1 of an array or an object nested a number of levels deep, without its brackets.
+         * Every child is written exactly as write() writes it inside the container, including the ',' and the newline after it,
+         * so the text of consecutive ranges can be joined. This is how JsonParallelSerializer splits a container.
+        */
+        void writeChildren(const JsonNode &container, size_t first, size_t last, size_t depth);
+
+        bool beginArray(const JsonArray &array) override;
+        void endArray(const JsonArray &array) override;
+        bool beginObject(const JsonObject &object) override;
+        void endObject(const JsonObject &object) override;
+        void visitName(JsonStringView name) override;
+        void visitBool(bool value) override;
+        void visitNull() override;
+        void visitNumber(double value) override;
+        void visitNumberNode(const JsonNumber &number) override;
+        void visitString(const JsonString &value) override;
+
+    private:
+        struct Level
+        {
+            size_t remaining;
+            bool array;
+            bool empty;
+        };
+
+        // The elements of an array start on a line of their own, the values of an object follow their names.
+        void beginValue();
+        void endValue();
+
+        // If the container is empty we would like to print [] or {} without a newline in the middle.
+        void open(size_t count, bool array);
+        void close(char end);
+
+        // Writes the spaces in front of a line, nothing in compact mode.
+        void indent(size_t depth);
+
+        JsonOutputBuffer &output;
+        JsonFormat format;
+        std::vector<Level> levels;
+
+        // The depth the node being written is nested at.
+        size_t baseDepth;
+
+        // The spaces are written from one buffer, so deep documents do not build a new string for every level.
+        std::string spaces;
+    };
+} // namespace json
+
+#endif
\ No newline at end of file
@@ -0,0 +1,75 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef JSON_SHAPE_HPP
+#define JSON_SHAPE_HPP
+
+#include "JsonStringView.hpp"
+
+#include <cstddef>
+
+namespace json
+{
+    /**
+     * Describes the names of a JsonObject and the slot of every name.
+     * Objects with the same names added in the same order share one shape, so the names are stored once
+     * and every object only stores its values. Shapes are created by a JsonStringPool and never change,
+     * adding a name to an object moves the object to another shape.
+    */
+    class JsonShape
+    {
+    public:
+        /**
+         * Returns the number of names in this shape.
+        */
+        size_t size() const noexcept;
+
+        /**
+         * Returns the name stored in a specific slot.
+        */
+        JsonStringView getName(size_t slot) const noexcept;
+
+        /**
+         * Returns the slot of a name, or size() if the shape does not contain the name.
+        */
+        size_t find(JsonStringView name) const noexcept;
+
+        /**
+         * Returns the slot of a name interned in the same pool as the shape, or size() if the shape does not contain it.
+         * Only the pointers are compared.
+        */
+        size_t findInterned(JsonStringView name) const noexcept;
+
+    private:
+        friend class JsonStringPool;
+
+        JsonShape(const JsonStringView *names, size_t count) noexcept;
+
+        // The names in slot order, the array lives in the pool.
+        const JsonStringView *names;
+        size_t count;
+    };
+} // namespace json
+
+#endif
\ No newline at end of file
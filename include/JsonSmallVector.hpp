@@ -0,0 +1,216 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef JSON_SMALL_VECTOR_HPP
+#define JSON_SMALL_VECTOR_HPP
+
+#include "JsonArena.hpp"
+
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+namespace json
+{
+    /**
+     * A vector that stores its first N elements inside the object itself and only allocates memory
+     * when it grows beyond that. Memory is taken from a JsonArena, or from operator new if the arena is nullptr.
+     * The vector does not know its arena, so every method that allocates takes the arena as an argument
+     * and the owner must call deallocate() before the vector is destroyed.
+     * Only trivially copyable types can be stored, elements are moved with memcpy.
+    */
+    template <typename T, size_t N>
+    class JsonSmallVector
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "JsonSmallVector can only store trivially copyable types");
+
+    public:
+        JsonSmallVector() noexcept : elements(reinterpret_cast<T *>(local)), count(0), limit(N)
+        {
+        }
+
+        JsonSmallVector(const JsonSmallVector &) = delete;
+        JsonSmallVector &operator=(const JsonSmallVector &) = delete;
+
+        /**
+         * Releases the memory used by the elements if they no longer fit inside the object.
+        */
+        void deallocate(JsonArena *arena) noexcept
+        {
+            if (!isInline() && !arena)
+                ::operator delete(elements);
+            elements = reinterpret_cast<T *>(local);
+            count = 0;
+            limit = N;
+        }
+
+        /**
+         * Returns true if the elements are stored inside the object.
+        */
+        bool isInline() const noexcept
+        {
+            return elements == reinterpret_cast<const T *>(local);
+        }
+
+        size_t size() const noexcept
+        {
+            return count;
+        }
+
+        size_t capacity() const noexcept
+        {
+            return limit;
+        }
+
+        bool empty() const noexcept
+        {
+            return count == 0;
+        }
+
+        T *data() noexcept
+        {
+            return elements;
+        }
+
+        const T *data() const noexcept
+        {
+            return elements;
+        }
+
+        T *begin() noexcept
+        {
+            return elements;
+        }
+
+        T *end() noexcept
+        {
+            return elements + count;
+        }
+
+        const T *begin() const noexcept
+        {
+            return elements;
+        }
+
+        const T *end() const noexcept
+        {
+            return elements + count;
+        }
+
+        T &operator[](size_t index) noexcept
+        {
+            return elements[index];
+        }
+
+        const T &operator[](size_t index) const noexcept
+        {
+            return elements[index];
+        }
+
+        /**
+         * Adds the memory of the elements to the usage. Elements stored inside the object are part of the owner and are not counted.
+        */
+        void addMemoryUsage(JsonMemoryUsage &usage, JsonMemoryCategory category) const noexcept
+        {
+            if (isInline())
+                return;
+            usage.add(category, count * sizeof(T));
+            usage.slack += (limit - count) * sizeof(T);
+        }
+
+        T &back() noexcept
+        {
+            return elements[count - 1];
+        }
+
+        /**
+         * Makes sure that at least a specific number of elements can be stored without allocating again.
+        */
+        void reserve(size_t size, JsonArena *arena)
+        {
+            if (size <= limit)
+                return;
+
+            T *memory = arena ? static_cast<T *>(arena->allocate(size * sizeof(T), alignof(T)))
+                              : static_cast<T *>(::operator new(size * sizeof(T)));
+            if (count > 0)
+                std::memcpy(static_cast<void *>(memory), elements, count * sizeof(T));
+            if (!isInline() && !arena)
+                ::operator delete(elements);
+
+            elements = memory;
+            limit = size;
+        }
+
+        void push_back(const T &value, JsonArena *arena)
+        {
+            if (count == limit)
+                reserve(limit * 2, arena);
+            new (elements + count) T(value);
+            count++;
+        }
+
+        /**
+         * Inserts an element before a specific index.
+        */
+        void insert(size_t index, const T &value, JsonArena *arena)
+        {
+            if (count == limit)
+                reserve(limit * 2, arena);
+            std::memmove(static_cast<void *>(elements + index + 1), elements + index, (count - index) * sizeof(T));
+            new (elements + index) T(value);
+            count++;
+        }
+
+        /**
+         * Removes the element at a specific index, the following elements are moved one step to the front.
+        */
+        void erase(size_t index) noexcept
+        {
+            std::memmove(static_cast<void *>(elements + index), elements + index + 1, (count - index - 1) * sizeof(T));
+            count--;
+        }
+
+        void pop_back() noexcept
+        {
+            count--;
+        }
+
+        /**
+         * Removes all elements but keeps the memory.
+        */
+        void clear() noexcept
+        {
+            count = 0;
+        }
+
+    private:
+        T *elements;
+        size_t count;
+        size_t limit;
+        alignas(T) unsigned char local[N * sizeof(T)];
+    };
+} // namespace json
+
+#endif
\ No newline at end of file
@@ -0,0 +1,83 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef JSON_SPAN_HPP
+#define JSON_SPAN_HPP
+
+#include <cstddef>
+
+namespace json
+{
+    /**
+     * A view of a contiguous sequence of elements owned by someone else, similar to std::span.
+    */
+    template <typename T>
+    class JsonSpan
+    {
+    public:
+        JsonSpan() noexcept : elements(nullptr), count(0)
+        {
+        }
+
+        JsonSpan(T *elements, size_t count) noexcept : elements(elements), count(count)
+        {
+        }
+
+        T *data() const noexcept
+        {
+            return elements;
+        }
+
+        size_t size() const noexcept
+        {
+            return count;
+        }
+
+        bool empty() const noexcept
+        {
+            return count == 0;
+        }
+
+        T *begin() const noexcept
+        {
+            return elements;
+        }
+
+        T *end() const noexcept
+        {
+            return elements + count;
+        }
+
+        T &operator[](size_t index) const noexcept
+        {
+            return elements[index];
+        }
+
+    private:
+        T *elements;
+        size_t count;
+    };
+} // namespace json
+
+#endif
\ No newline at end of file
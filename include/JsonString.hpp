@@ -26,9 +26,23 @@ THE SOFTWARE.
 #define JSON_STRING_HPP
 
 #include "JsonNode.hpp"
+#include "JsonStringView.hpp"
+
+#include <atomic>
 
 namespace json
 {
+    class JsonOutputBuffer;
+
+    /**
+     * Tells a JsonString created in an arena whether it copies its characters or refers to them.
+    */
+    enum class JsonStringStorage
+    {
+        Copy,   // The characters are copied into the arena or interned in its string pool.
+        Borrow  // The characters are not copied, they must live as long as the arena, see JsonDocument::createInSitu().
+    };
+
     /**
      * Represents a node that can store a string value.
     */
@@ -56,35 +70,66 @@ namespace json
         JsonString(JsonNode *parent, std::string &&value);
 
         /**
-         * Returns JsonNodeType::String.
+         * Creates a new JsonString with a parent. The characters are copied into the arena.
+         * If the arena is nullptr the JsonString will own a std::string instead.
+        */
+        JsonString(JsonNode *parent, JsonArena *arena, JsonStringView value);
+
+        /**
+         * Creates a new JsonString with a parent in an arena, which copies the characters or refers to them.
+        */
+        JsonString(JsonNode *parent, JsonArena *arena, JsonStringView value, JsonStringStorage storage);
+
+        /**
+         * Destroys the JsonString.
+        */
+        ~JsonString();
+
+        /**
+         * Replaces the string value this JsonString is storing.
+         * Throws a std::runtime_error if the node is shared with a snapshot, see JsonNode::isShared().
         */
-        JsonNodeType getType() const noexcept override;
+        JsonString &operator=(const std::string &value);
 
         /**
-         * Returns a reference to this JsonString.
+         * Replaces the string value this JsonString is storing.
+         * Throws a std::runtime_error if the node is shared with a snapshot, see JsonNode::isShared().
         */
-        JsonString &toString() override;
+        JsonString &operator=(std::string &&value);
 
         /**
-         * Returns a const reference to this JsonString.
+         * Returns a view of the string value this JsonString is storing, this never allocates memory.
         */
-        const JsonString &toString() const override;
+        JsonStringView view() const noexcept;
 
         /**
          * Returns a reference to the string value this JsonString is storing.
+         * If the characters live in an arena they are copied into a std::string the first time this method is called.
+         * Throws a std::runtime_error if the node is shared with a snapshot, since the value may be changed through the reference.
         */
-        std::string &data() noexcept;
+        std::string &data();
 
         /**
          * Returns a const reference to the string value this JsonString is storing.
+         * If the characters live in an arena they are copied into a std::string the first time this method is called.
         */
-        const std::string &data() const noexcept;
+        const std::string &data() const;
 
         /**
          * Will escape the string and return it. So for example a newline will be replaced with \n.
         */
         std::string escaped() const noexcept;
 
+        /**
+         * Writes the characters with the escape sequences JSON needs straight into a buffer, without the quotes.
+         * Quotes, backslashes and control characters are escaped, the control characters without a short form as \u00XX.
+         * If ensureAscii is true every character beyond ASCII is written as \uXXXX, or as a surrogate pair, so that
+         * the output is plain ASCII. A surrogate without its pair, as read from "\ud800", is written back as it was read,
+         * and every sequence of bytes that is not valid UTF-8 is written as one \ufffd.
+         * Runs of characters that need no escaping are found 16 bytes at a time and copied as a whole.
+        */
+        static void escape(JsonStringView value, JsonOutputBuffer &output, bool ensureAscii = false);
+
         /**
          * Implicit conversion to a string reference.
         */
@@ -101,7 +146,22 @@ namespace json
         operator const char *() const;
 
     private:
-        std::string value;
+        friend class JsonNode;
+
+        // Adds the memory of the characters, see JsonNode::memoryUsage().
+        void addMemoryUsage(JsonMemoryUsage &usage) const noexcept;
+
+        // Returns the std::string holding the value, creating it if necessary.
+        std::string &materialize() const;
+
+        JsonArena *arena;
+
+        // The characters of the value as long as no std::string has been created.
+        JsonStringView chars;
+
+        // Once a std::string has been created it holds the value and chars is no longer used.
+        // Const methods may create it, so it is installed atomically.
+        mutable std::atomic<std::string *> materialized;
     };
 } // namespace json
 
@@ -0,0 +1,182 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef JSON_STRING_POOL_HPP
+#define JSON_STRING_POOL_HPP
+
+#include "JsonArena.hpp"
+#include "JsonStringView.hpp"
+#include "JsonShape.hpp"
+
+#include <unordered_map>
+
+namespace json
+{
+    /**
+     * An interning table that stores every distinct string once.
+     * A JsonDocument uses a pool for the names in its objects, so a name repeated in thousands of objects
+     * is only stored once and two interned names are equal exactly when their data() pointers are equal.
+     * The pool also owns the shapes of the objects, see JsonShape.
+     * A pool can be shared by several documents, for example all documents read from the lines of an NDJSON stream.
+     * The pool is not synchronized, two documents sharing a pool must not be modified or parsed at the same time.
+    */
+    class JsonStringPool
+    {
+    public:
+        /**
+         * Creates a new JsonStringPool. String values with at most maximumValueLength characters
+         * are interned as well as names, a maximumValueLength of 0 means that only names are interned.
+         * The strings, the table and the shapes are allocated from the memory resource, which must outlive the pool.
+        */
+        explicit JsonStringPool(size_t maximumValueLength = 0, JsonMemoryResource *resource = JsonMemoryResource::getDefault());
+
+        /**
+         * Releases every interned string.
+        */
+        ~JsonStringPool();
+
+        JsonStringPool(const JsonStringPool &) = delete;
+        JsonStringPool &operator=(const JsonStringPool &) = delete;
+
+        /**
+         * Creates a new JsonStringPool owned by a shared_ptr, where the shared_ptr itself is allocated from the memory resource as well.
+        */
+        static std::shared_ptr<JsonStringPool> createShared(size_t maximumValueLength, JsonMemoryResource *resource);
+
+        /**
+         * Returns the resource the pool allocates from.
+        */
+        JsonMemoryResource *getMemoryResource() const noexcept;
+
+        /**
+         * Returns the interned copy of the string, adding it to the pool if necessary.
+         * The returned view stays valid as long as the pool exists.
+        */
+        JsonStringView intern(JsonStringView str);
+
+        /**
+         * Returns the interned copy of the string without adding it.
+         * If the string is not in the pool the returned view has data() equal to nullptr.
+        */
+        JsonStringView find(JsonStringView str) const noexcept;
+
+        /**
+         * Returns true if string values of this length should be interned.
+        */
+        bool shouldInternValue(JsonStringView value) const noexcept;
+
+        /**
+         * Returns the maximum length of string values that are interned.
+        */
+        size_t getMaximumValueLength() const noexcept;
+
+        /**
+         * Returns the shape without any names.
+        */
+        const JsonShape *getEmptyShape() const noexcept;
+
+        /**
+         * Returns the shape that has the same names as the given shape followed by one more name.
+         * The name must be interned in this pool. Returns nullptr if objects with that many names
+         * should not use a shape or if the pool already holds too many shapes.
+        */
+        const JsonShape *addName(const JsonShape *shape, JsonStringView name);
+
+        /**
+         * Returns the number of shapes created by this pool.
+        */
+        size_t getShapeCount() const noexcept;
+
+        /**
+         * Returns the largest number of names a shape can have, larger objects store their own names.
+        */
+        static size_t getMaximumShapeSize() noexcept;
+
+        /**
+         * Returns the number of distinct strings in the pool.
+        */
+        size_t size() const noexcept;
+
+        /**
+         * Returns the number of bytes used by the strings and the table.
+        */
+        size_t getBytesUsed() const noexcept;
+
+        /**
+         * Returns the memory of the pool. Everything the pool holds is counted as key strings.
+        */
+        JsonMemoryUsage getMemoryUsage() const noexcept;
+
+    private:
+        struct Entry
+        {
+            // nullptr marks an empty slot.
+            const char *chars;
+            size_t size;
+            size_t hash;
+        };
+
+        struct Transition
+        {
+            const JsonShape *shape;
+            const char *name;
+
+            bool operator==(const Transition &rhs) const noexcept
+            {
+                return shape == rhs.shape && name == rhs.name;
+            }
+        };
+
+        struct TransitionHash
+        {
+            size_t operator()(const Transition &transition) const noexcept;
+        };
+
+        // Returns the slot holding the string, or the empty slot where it should be inserted.
+        Entry *findSlot(JsonStringView str, size_t hash) const noexcept;
+
+        // Doubles the size of the table.
+        void grow();
+
+        // Allocates an empty table from the memory resource.
+        Entry *allocateEntries(size_t capacity);
+
+        // The characters of every interned string.
+        JsonArena storage;
+
+        // An open addressing table with linear probing, the capacity is always a power of two.
+        Entry *entries;
+        size_t capacity;
+        size_t count;
+        size_t maximumValueLength;
+
+        // Every shape reachable by adding one name to another shape.
+        JsonShape emptyShape;
+        std::unordered_map<Transition, const JsonShape *, TransitionHash, std::equal_to<Transition>,
+                           JsonResourceAllocator<std::pair<const Transition, const JsonShape *>>>
+            transitions;
+    };
+} // namespace json
+
+#endif
\ No newline at end of file
@@ -0,0 +1,147 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef JSON_STRING_VIEW_HPP
+#define JSON_STRING_VIEW_HPP
+
+#include <string>
+#include <ostream>
+#include <cstddef>
+
+namespace json
+{
+    /**
+     * A non-owning reference to a sequence of characters.
+     * It is used for keys and string values that are stored in memory owned by a JsonDocument,
+     * so that they can be passed around without copying them into a std::string.
+    */
+    class JsonStringView
+    {
+    public:
+        /**
+         * Creates an empty JsonStringView.
+        */
+        JsonStringView() noexcept;
+
+        /**
+         * Creates a JsonStringView referring to a null-terminated string.
+        */
+        JsonStringView(const char *str) noexcept;
+
+        /**
+         * Creates a JsonStringView referring to a specific number of characters.
+        */
+        JsonStringView(const char *data, size_t size) noexcept;
+
+        /**
+         * Creates a JsonStringView referring to the characters of a std::string.
+        */
+        JsonStringView(const std::string &str) noexcept;
+
+        /**
+         * Returns a pointer to the first character. The characters are not necessarily null-terminated.
+        */
+        const char *data() const noexcept;
+
+        /**
+         * Returns the number of characters.
+        */
+        size_t size() const noexcept;
+
+        /**
+         * Returns the number of characters.
+        */
+        size_t length() const noexcept;
+
+        /**
+         * Returns true if there are no characters.
+        */
+        bool empty() const noexcept;
+
+        /**
+         * Returns the character at a specific index.
+         * No range checks are done so make sure the index is within the boundaries.
+        */
+        char operator[](size_t index) const noexcept;
+
+        /**
+         * Returns a pointer to the first character.
+        */
+        const char *begin() const noexcept;
+
+        /**
+         * Returns a pointer past the last character.
+        */
+        const char *end() const noexcept;
+
+        /**
+         * Copies the characters into a new std::string.
+        */
+        std::string str() const;
+
+        /**
+         * Implicit conversion to a std::string, the characters are copied.
+        */
+        operator std::string() const;
+
+        /**
+         * Returns a hash value computed from the characters.
+        */
+        size_t hash() const noexcept;
+
+        /**
+         * Function object that makes JsonStringView usable as a key in unordered containers.
+        */
+        struct Hash
+        {
+            size_t operator()(const JsonStringView &view) const noexcept;
+        };
+
+    private:
+        const char *chars;
+        size_t count;
+    };
+
+    /**
+     * Returns true if the two views refer to equal sequences of characters.
+    */
+    bool operator==(const JsonStringView &lhs, const JsonStringView &rhs) noexcept;
+
+    /**
+     * Returns true if the two views refer to different sequences of characters.
+    */
+    bool operator!=(const JsonStringView &lhs, const JsonStringView &rhs) noexcept;
+
+    /**
+     * Compares the two views lexicographically.
+    */
+    bool operator<(const JsonStringView &lhs, const JsonStringView &rhs) noexcept;
+
+    /**
+     * Writes the characters to an output stream.
+    */
+    std::ostream &operator<<(std::ostream &output, const JsonStringView &view);
+} // namespace json
+
+#endif
\ No newline at end of file
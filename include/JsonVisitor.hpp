@@ -0,0 +1,100 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef JSON_VISITOR_HPP
+#define JSON_VISITOR_HPP
+
+#include "JsonStringView.hpp"
+
+namespace json
+{
+    class JsonArray;
+    class JsonObject;
+    class JsonNumber;
+    class JsonString;
+
+    /**
+     * Receives the values of a tree in document order, see JsonNode::accept().
+     * The tree is walked with a stack of its own instead of the call stack, so the visitor works for
+     * documents of any depth. Every method does nothing by default, so a visitor only overrides what it needs.
+    */
+    class JsonVisitor
+    {
+    public:
+        virtual ~JsonVisitor();
+
+        /**
+         * Called before the elements of an array. If false is returned the elements are skipped, endArray() is still called.
+        */
+        virtual bool beginArray(const JsonArray &array);
+
+        /**
+         * Called after the elements of an array.
+        */
+        virtual void endArray(const JsonArray &array);
+
+        /**
+         * Called before the members of an object. If false is returned the members are skipped, endObject() is still called.
+        */
+        virtual bool beginObject(const JsonObject &object);
+
+        /**
+         * Called after the members of an object.
+        */
+        virtual void endObject(const JsonObject &object);
+
+        /**
+         * Called with the name of an object member, right before its value is visited.
+        */
+        virtual void visitName(JsonStringView name);
+
+        /**
+         * Called for a JsonBool.
+        */
+        virtual void visitBool(bool value);
+
+        /**
+         * Called for a JsonNull.
+        */
+        virtual void visitNull();
+
+        /**
+         * Called for a JsonNumber, and for every number of a packed JsonArray without creating a node for it.
+        */
+        virtual void visitNumber(double value);
+
+        /**
+         * Called for a JsonNumber node, by default it calls visitNumber() with its value.
+         * A visitor that needs the text of a parsed number, see JsonNumber::getText(), overrides this method.
+        */
+        virtual void visitNumberNode(const JsonNumber &number);
+
+        /**
+         * Called for a JsonString.
+        */
+        virtual void visitString(const JsonString &value);
+    };
+} // namespace json
+
+#endif
\ No newline at end of file
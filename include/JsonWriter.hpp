@@ -0,0 +1,201 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef JSON_WRITER_HPP
+#define JSON_WRITER_HPP
+
+#include "JsonFormat.hpp"
+#include "JsonOutputBuffer.hpp"
+#include "JsonSmallVector.hpp"
+#include "JsonStringView.hpp"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+namespace json
+{
+    class JsonNode;
+
+    /**
+     * Writes JSON text one value at a time without building a JsonDocument, so writing millions of values
+     * takes no more memory than writing one. The text has the same layout as JsonDocument::writeToStream().
+     * A stream receives the text in blocks as they fill up, so the output is never held in memory as a whole.
+     * The order of the calls is checked, for example a value inside an object must follow a key(),
+     * and a std::runtime_error is thrown when a call does not fit, before anything is written.
+     *
+     * writer.beginObject().key("id").value(1).key("tags").beginArray().value("a").endArray().endObject();
+    */
+    class JsonWriter
+    {
+    public:
+        /**
+         * Creates a new JsonWriter that writes to a stream.
+        */
+        explicit JsonWriter(std::ostream &output, const JsonFormat &format = JsonFormat());
+
+        /**
+         * Creates a new JsonWriter that appends to a string. The string must not be used until flush() is called.
+        */
+        explicit JsonWriter(std::string &output, const JsonFormat &format = JsonFormat());
+
+        /**
+         * Flushes the text that has not been written yet.
+        */
+        ~JsonWriter();
+
+        JsonWriter(const JsonWriter &) = delete;
+        JsonWriter &operator=(const JsonWriter &) = delete;
+
+        /**
+         * Starts an object, its members are written with key() followed by a value.
+        */
+        JsonWriter &beginObject();
+
+        /**
+         * Ends the object started last.
+        */
+        JsonWriter &endObject();
+
+        /**
+         * Starts an array.
+        */
+        JsonWriter &beginArray();
+
+        /**
+         * Ends the array started last.
+        */
+        JsonWriter &endArray();
+
+        /**
+         * Writes the name of the next member of an object.
+        */
+        JsonWriter &key(JsonStringView name);
+
+        /**
+         * Writes a string.
+        */
+        JsonWriter &value(JsonStringView str);
+
+        /**
+         * Writes a string.
+        */
+        JsonWriter &value(const char *str);
+
+        /**
+         * Writes a string.
+        */
+        JsonWriter &value(const std::string &str);
+
+        /**
+         * Writes a number, see JsonNumber::format(). Throws a std::runtime_error for infinity and NaN.
+        */
+        JsonWriter &value(double number);
+
+        /**
+         * Writes an integer with all its digits.
+        */
+        template <typename T>
+        typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, JsonWriter &>::type value(T number)
+        {
+            if (std::is_signed<T>::value)
+                return writeInteger(static_cast<int64_t>(number));
+            return writeUnsigned(static_cast<uint64_t>(number));
+        }
+
+        /**
+         * Writes true or false.
+        */
+        JsonWriter &value(bool boolean);
+
+        /**
+         * Writes a node and everything below it, for example a part of the output that already exists as a JsonDocument.
+        */
+        JsonWriter &value(const JsonNode &node);
+
+        /**
+         * Writes null.
+        */
+        JsonWriter &null();
+
+        /**
+         * Hands everything written so far to the stream or the string.
+        */
+        void flush();
+
+        /**
+         * Returns true if a value has been written and every array and object has been ended.
+        */
+        bool isComplete() const noexcept;
+
+        /**
+         * Returns the number of arrays and objects that have been started but not ended.
+        */
+        size_t getDepth() const noexcept;
+
+    private:
+        struct Frame
+        {
+            // The number of values written in the container so far.
+            size_t count;
+            bool object;
+
+            // True between the key() of a member and its value.
+            bool named;
+        };
+
+        // Checks that a value may be written here and writes what goes in front of it.
+        void beginValue();
+
+        // Counts a written value.
+        void endValue() noexcept;
+
+        // Writes the separator and the indentation in front of an element or a member.
+        void beginItem(Frame &frame);
+
+        // Ends an array or an object.
+        JsonWriter &end(bool object);
+
+        JsonWriter &writeInteger(int64_t number);
+        JsonWriter &writeUnsigned(uint64_t number);
+
+        // Writes a newline followed by the indentation of a depth, nothing in compact mode.
+        void newline(size_t depth);
+
+        JsonOutputBuffer output;
+        JsonFormat format;
+
+        // The arrays and objects that have been started. Documents up to 32 levels deep do not allocate.
+        JsonSmallVector<Frame, 32> frames;
+
+        // True once the root value has been started.
+        bool started;
+
+        // The newline and the spaces are written from one buffer.
+        std::string spaces;
+    };
+} // namespace json
+
+#endif
\ No newline at end of file
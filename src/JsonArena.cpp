@@ -0,0 +1,328 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "JsonArena.hpp"
+#include "JsonStringPool.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace json
+{
+    namespace
+    {
+        // The first chunk is small so that tiny documents stay cheap,
+        // every following chunk doubles in size until it reaches the maximum.
+        const size_t defaultInitialChunkSize = 1024;
+        const size_t maximumChunkSize = 1024 * 1024;
+
+        char *alignUp(char *pointer, size_t alignment)
+        {
+            uintptr_t value = reinterpret_cast<uintptr_t>(pointer);
+            return reinterpret_cast<char *>((value + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1));
+        }
+    } // namespace
+
+    JsonArena::JsonArena() : JsonArena(defaultInitialChunkSize)
+    {
+    }
+
+    JsonArena::JsonArena(size_t initialChunkSize) : JsonArena(initialChunkSize, JsonMemoryResource::getDefault())
+    {
+    }
+
+    JsonArena::JsonArena(size_t initialChunkSize, JsonMemoryResource *resource)
+        : resource(resource), chunks(nullptr), position(nullptr), end(nullptr),
+          nextChunkSize(initialChunkSize > 0 ? initialChunkSize : defaultInitialChunkSize),
+          chunkCount(0), bytesUsed(0), bytesReserved(0), cleanups(nullptr), synchronized(false)
+    {
+    }
+
+    JsonArena::~JsonArena()
+    {
+        // The cleanups are allocated in the arena so we run them before the chunks are released.
+        for (Cleanup *cleanup = cleanups; cleanup != nullptr; cleanup = cleanup->next)
+            cleanup->function(cleanup->object);
+
+        while (chunks != nullptr)
+        {
+            Chunk *previous = chunks->previous;
+            resource->deallocate(chunks, chunks->size);
+            chunks = previous;
+        }
+    }
+
+    std::shared_ptr<JsonArena> JsonArena::createShared()
+    {
+        return createShared(defaultInitialChunkSize);
+    }
+
+    std::shared_ptr<JsonArena> JsonArena::createShared(size_t initialChunkSize)
+    {
+        return createShared(initialChunkSize, JsonMemoryResource::getDefault());
+    }
+
+    std::shared_ptr<JsonArena> JsonArena::createShared(size_t initialChunkSize, JsonMemoryResource *resource)
+    {
+        std::shared_ptr<JsonArena> arena = std::allocate_shared<JsonArena>(JsonResourceAllocator<JsonArena>(resource), initialChunkSize, resource);
+        arena->self = arena;
+        return arena;
+    }
+
+    JsonMemoryResource *JsonArena::getMemoryResource() const noexcept
+    {
+        return resource;
+    }
+
+    std::shared_ptr<JsonArena> JsonArena::getShared() const noexcept
+    {
+        return self.lock();
+    }
+
+    void JsonArena::retain(std::shared_ptr<JsonArena> other)
+    {
+        if (!other || other.get() == this)
+            return;
+
+        // JsonDocument::Transfer copies the subtree instead of getting here, see JsonArray::attach().
+        if (other->isRetaining(this))
+            throw std::runtime_error("The arenas would keep each other alive");
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto &arena : retained)
+        {
+            if (arena == other)
+                return;
+        }
+        retained.push_back(std::move(other));
+    }
+
+    bool JsonArena::isRetaining(const JsonArena *other) const
+    {
+        // A copy of the list is taken so that only one arena is locked at a time.
+        std::vector<std::shared_ptr<JsonArena>> arenas;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            arenas = retained;
+        }
+
+        for (const auto &arena : arenas)
+        {
+            if (arena.get() == other || arena->isRetaining(other))
+                return true;
+        }
+        return false;
+    }
+
+    void *JsonArena::allocate(size_t size, size_t alignment, JsonMemoryCategory category)
+    {
+        if (!synchronized.load(std::memory_order_relaxed))
+            return allocateUnsynchronized(size, alignment, category);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        return allocateUnsynchronized(size, alignment, category);
+    }
+
+    void JsonArena::setSynchronized(bool synchronized) noexcept
+    {
+        this->synchronized.store(synchronized, std::memory_order_relaxed);
+    }
+
+    void *JsonArena::allocateUnsynchronized(size_t size, size_t alignment, JsonMemoryCategory category)
+    {
+        char *result = alignUp(position, alignment);
+
+        // The comparison is written this way to avoid computing a pointer past the end of the chunk.
+        if (position == nullptr || result > end || size > static_cast<size_t>(end - result))
+            return allocateSlow(size, alignment, category);
+
+        position = result + size;
+        bytesUsed += size;
+        allocated.add(category, size);
+        return result;
+    }
+
+    void *JsonArena::allocateConcurrently(size_t size, size_t alignment, JsonMemoryCategory category)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return allocateUnsynchronized(size, alignment, category);
+    }
+
+    JsonStringView JsonArena::copyString(JsonStringView str, JsonMemoryCategory category)
+    {
+        if (str.empty())
+            return JsonStringView();
+        char *chars = static_cast<char *>(allocate(str.size(), 1, category));
+        std::memcpy(chars, str.data(), str.size());
+        return JsonStringView(chars, str.size());
+    }
+
+    void JsonArena::addCleanup(void (*function)(void *), void *object)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Cleanup *cleanup = static_cast<Cleanup *>(allocateUnsynchronized(sizeof(Cleanup), alignof(Cleanup), JsonMemoryCategory::ContainerStorage));
+        cleanup->function = function;
+        cleanup->object = object;
+        cleanup->next = cleanups;
+        cleanups = cleanup;
+    }
+
+    void JsonArena::account(const JsonMemoryUsage &usage)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        accounted += usage;
+    }
+
+    void JsonArena::setStringPool(std::shared_ptr<JsonStringPool> pool) noexcept
+    {
+        stringPool = std::move(pool);
+    }
+
+    JsonStringPool *JsonArena::getStringPool() const noexcept
+    {
+        return stringPool.get();
+    }
+
+    const std::shared_ptr<JsonStringPool> &JsonArena::getSharedStringPool() const noexcept
+    {
+        return stringPool;
+    }
+
+    size_t JsonArena::getBytesUsed() const noexcept
+    {
+        return bytesUsed;
+    }
+
+    size_t JsonArena::getBytesReserved() const noexcept
+    {
+        return bytesReserved;
+    }
+
+    size_t JsonArena::getChunkCount() const noexcept
+    {
+        return chunkCount;
+    }
+
+    JsonMemoryUsage JsonArena::getMemoryUsage() const
+    {
+        // The arenas are kept alive by this arena, so plain pointers are enough while we count.
+        // An arena or a pool reached more than once is only counted once.
+        std::vector<const JsonArena *> arenas(1, this);
+        std::vector<const JsonStringPool *> pools;
+        JsonMemoryUsage usage;
+
+        for (size_t i = 0; i < arenas.size(); i++)
+        {
+            const JsonArena *arena = arenas[i];
+            std::lock_guard<std::mutex> lock(arena->mutex);
+
+            usage += arena->allocated;
+            usage += arena->accounted;
+            usage.slack += arena->bytesReserved - arena->allocated.getBytesUsed();
+
+            const JsonStringPool *pool = arena->stringPool.get();
+            if (pool && std::find(pools.begin(), pools.end(), pool) == pools.end())
+            {
+                pools.push_back(pool);
+                usage += pool->getMemoryUsage();
+            }
+
+            for (const auto &other : arena->retained)
+            {
+                if (std::find(arenas.begin(), arenas.end(), other.get()) == arenas.end())
+                    arenas.push_back(other.get());
+            }
+        }
+        return usage;
+    }
+
+    JsonStringView JsonArena::copyString(JsonArena *arena, JsonStringView str, JsonMemoryCategory category)
+    {
+        if (arena)
+            return arena->copyString(str, category);
+        if (str.empty())
+            return JsonStringView();
+        char *chars = new char[str.size()];
+        std::memcpy(chars, str.data(), str.size());
+        return JsonStringView(chars, str.size());
+    }
+
+    void JsonArena::destroyString(JsonArena *arena, JsonStringView str) noexcept
+    {
+        if (!arena && !str.empty())
+            delete[] str.data();
+    }
+
+    JsonArena::Chunk *JsonArena::allocateChunk(size_t size)
+    {
+        Chunk *chunk = static_cast<Chunk *>(resource->allocate(size));
+        chunk->size = size;
+        return chunk;
+    }
+
+    void *JsonArena::allocateSlow(size_t size, size_t alignment, JsonMemoryCategory category)
+    {
+        // The chunk header is followed by the usable memory.
+        size_t headerSize = (sizeof(Chunk) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+        size_t required = headerSize + size + alignment;
+
+        if (required > maximumChunkSize / 2 && chunks != nullptr)
+        {
+            // Large blocks get a chunk of their own. We put it behind the current chunk
+            // so that the remaining space in the current chunk can still be used.
+            Chunk *chunk = allocateChunk(required);
+            chunk->previous = chunks->previous;
+            chunks->previous = chunk;
+            chunkCount++;
+            bytesReserved += required;
+            bytesUsed += size;
+            allocated.add(category, size);
+            return alignUp(reinterpret_cast<char *>(chunk) + headerSize, alignment);
+        }
+
+        // A first chunk larger than the maximum, see createShared(), is not repeated.
+        size_t chunkSize = nextChunkSize > required ? nextChunkSize : required;
+        if (nextChunkSize < maximumChunkSize)
+            nextChunkSize *= 2;
+        else
+            nextChunkSize = maximumChunkSize;
+
+        Chunk *chunk = allocateChunk(chunkSize);
+        chunk->previous = chunks;
+        chunks = chunk;
+        chunkCount++;
+        bytesReserved += chunkSize;
+
+        position = reinterpret_cast<char *>(chunk) + headerSize;
+        end = reinterpret_cast<char *>(chunk) + chunkSize;
+
+        char *result = alignUp(position, alignment);
+        position = result + size;
+        bytesUsed += size;
+        allocated.add(category, size);
+        return result;
+    }
+} // namespace json
\ No newline at end of file
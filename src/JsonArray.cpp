@@ -28,291 +28,714 @@ THE SOFTWARE.
 #include "JsonNull.hpp"
 #include "JsonNumber.hpp"
 #include "JsonString.hpp"
+#include "JsonDocument.hpp"
+
+#include <cstring>
+#include <new>
+#include <stdexcept>
 
 namespace json
 {
-    JsonArray::JsonArray() : JsonNode()
+    namespace
     {
-    }
+        // Arrays that may be allocated by a const method use allocateConcurrently().
+        template <typename T>
+        T *allocateArray(JsonArena *arena, size_t count, bool concurrently = false)
+        {
+            if (!arena)
+                return static_cast<T *>(::operator new(count * sizeof(T)));
+            if (concurrently)
+                return static_cast<T *>(arena->allocateConcurrently(count * sizeof(T), alignof(T)));
+            return static_cast<T *>(arena->allocate(count * sizeof(T), alignof(T)));
+        }
+
+        void deallocateArray(JsonArena *arena, void *pointer) noexcept
+        {
+            if (!arena)
+                ::operator delete(pointer);
+        }
+    } // namespace
 
-    JsonArray::JsonArray(JsonNode *parent) : JsonNode(parent)
+    JsonArray::JsonArray() : JsonNode(JsonNodeType::Array), arena(nullptr), packed(nullptr)
     {
     }
 
-    JsonNodeType JsonArray::getType() const noexcept
+    JsonArray::JsonArray(JsonNode *parent) : JsonNode(parent, JsonNodeType::Array), arena(nullptr), packed(nullptr)
     {
-        return JsonNodeType::Array;
     }
 
-    JsonArray &JsonArray::toArray()
+    JsonArray::JsonArray(JsonNode *parent, JsonArena *arena) : JsonNode(parent, JsonNodeType::Array), arena(arena), packed(nullptr)
     {
-        return *this;
     }
 
-    const JsonArray &JsonArray::toArray() const
+    JsonArray::~JsonArray()
     {
-        return *this;
+        for (JsonNode *child : children)
+            destroy(arena, child);
+        children.deallocate(arena);
+        destroyPacked();
     }
 
     JsonNode &JsonArray::operator[](size_t index)
     {
-        return *children[index];
+        return writableChild(index);
     }
 
     const JsonNode &JsonArray::operator[](size_t index) const
     {
+        return childAt(index);
+    }
+
+    JsonNode &JsonArray::childAt(size_t index) const
+    {
+        if (packed)
+            return box(index);
         return *children[index];
     }
 
+    JsonNode &JsonArray::writableChild(size_t index)
+    {
+        // A shared array is only read, and the numbers of a packed array are copied together with the array.
+        if (packed || isShared())
+            return childAt(index);
+        return unshare(arena, this, children[index]);
+    }
+
+    JsonArray *JsonArray::copy(JsonArena *target, JsonNode *parent) const
+    {
+        JsonArray *result = JsonArena::create<JsonArray>(target, parent, target);
+        try
+        {
+            if (packed)
+            {
+                result->reservePacked(packed->count);
+                if (packed->count > 0)
+                    std::memcpy(result->packed->numbers, packed->numbers, packed->count * sizeof(double));
+                result->packed->count = packed->count;
+            }
+            else
+            {
+                result->children.reserve(children.size(), target);
+                for (JsonNode *child : children)
+                    result->children.push_back(share(child), target);
+            }
+        }
+        catch (...)
+        {
+            destroy(target, result);
+            throw;
+        }
+        return result;
+    }
+
+    void JsonArray::addMemoryUsage(JsonMemoryUsage &usage) const noexcept
+    {
+        children.addMemoryUsage(usage, JsonMemoryCategory::ContainerStorage);
+        if (!packed)
+            return;
+
+        usage.containerStorage += sizeof(Packed) + packed->count * sizeof(double);
+        usage.slack += (packed->capacity - packed->count) * sizeof(double);
+
+        // The nodes created for the numbers are not children of the array.
+        std::atomic<JsonNumber *> *boxes = packed->boxes.load(std::memory_order_acquire);
+        if (boxes)
+        {
+            usage.containerStorage += packed->capacity * sizeof(std::atomic<JsonNumber *>);
+            for (size_t i = 0; i < packed->count; i++)
+            {
+                if (boxes[i].load(std::memory_order_relaxed))
+                    usage.nodeHeaders += sizeof(JsonNumber);
+            }
+        }
+    }
+
+    JsonNumber &JsonArray::box(size_t index) const
+    {
+        std::atomic<JsonNumber *> *boxes = packed->boxes.load(std::memory_order_acquire);
+
+        if (!boxes)
+        {
+            std::atomic<JsonNumber *> *created = allocateArray<std::atomic<JsonNumber *>>(arena, packed->capacity, true);
+            for (size_t i = 0; i < packed->capacity; i++)
+                new (created + i) std::atomic<JsonNumber *>(nullptr);
+
+            // Another thread may have created the array first, then we use that one instead.
+            if (packed->boxes.compare_exchange_strong(boxes, created, std::memory_order_acq_rel))
+                boxes = created;
+            else
+                deallocateArray(arena, created);
+        }
+
+        JsonNumber *node = boxes[index].load(std::memory_order_acquire);
+
+        if (!node)
+        {
+            JsonArray *parent = const_cast<JsonArray *>(this);
+            double *slot = packed->numbers + index;
+            JsonNumber *created = arena ? new (arena->allocateConcurrently(sizeof(JsonNumber), alignof(JsonNumber), JsonMemoryCategory::NodeHeaders)) JsonNumber(parent, slot, JsonNumber::ExternalSlot())
+                                        : new JsonNumber(parent, slot, JsonNumber::ExternalSlot());
+
+            if (boxes[index].compare_exchange_strong(node, created, std::memory_order_acq_rel))
+                node = created;
+            else
+                destroy(arena, created);
+        }
+        return *node;
+    }
+
+    void JsonArray::reservePacked(size_t capacity)
+    {
+        if (!packed)
+        {
+            packed = JsonArena::create<Packed>(arena);
+            packed->numbers = nullptr;
+            packed->count = 0;
+            packed->capacity = 0;
+            packed->boxes.store(nullptr, std::memory_order_relaxed);
+        }
+
+        if (capacity <= packed->capacity)
+            return;
+
+        double *numbers = allocateArray<double>(arena, capacity);
+        std::atomic<JsonNumber *> *oldBoxes = packed->boxes.load(std::memory_order_relaxed);
+        std::atomic<JsonNumber *> *boxes = nullptr;
+
+        if (oldBoxes)
+        {
+            try
+            {
+                boxes = allocateArray<std::atomic<JsonNumber *>>(arena, capacity);
+            }
+            catch (...)
+            {
+                deallocateArray(arena, numbers);
+                throw;
+            }
+
+            // The nodes refer to the old buffer, they are moved over to the new one.
+            for (size_t i = 0; i < capacity; i++)
+            {
+                JsonNumber *node = i < packed->count ? oldBoxes[i].load(std::memory_order_relaxed) : nullptr;
+                if (node)
+                    node->slot = numbers + i;
+                new (boxes + i) std::atomic<JsonNumber *>(node);
+            }
+            deallocateArray(arena, oldBoxes);
+        }
+
+        if (packed->count > 0)
+            std::memcpy(numbers, packed->numbers, packed->count * sizeof(double));
+        deallocateArray(arena, packed->numbers);
+
+        packed->numbers = numbers;
+        packed->capacity = capacity;
+        packed->boxes.store(boxes, std::memory_order_relaxed);
+    }
+
+    void JsonArray::unpack()
+    {
+        if (!packed)
+            return;
+
+        std::atomic<JsonNumber *> *boxes = packed->boxes.load(std::memory_order_relaxed);
+
+        // Create the missing nodes first, so that the array is unchanged if we run out of memory.
+        try
+        {
+            children.reserve(packed->count, arena);
+            for (size_t i = 0; i < packed->count; i++)
+            {
+                JsonNumber *node = boxes ? boxes[i].load(std::memory_order_relaxed) : nullptr;
+                children.push_back(node ? nullptr : JsonArena::create<JsonNumber>(arena, this, packed->numbers[i]), arena);
+            }
+        }
+        catch (...)
+        {
+            for (JsonNode *child : children)
+                destroy(arena, child);
+            children.deallocate(arena);
+            throw;
+        }
+
+        // The nodes that were already created keep their address, they only take their value back from the buffer.
+        for (size_t i = 0; i < packed->count && boxes; i++)
+        {
+            JsonNumber *node = boxes[i].exchange(nullptr, std::memory_order_relaxed);
+            if (node)
+            {
+                double value = *node->slot;
+                node->external = false;
+                node->value = value;
+                children[i] = node;
+            }
+        }
+
+        destroyPacked();
+    }
+
+    void JsonArray::destroyPacked() noexcept
+    {
+        if (!packed)
+            return;
+
+        std::atomic<JsonNumber *> *boxes = packed->boxes.load(std::memory_order_relaxed);
+        if (boxes)
+        {
+            for (size_t i = 0; i < packed->count; i++)
+                destroy(arena, boxes[i].load(std::memory_order_relaxed));
+            deallocateArray(arena, boxes);
+        }
+        deallocateArray(arena, packed->numbers);
+
+        if (!arena)
+            delete packed;
+        packed = nullptr;
+    }
+
+    template <typename ChildType, typename... Args>
+    ChildType &JsonArray::addChild(Args &&... args)
+    {
+        checkWritable();
+        unpack();
+
+        // Add the slot first so that the child cannot leak if the vector fails to grow.
+        children.push_back(nullptr, arena);
+        try
+        {
+            children.back() = JsonArena::create<ChildType>(arena, std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            children.pop_back();
+            throw;
+        }
+        return static_cast<ChildType &>(*children.back());
+    }
+
+    template <typename ChildType, typename... Args>
+    ChildType &JsonArray::setChild(size_t index, Args &&... args)
+    {
+        checkWritable();
+        unpack();
+
+        ChildType *child = JsonArena::create<ChildType>(arena, std::forward<Args>(args)...);
+        destroy(arena, children[index]);
+        children[index] = child;
+        return *child;
+    }
+
     JsonArray &JsonArray::addArray()
     {
-        children.emplace_back(new JsonArray(this));
-        return *children.back();
+        return addChild<JsonArray>(this, arena);
     }
 
     JsonObject &JsonArray::addObject()
     {
-        children.emplace_back(new JsonObject(this));
-        return *children.back();
+        return addChild<JsonObject>(this, arena);
     }
 
     JsonBool &JsonArray::addBool(bool value)
     {
-        children.emplace_back(new JsonBool(this, value));
-        return *children.back();
+        return addChild<JsonBool>(this, value);
     }
 
     JsonNull &JsonArray::addNull()
     {
-        children.emplace_back(new JsonNull(this));
-        return *children.back();
+        return addChild<JsonNull>(this);
     }
 
     JsonNumber &JsonArray::addNumber(double value)
     {
-        children.emplace_back(new JsonNumber(this, value));
-        return *children.back();
+        if (!packed)
+            return addChild<JsonNumber>(this, value);
+
+        checkWritable();
+        if (packed->count == packed->capacity)
+            reservePacked(packed->capacity > 0 ? packed->capacity * 2 : 4);
+        packed->numbers[packed->count++] = value;
+        return box(packed->count - 1);
+    }
+
+    void JsonArray::addNumbers(JsonSpan<const double> numbers)
+    {
+        checkWritable();
+        if (!packed && !children.empty())
+        {
+            children.reserve(children.size() + numbers.size(), arena);
+            for (double number : numbers)
+                addChild<JsonNumber>(this, number);
+            return;
+        }
+
+        if (numbers.empty())
+            return;
+
+        size_t count = packed ? packed->count : 0;
+        if (!packed || count + numbers.size() > packed->capacity)
+            reservePacked(count + numbers.size());
+
+        std::memcpy(packed->numbers + count, numbers.data(), numbers.size() * sizeof(double));
+        packed->count += numbers.size();
     }
 
     JsonString &JsonArray::addString(const std::string &value)
     {
-        children.emplace_back(new JsonString(this, value));
-        return *children.back();
+        return addChild<JsonString>(this, arena, JsonStringView(value));
     }
 
     JsonString &JsonArray::addString(std::string &&value)
     {
-        children.emplace_back(new JsonString(this, std::move(value)));
-        return *children.back();
+        if (arena)
+            return addChild<JsonString>(this, arena, JsonStringView(value));
+        return addChild<JsonString>(this, std::move(value));
     }
 
     JsonArray &JsonArray::setArray(size_t index)
     {
-        children[index] = std::unique_ptr<JsonArray>(new JsonArray(this));
-        return *children[index];
+        return setChild<JsonArray>(index, this, arena);
     }
 
     JsonObject &JsonArray::setObject(size_t index)
     {
-        children[index] = std::unique_ptr<JsonObject>(new JsonObject(this));
-        return *children[index];
+        return setChild<JsonObject>(index, this, arena);
     }
 
     JsonBool &JsonArray::setBool(size_t index, bool value)
     {
-        children[index] = std::unique_ptr<JsonBool>(new JsonBool(this, value));
-        return *children[index];
+        return setChild<JsonBool>(index, this, value);
     }
 
     JsonNull &JsonArray::setNull(size_t index)
     {
-        children[index] = std::unique_ptr<JsonNull>(new JsonNull(this));
-        return *children[index];
+        return setChild<JsonNull>(index, this);
     }
 
     JsonNumber &JsonArray::setNumber(size_t index, double value)
     {
-        children[index] = std::unique_ptr<JsonNumber>(new JsonNumber(this, value));
-        return *children[index];
+        if (!packed)
+            return setChild<JsonNumber>(index, this, value);
+
+        checkWritable();
+
+        // The old node is replaced by a new one, just like in an array that is not packed.
+        std::atomic<JsonNumber *> *boxes = packed->boxes.load(std::memory_order_relaxed);
+        if (boxes)
+            destroy(arena, boxes[index].exchange(nullptr, std::memory_order_relaxed));
+        packed->numbers[index] = value;
+        return box(index);
     }
 
     JsonString &JsonArray::setString(size_t index, const std::string &value)
     {
-        children[index] = std::unique_ptr<JsonString>(new JsonString(this, value));
-        return *children[index];
+        return setChild<JsonString>(index, this, arena, JsonStringView(value));
     }
 
     JsonString &JsonArray::setString(size_t index, std::string &&value)
     {
-        children[index] = std::unique_ptr<JsonString>(new JsonString(this, std::move(value)));
-        return *children[index];
+        if (arena)
+            return setChild<JsonString>(index, this, arena, JsonStringView(value));
+        return setChild<JsonString>(index, this, std::move(value));
     }
 
     bool JsonArray::empty() const noexcept
     {
-        return children.empty();
+        return getChildCount() == 0;
     }
 
     size_t JsonArray::getChildCount() const noexcept
     {
-        return children.size();
+        return packed ? packed->count : children.size();
     }
 
     JsonNode &JsonArray::getChild(size_t index)
     {
-        return *children[index];
+        return writableChild(index);
     }
 
     const JsonNode &JsonArray::getChild(size_t index) const
     {
-        return *children[index];
+        return childAt(index);
     }
 
     void JsonArray::removeChild(size_t index)
     {
-        children.erase(children.begin() + index);
+        checkWritable();
+        if (!packed)
+        {
+            destroy(arena, children[index]);
+            children.erase(index);
+            return;
+        }
+
+        size_t following = packed->count - index - 1;
+        std::memmove(packed->numbers + index, packed->numbers + index + 1, following * sizeof(double));
+
+        std::atomic<JsonNumber *> *boxes = packed->boxes.load(std::memory_order_relaxed);
+        if (boxes)
+        {
+            destroy(arena, boxes[index].load(std::memory_order_relaxed));
+            for (size_t i = index; i + 1 < packed->count; i++)
+            {
+                JsonNumber *node = boxes[i + 1].load(std::memory_order_relaxed);
+                if (node)
+                    node->slot = packed->numbers + i;
+                boxes[i].store(node, std::memory_order_relaxed);
+            }
+            boxes[packed->count - 1].store(nullptr, std::memory_order_relaxed);
+        }
+        packed->count--;
+    }
+
+    void JsonArray::reserve(size_t capacity)
+    {
+        checkWritable();
+        if (packed)
+            reservePacked(capacity);
+        else
+            children.reserve(capacity, arena);
+    }
+
+    void JsonArray::appendChild(JsonNode *child)
+    {
+        unpack();
+        children.push_back(child, arena);
+    }
+
+    JsonDocument JsonArray::detach(size_t index)
+    {
+        checkWritable();
+        unpack();
+
+        JsonNode *child = &unshare(arena, this, children[index]);
+        JsonDocument subtree = JsonDocument::adopt(arena, child);
+        children.erase(index);
+        setParent(child, nullptr);
+        return subtree;
+    }
+
+    JsonNode &JsonArray::attach(JsonDocument &&subtree)
+    {
+        return attach(getChildCount(), std::move(subtree));
+    }
+
+    JsonNode &JsonArray::attach(size_t index, JsonDocument &&subtree)
+    {
+        checkWritable();
+        JsonDocument::Transfer transfer(subtree, *this, arena);
+        JsonNode *child = transfer.getNode();
+
+        unpack();
+        children.insert(index, child, arena);
+        transfer.commit();
+        setParent(child, this);
+        return *child;
+    }
+
+    JsonNode &JsonArray::splice(size_t index, JsonArray &source, size_t sourceIndex)
+    {
+        JsonDocument subtree = source.detach(sourceIndex);
+        try
+        {
+            return attach(index, std::move(subtree));
+        }
+        catch (...)
+        {
+            // Put the child back where it came from.
+            source.attach(sourceIndex, std::move(subtree));
+            throw;
+        }
+    }
+
+    bool JsonArray::isPacked() const noexcept
+    {
+        return packed != nullptr;
+    }
+
+    bool JsonArray::pack()
+    {
+        checkWritable();
+        if (packed)
+            return true;
+
+        // A number whose text would be written differently from its value keeps its node, see JsonNumber::formatsAs().
+        for (JsonNode *child : children)
+        {
+            if (child->getType() != JsonNodeType::Number)
+                return false;
+            const JsonNumber &number = static_cast<const JsonNumber &>(*child);
+            if (number.hasText() && !JsonNumber::formatsAs(number.data(), number.getText()))
+                return false;
+        }
+
+        reservePacked(children.size());
+        for (JsonNode *child : children)
+        {
+            packed->numbers[packed->count++] = child->toNumber();
+            destroy(arena, child);
+        }
+        children.deallocate(arena);
+        return true;
+    }
+
+    JsonSpan<double> JsonArray::getNumbers()
+    {
+        checkWritable();
+        if (!packed)
+            throw std::runtime_error("JsonArray is not packed");
+        return JsonSpan<double>(packed->numbers, packed->count);
+    }
+
+    JsonSpan<const double> JsonArray::getNumbers() const
+    {
+        if (!packed)
+            throw std::runtime_error("JsonArray is not packed");
+        return JsonSpan<const double>(packed->numbers, packed->count);
     }
 
     using iterator = JsonArray::iterator;
 
-    iterator::iterator(std::vector<std::unique_ptr<JsonNode>>::iterator it) : it(it)
+    iterator::iterator(JsonArray *array, size_t index) : array(array), index(index)
     {
     }
 
     iterator iterator::operator++()
     {
-        return ++it;
+        index++;
+        return *this;
     }
 
     iterator iterator::operator++(int)
     {
-        return it++;
+        return iterator(array, index++);
     }
 
     iterator iterator::operator+(int value)
     {
-        return it + value;
+        return iterator(array, index + value);
     }
 
     iterator iterator::operator-(int value)
     {
-        return it - value;
+        return iterator(array, index - value);
     }
 
     bool iterator::operator!=(const iterator &rhs)
     {
-        return it != rhs.it;
+        return index != rhs.index || array != rhs.array;
     }
 
     bool iterator::operator==(const iterator &rhs)
     {
-        return it == rhs.it;
+        return index == rhs.index && array == rhs.array;
     }
 
     bool iterator::operator<(const iterator &rhs)
     {
-        return it < rhs.it;
+        return index < rhs.index;
     }
 
     bool iterator::operator<=(const iterator &rhs)
     {
-        return it <= rhs.it;
+        return index <= rhs.index;
     }
 
     bool iterator::operator>(const iterator &rhs)
     {
-        return it > rhs.it;
+        return index > rhs.index;
     }
 
     bool iterator::operator>=(const iterator &rhs)
     {
-        return it >= rhs.it;
+        return index >= rhs.index;
     }
 
     JsonNode &iterator::operator*()
     {
-        return **it;
+        return array->writableChild(index);
     }
 
     using const_iterator = JsonArray::const_iterator;
 
-    const_iterator::const_iterator(std::vector<std::unique_ptr<JsonNode>>::const_iterator it) : it(it)
+    const_iterator::const_iterator(const JsonArray *array, size_t index) : array(array), index(index)
     {
     }
 
     const_iterator const_iterator::operator++()
     {
-        return ++it;
+        index++;
+        return *this;
     }
 
     const_iterator const_iterator::operator++(int)
     {
-        return it++;
+        return const_iterator(array, index++);
     }
 
     const_iterator const_iterator::operator+(int value)
     {
-        return it + value;
+        return const_iterator(array, index + value);
     }
 
     const_iterator const_iterator::operator-(int value)
     {
-        return it - value;
+        return const_iterator(array, index - value);
     }
 
     bool const_iterator::operator!=(const const_iterator &rhs)
     {
-        return it != rhs.it;
+        return index != rhs.index || array != rhs.array;
     }
 
     bool const_iterator::operator==(const const_iterator &rhs)
     {
-        return it == rhs.it;
+        return index == rhs.index && array == rhs.array;
     }
 
     bool const_iterator::operator<(const const_iterator &rhs)
     {
-        return it < rhs.it;
+        return index < rhs.index;
     }
 
     bool const_iterator::operator<=(const const_iterator &rhs)
     {
-        return it <= rhs.it;
+        return index <= rhs.index;
     }
 
     bool const_iterator::operator>(const const_iterator &rhs)
     {
-        return it > rhs.it;
+        return index > rhs.index;
     }
 
     bool const_iterator::operator>=(const const_iterator &rhs)
     {
-        return it >= rhs.it;
+        return index >= rhs.index;
     }
 
     const JsonNode &const_iterator::operator*() const
     {
-        return **it;
+        return array->childAt(index);
     }
 
     iterator JsonArray::begin()
     {
-        return iterator(children.begin());
+        return iterator(this, 0);
     }
 
     iterator JsonArray::end()
     {
-        return iterator(children.end());
+        return iterator(this, getChildCount());
     }
 
     const_iterator JsonArray::begin() const
     {
-        return const_iterator(children.begin());
+        return const_iterator(this, 0);
     }
 
     const_iterator JsonArray::end() const
     {
-        return const_iterator(children.end());
+        return const_iterator(this, getChildCount());
     }
 
-} // namespace json
\ No newline at end of file
+} // namespace json
@@ -26,31 +26,24 @@ THE SOFTWARE.
 
 namespace json
 {
-    JsonBool::JsonBool(bool value) : JsonNode(), value(value)
+    JsonBool::JsonBool(bool value) : JsonNode(JsonNodeType::Bool), value(value)
     {
     }
 
-    JsonBool::JsonBool(JsonNode *parent, bool value) : JsonNode(parent), value(value)
+    JsonBool::JsonBool(JsonNode *parent, bool value) : JsonNode(parent, JsonNodeType::Bool), value(value)
     {
     }
 
-    JsonNodeType JsonBool::getType() const noexcept
-    {
-        return JsonNodeType::Bool;
-    }
-
-    JsonBool &JsonBool::toBool()
-    {
-        return *this;
-    }
-
-    const JsonBool &JsonBool::toBool() const
+    JsonBool &JsonBool::operator=(bool value)
     {
+        checkWritable();
+        this->value = value;
         return *this;
     }
 
-    bool &JsonBool::data() noexcept
+    bool &JsonBool::data()
     {
+        checkWritable();
         return value;
     }
 
@@ -61,7 +54,7 @@ namespace json
 
     JsonBool::operator bool &()
     {
-        return value;
+        return data();
     }
 
     JsonBool::operator const bool &() const
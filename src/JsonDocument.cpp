@@ -30,60 +30,113 @@ THE SOFTWARE.
 #include "JsonNumber.hpp"
 #include "JsonString.hpp"
 #include "JsonParser.hpp"
+#include "JsonParallelSerializer.hpp"
 
 #include <fstream>
 #include <sstream>
+#include <vector>
 
 namespace json
 {
-    JsonDocument::JsonDocument() : root(nullptr)
+    namespace
+    {
+        void deleteText(void *text)
+        {
+            delete static_cast<std::string *>(text);
+        }
+    } // namespace
+
+    JsonDocument::JsonDocument() : root(nullptr), rootInArena(false)
+    {
+    }
+
+    JsonDocument::JsonDocument(JsonNodePtr root) : root(root.release()), rootInArena(false)
     {
     }
 
-    JsonDocument::JsonDocument(std::unique_ptr<JsonNode> root) : root(std::move(root))
+    JsonDocument::JsonDocument(JsonDocument &&other) noexcept
+        : arena(std::move(other.arena)), root(other.root), rootInArena(other.rootInArena)
     {
+        other.root = nullptr;
+        other.rootInArena = false;
+    }
+
+    JsonDocument &JsonDocument::operator=(JsonDocument &&other) noexcept
+    {
+        if (this != &other)
+        {
+            destroyRoot();
+            arena = std::move(other.arena);
+            root = other.root;
+            rootInArena = other.rootInArena;
+            other.root = nullptr;
+            other.rootInArena = false;
+        }
+        return *this;
+    }
+
+    JsonDocument::~JsonDocument()
+    {
+        destroyRoot();
     }
 
     JsonArray &JsonDocument::setArrayAsRoot()
     {
-        root = std::unique_ptr<JsonArray>(new JsonArray());
-        return *root;
+        JsonArray *array = JsonArena::create<JsonArray>(&getArena(), nullptr, &getArena());
+        destroyRoot();
+        root = array;
+        rootInArena = true;
+        return *array;
     }
 
     JsonObject &JsonDocument::setObjectAsRoot()
     {
-        root = std::unique_ptr<JsonObject>(new JsonObject());
-        return *root;
+        JsonObject *object = JsonArena::create<JsonObject>(&getArena(), nullptr, &getArena());
+        destroyRoot();
+        root = object;
+        rootInArena = true;
+        return *object;
     }
 
     JsonBool &JsonDocument::setBoolAsRoot(bool value)
     {
-        root = std::unique_ptr<JsonBool>(new JsonBool(value));
-        return *root;
+        JsonBool *node = JsonArena::create<JsonBool>(&getArena(), nullptr, value);
+        destroyRoot();
+        root = node;
+        rootInArena = true;
+        return *node;
     }
 
     JsonNull &JsonDocument::setNullAsRoot()
     {
-        root = std::unique_ptr<JsonNull>(new JsonNull());
-        return *root;
+        JsonNull *node = JsonArena::create<JsonNull>(&getArena(), nullptr);
+        destroyRoot();
+        root = node;
+        rootInArena = true;
+        return *node;
     }
 
     JsonNumber &JsonDocument::setNumberAsRoot(double value)
     {
-        root = std::unique_ptr<JsonNumber>(new JsonNumber(value));
-        return *root;
+        JsonNumber *node = JsonArena::create<JsonNumber>(&getArena(), nullptr, value);
+        destroyRoot();
+        root = node;
+        rootInArena = true;
+        return *node;
     }
 
     JsonString &JsonDocument::setStringAsRoot(const std::string &value)
     {
-        root = std::unique_ptr<JsonString>(new JsonString(value));
-        return *root;
+        JsonString *node = JsonArena::create<JsonString>(&getArena(), nullptr, &getArena(), JsonStringView(value));
+        destroyRoot();
+        root = node;
+        rootInArena = true;
+        return *node;
     }
 
     JsonString &JsonDocument::setStringAsRoot(std::string &&value)
     {
-        root = std::unique_ptr<JsonString>(new JsonString(std::move(value)));
-        return *root;
+        return setStringAsRoot(value);
     }
 
     bool JsonDocument::hasRoot() const noexcept
@@ -92,35 +145,159 @@ namespace json
     }
 
     JsonNode &JsonDocument::getRoot()
+    {
+        // The root is shared with a snapshot, so this document gets a copy of its own.
+        if (root && root->isShared())
+        {
+            JsonNode *copied = JsonNode::copy(rootInArena ? arena.get() : nullptr, nullptr, *root);
+            destroyRoot();
+            root = copied;
+        }
+        return *root;
+    }
+
+    const JsonNode &JsonDocument::getRoot() const
     {
         return *root;
     }
 
+    JsonDocument JsonDocument::snapshot() const
+    {
+        JsonDocument doc;
+        if (!root)
+            return doc;
+
+        // The other document keeps allocating from the arena while the snapshot is read.
+        if (arena)
+            arena->setSynchronized(true);
+
+        doc.arena = arena;
+        doc.root = JsonNode::share(root);
+        doc.rootInArena = rootInArena;
+
+        // References to the nodes below the root may have been taken before, they must no longer be used for changes.
+        JsonNode::beginEpoch();
+        return doc;
+    }
+
+    JsonDocument JsonDocument::clone() const
+    {
+        return clone(JsonStringPool::createShared(0, getMemoryResource()));
+    }
+
+    JsonDocument JsonDocument::clone(std::shared_ptr<JsonStringPool> pool) const
+    {
+        if (!root)
+            return JsonDocument();
+
+        // The copy takes no more memory than the arena has handed out for this document, apart from padding,
+        // so one chunk holds all of it.
+        size_t size = arena && rootInArena ? arena->getBytesUsed() : 0;
+        return clone(*root, std::move(pool), size + size / 8, getMemoryResource());
+    }
+
+    size_t JsonDocument::compact()
+    {
+        return rebuild(false);
+    }
+
+    size_t JsonDocument::deduplicate()
+    {
+        return rebuild(true);
+    }
+
+    size_t JsonDocument::rebuild(bool deduplicate)
+    {
+        if (!root)
+            return 0;
+
+        size_t before = memoryUsage().getBytesReserved();
+
+        // The tree is measured first, so that the new arena is a single chunk, with some room for padding.
+        JsonNode::DuplicateMap duplicates;
+        size_t size = deduplicate ? JsonNode::findDuplicates(*root, duplicates).getBytesUsed() : root->memoryUsage().getBytesUsed();
+        JsonDocument compacted;
+        JsonMemoryResource *resource = getMemoryResource();
+        compacted.arena = JsonArena::createShared(size + size / 8, resource);
+        compacted.arena->setStringPool(arena ? arena->getSharedStringPool() : JsonStringPool::createShared(0, resource));
+        compacted.root = JsonNode::relayout(compacted.arena.get(), *root, deduplicate ? &duplicates : nullptr);
+        compacted.rootInArena = true;
+        *this = std::move(compacted);
+
+        size_t after = memoryUsage().getBytesReserved();
+        return before > after ? before - after : 0;
+    }
+
+    std::shared_ptr<JsonStringPool> JsonDocument::getStringPool()
+    {
+        return getArena().getSharedStringPool();
+    }
+
+    JsonMemoryUsage JsonDocument::memoryUsage() const
+    {
+        JsonMemoryUsage usage;
+        if (arena)
+            usage += arena->getMemoryUsage();
+        if (root && !rootInArena)
+            usage += root->memoryUsage();
+        return usage;
+    }
+
     void JsonDocument::writeToStream(std::ostream &output, size_t tabSize) const
     {
+        writeToStream(output, JsonFormat::indented(tabSize));
+    }
+
+    void JsonDocument::writeToStream(std::ostream &output, const JsonFormat &format) const
+    {
+        if (hasRoot())
+        {
+            JsonOutputBuffer buffer(output);
+            JsonParallelSerializer serializer(buffer, format);
+            serializer.write(*root);
+            buffer.flush();
+        }
+    }
+
+    void JsonDocument::writeToString(std::string &output, const JsonFormat &format) const
+    {
+        output.clear();
         if (hasRoot())
         {
-            writeNode(output, *root, "", tabSize);
+            JsonOutputBuffer buffer(output);
+            JsonParallelSerializer serializer(buffer, format);
+            serializer.write(*root);
+            buffer.flush();
         }
     }
 
     void JsonDocument::saveToFile(const std::string &filePath, size_t tabSize) const
+    {
+        saveToFile(filePath, JsonFormat::indented(tabSize));
+    }
+
+    void JsonDocument::saveToFile(const std::string &filePath, const JsonFormat &format) const
     {
         std::ofstream output(filePath);
 
         if (!output.is_open())
             throw std::runtime_error("Could not open file: " + filePath);
 
-        writeToStream(output, tabSize);
+        writeToStream(output, format);
 
         output.close();
     }
 
     std::string JsonDocument::toString(size_t tabSize) const
     {
-        std::ostringstream output;
-        writeToStream(output, tabSize);
-        return output.str();
+        return toString(JsonFormat::indented(tabSize));
+    }
+
+    std::string JsonDocument::toString(const JsonFormat &format) const
+    {
+        std::string output;
+        writeToString(output, format);
+        return output;
     }
 
     JsonDocument JsonDocument::create()
@@ -128,12 +305,34 @@ namespace json
         return JsonDocument();
     }
 
+    JsonDocument JsonDocument::create(JsonMemoryResource *resource)
+    {
+        JsonDocument doc;
+        doc.arena = JsonArena::createShared(0, resource);
+        doc.arena->setStringPool(JsonStringPool::createShared(0, resource));
+        return doc;
+    }
+
     JsonDocument JsonDocument::createFromStream(std::istream &input)
+    {
+        return createFromStream(input, std::make_shared<JsonStringPool>());
+    }
+
+    JsonDocument JsonDocument::createFromStream(std::istream &input, std::shared_ptr<JsonStringPool> pool)
+    {
+        return createFromStream(input, std::move(pool), JsonMemoryResource::getDefault());
+    }
+
+    JsonDocument JsonDocument::createFromStream(std::istream &input, std::shared_ptr<JsonStringPool> pool, JsonMemoryResource *resource)
     {
         if (!input.good())
             throw std::runtime_error("The input stream was bad");
-        std::unique_ptr<JsonNode> root = JsonParser::parse(input);
-        return JsonDocument(std::move(root));
+        JsonDocument doc;
+        doc.arena = JsonArena::createShared(0, resource);
+        doc.arena->setStringPool(std::move(pool));
+        doc.root = JsonParser::parse(input, *doc.arena);
+        doc.rootInArena = true;
+        return doc;
     }
 
     JsonDocument JsonDocument::createFromFile(const std::string &filePath)
@@ -154,80 +353,211 @@ namespace json
         return createFromStream(input);
     }
 
-    void JsonDocument::writeNode(std::ostream &output, const JsonNode &node, std::string indent, size_t tabSize)
+    JsonDocument JsonDocument::createFromString(const std::string &jsonText, std::shared_ptr<JsonStringPool> pool)
+    {
+        std::istringstream input(jsonText);
+        return createFromStream(input, std::move(pool));
+    }
+
+    JsonDocument JsonDocument::createFromString(const std::string &jsonText, std::shared_ptr<JsonStringPool> pool, JsonMemoryResource *resource)
+    {
+        std::istringstream input(jsonText);
+        return createFromStream(input, std::move(pool), resource);
+    }
+
+    JsonDocument JsonDocument::createInSitu(char *buffer, size_t size)
+    {
+        return createInSitu(buffer, size, std::make_shared<JsonStringPool>());
+    }
+
+    JsonDocument JsonDocument::createInSitu(char *buffer, size_t size, std::shared_ptr<JsonStringPool> pool)
+    {
+        return createInSitu(buffer, size, std::move(pool), JsonMemoryResource::getDefault());
+    }
+
+    JsonDocument JsonDocument::createInSitu(char *buffer, size_t size, std::shared_ptr<JsonStringPool> pool, JsonMemoryResource *resource)
+    {
+        JsonDocument doc;
+        doc.arena = JsonArena::createShared(0, resource);
+        doc.arena->setStringPool(std::move(pool));
+        doc.root = JsonParser::parse(buffer, size, *doc.arena);
+        doc.rootInArena = true;
+        return doc;
+    }
+
+    JsonDocument JsonDocument::createInSitu(std::string &&jsonText)
     {
-        switch (node.getType())
+        return createInSitu(std::move(jsonText), std::make_shared<JsonStringPool>());
+    }
+
+    JsonDocument JsonDocument::createInSitu(std::string &&jsonText, std::shared_ptr<JsonStringPool> pool)
+    {
+        JsonDocument doc;
+        doc.arena = JsonArena::createShared();
+        doc.arena->setStringPool(std::move(pool));
+
+        // The arena owns the text, the strings of the document refer to it.
+        std::unique_ptr<std::string> text(new std::string(std::move(jsonText)));
+        doc.arena->addCleanup(deleteText, text.get());
+        std::string *owned = text.release();
+
+        JsonMemoryUsage usage;
+        usage.valueStrings = owned->size();
+        usage.slack = owned->capacity() - owned->size();
+        doc.arena->account(usage);
+
+        doc.root = JsonParser::parse(&(*owned)[0], owned->size(), *doc.arena);
+        doc.rootInArena = true;
+        return doc;
+    }
+
+    JsonArena &JsonDocument::getArena()
+    {
+        if (!arena)
         {
-        case JsonNodeType::Array:
+            arena = JsonArena::createShared();
+            arena->setStringPool(std::make_shared<JsonStringPool>());
+        }
+        return *arena;
+    }
+
+    JsonMemoryResource *JsonDocument::getMemoryResource() const noexcept
+    {
+        return arena ? arena->getMemoryResource() : JsonMemoryResource::getDefault();
+    }
+
+    JsonDocument::Transfer::Transfer(JsonDocument &document, const JsonNode &container, JsonArena *arena)
+        : document(document), holder(nullptr)
+    {
+        if (!document.root)
+            throw std::runtime_error("The document has no root to attach");
+
+        // Attaching a subtree to one of its own descendants would create a cycle.
+        for (const JsonNode *node = &container;; node = &node->getParent())
         {
-            const JsonArray &array = node;
+            if (node == document.root)
+                throw std::runtime_error("A subtree can not be attached to itself");
+            if (!node->hasParent())
+                break;
+        }
 
-            output << '[';
+        std::shared_ptr<JsonArena> source = document.rootInArena ? document.arena : nullptr;
 
-            // If the array is empty we would like to print [] without a newline in the middle.
-            if (!array.empty())
-                output << '\n';
+        // If the arena of the subtree already keeps the arena of the container alive, for example because subtrees
+        // were moved in the other direction before, retaining it would keep both arenas alive forever.
+        // The container takes a deep copy of its own instead.
+        if (arena && source && source.get() != arena && source->isRetaining(arena))
+        {
+            JsonNode *copied = JsonNode::copyTree(arena, nullptr, *document.root);
+            document.destroyRoot();
+            document.root = copied;
+            document.arena = arena->getShared();
+            return;
+        }
 
-            // Calculate new indent for child nodes.
-            std::string newIndent = indent + std::string(tabSize, ' ');
+        // A shared root can not get a new parent, so the container takes a copy instead.
+        if (document.root->isShared())
+        {
+            JsonNode *copied = JsonNode::copy(arena, nullptr, *document.root);
+            document.destroyRoot();
+            document.root = copied;
+            document.rootInArena = arena != nullptr;
+            document.arena = arena ? arena->getShared() : nullptr;
+
+            // The copy shares the children of the root, which live in the arena of the subtree.
+            if (arena && source)
+                arena->retain(source);
+        }
 
-            for (const JsonNode &child : array)
-            {
-                output << newIndent;
-                writeNode(output, child, newIndent, tabSize);
-                if (&child != &array[array.getChildCount() - 1]) // If last child don't print ','.
-                    output << ',';
-                output << '\n';
-            }
+        if (!arena)
+        {
+            // A container without an arena deletes its children, so it can only take nodes allocated with new.
+            if (document.rootInArena)
+                throw std::runtime_error("A subtree living in an arena can not be attached to a container without an arena");
+            return;
+        }
 
-            // Same reasoning as previous array.empty() check, we don't want spaces in the middle of [].
-            if (!array.empty())
-                output << indent;
+        if (document.rootInArena)
+        {
+            arena->retain(document.arena);
+            return;
+        }
 
-            output << ']';
+        // The container does not delete its children, so the arena will delete the root when it is destroyed.
+        // The holder stays empty until the transfer is committed.
+        JsonMemoryUsage usage = document.root->memoryUsage();
+        holder = new JsonNode *(nullptr);
+        try
+        {
+            arena->addCleanup(release, holder);
         }
-        break;
-        case JsonNodeType::Object:
+        catch (...)
         {
-            const JsonObject &object = node;
-            output << '{';
-
-            if (!object.empty())
-                output << '\n';
-
-            std::string newIndent = indent + std::string(tabSize, ' ');
-
-            // We want the pairs to be printed based on the insertion order therefore we sort the object first.
-            // This is not necessary and will have a performance cost, but it's pretty and therefore we do it.
-            std::vector<std::pair<const std::string &, const JsonNode &>> children = object.sort();
-            for (const auto &pair : children)
-            {
-                output << newIndent << '\"' << pair.first << '\"' << ": ";
-                writeNode(output, pair.second, newIndent, tabSize);
-                if (&pair.second != &children[children.size() - 1].second)
-                    output << ',';
-                output << '\n';
-            }
-
-            if (!object.empty())
-                output << indent;
-
-            output << '}';
+            delete holder;
+            throw;
         }
-        break;
-        case JsonNodeType::Bool:
-            output << (node.toBool() ? "true" : "false");
-            break;
-        case JsonNodeType::Null:
-            output << "null";
-            break;
-        case JsonNodeType::Number:
-            output << node.toNumber();
-            break;
-        case JsonNodeType::String:
-            output << '\"' << node.toString().escaped() << '\"';
-            break;
+
+        // The arena counts the subtree from now on, since it keeps it alive.
+        arena->account(usage);
+    }
+
+    JsonNode *JsonDocument::Transfer::getNode() const noexcept
+    {
+        return document.root;
+    }
+
+    void JsonDocument::Transfer::release(void *holder)
+    {
+        JsonNode *node = *static_cast<JsonNode **>(holder);
+
+        // Copies of the container in the same arena may still count as holding the node, but they are released
+        // together with the arena, so the node is deleted whatever its count is.
+        if (node)
+        {
+            node->references.store(1, std::memory_order_relaxed);
+            JsonNodeDeleter()(node);
+        }
+        delete static_cast<JsonNode **>(holder);
+    }
+
+    void JsonDocument::Transfer::commit() noexcept
+    {
+        if (holder)
+            *holder = document.root;
+        document.root = nullptr;
+        document.rootInArena = false;
+        document.arena.reset();
+    }
+
+    JsonDocument JsonDocument::adopt(JsonArena *arena, JsonNode *node)
+    {
+        JsonDocument doc;
+        if (arena)
+        {
+            doc.arena = arena->getShared();
+            if (!doc.arena)
+                throw std::runtime_error("Only subtrees of a JsonDocument or of an arena created with createShared() can be detached");
         }
+        doc.root = node;
+        doc.rootInArena = arena != nullptr;
+        return doc;
+    }
+
+    JsonDocument JsonDocument::clone(const JsonNode &node, std::shared_ptr<JsonStringPool> pool, size_t initialChunkSize,
+                                     JsonMemoryResource *resource)
+    {
+        JsonDocument doc;
+        doc.arena = JsonArena::createShared(initialChunkSize, resource);
+        doc.arena->setStringPool(std::move(pool));
+        doc.root = JsonNode::copyTree(doc.arena.get(), nullptr, node);
+        doc.rootInArena = true;
+        return doc;
+    }
+
+    void JsonDocument::destroyRoot() noexcept
+    {
+        JsonNode::destroy(rootInArena ? arena.get() : nullptr, root);
+        root = nullptr;
     }
 
 } // namespace json
\ No newline at end of file
@@ -24,6 +24,8 @@ THE SOFTWARE.
 
 #include "JsonLexer.hpp"
 
+#include <cctype>
+#include <cstring>
 #include <istream>
 
 namespace json
@@ -37,34 +39,53 @@ namespace json
     }
 
     JsonToken JsonLexer::nextToken(std::istream &input)
+    {
+        JsonToken token(JsonTokenType::EndOfFile);
+        nextToken(input, token);
+        return token;
+    }
+
+    void JsonLexer::nextToken(std::istream &input, JsonToken &token)
     {
         char c;
 
+        // Clearing the value keeps its capacity, so the next string or number can be read without allocating.
+        token.value.clear();
+
         if (input >> c)
         {
             switch (c)
             {
             case '[':
-                return {JsonTokenType::BeginArray};
+                token.type = JsonTokenType::BeginArray;
+                return;
             case '{':
-                return {JsonTokenType::BeginObject};
+                token.type = JsonTokenType::BeginObject;
+                return;
             case ']':
-                return {JsonTokenType::EndArray};
+                token.type = JsonTokenType::EndArray;
+                return;
             case '}':
-                return {JsonTokenType::EndObject};
+                token.type = JsonTokenType::EndObject;
+                return;
             case ':':
-                return {JsonTokenType::NameSeparator};
+                token.type = JsonTokenType::NameSeparator;
+                return;
             case ',':
-                return {JsonTokenType::ValueSeparator};
+                token.type = JsonTokenType::ValueSeparator;
+                return;
             case 'f':
                 read(input, "alse"); // Make sure that the next characters in the stream are 'a', 'l', 's' and 'e'.
-                return {JsonTokenType::False};
+                token.type = JsonTokenType::False;
+                return;
             case 't':
                 read(input, "rue");
-                return {JsonTokenType::True};
+                token.type = JsonTokenType::True;
+                return;
             case 'n':
                 read(input, "ull");
-                return {JsonTokenType::Null};
+                token.type = JsonTokenType::Null;
+                return;
             case '-':
             case '0':
             case '1':
@@ -76,15 +97,21 @@ namespace json
             case '7':
             case '8':
             case '9':
-                return {JsonTokenType::Number, readNumber(input, c)};
+                token.type = JsonTokenType::Number;
+                readNumber(input, c, token.value);
+                token.text = JsonStringView(token.value);
+                return;
             case '\"':
-                return {JsonTokenType::String, readString(input)};
+                token.type = JsonTokenType::String;
+                readString(input, token.value);
+                token.text = JsonStringView(token.value);
+                return;
             default:
                 throw std::runtime_error("Found illegal character: '" + std::string(1, c) + "'");
             }
         }
 
-        return {JsonTokenType::EndOfFile};
+        token.type = JsonTokenType::EndOfFile;
     }
 
     void JsonLexer::read(std::istream &input, const std::string &str)
@@ -104,9 +131,8 @@ namespace json
         }
     }
 
-    std::string JsonLexer::readNumber(std::istream &input, char previous)
+    void JsonLexer::readNumber(std::istream &input, char previous, std::string &number)
     {
-        std::string number;
         char c = previous;
 
         // Check for optional minus.
@@ -123,7 +149,7 @@ namespace json
         // doesn't start with zero. For example "0123" is not a valid number.
         if (c != '0')
         {
-            number += readDigits(input);
+            readDigits(input, number);
         }
 
         // Check for optional fraction and exponent.
@@ -132,28 +158,25 @@ namespace json
             c = static_cast<char>(input.peek());
             if (c == '.')
             {
-                number += readFraction(input);
+                readFraction(input, number);
                 if (!input.eof())
                 {
                     c = static_cast<char>(input.peek());
                     if (c == 'e' || c == 'E')
                     {
-                        number += readExponent(input);
+                        readExponent(input, number);
                     }
                 }
             }
             else if (c == 'e' || c == 'E')
             {
-                number += readExponent(input);
+                readExponent(input, number);
             }
         }
-
-        return number;
     }
 
-    std::string JsonLexer::readDigits(std::istream &input)
+    void JsonLexer::readDigits(std::istream &input, std::string &digits)
     {
-        std::string digits;
         char c;
         while (input.get(c))
         {
@@ -168,26 +191,23 @@ namespace json
                 break;
             }
         }
-        return digits;
     }
 
-    std::string JsonLexer::readFraction(std::istream &input)
+    void JsonLexer::readFraction(std::istream &input, std::string &fraction)
     {
-        std::string fraction = ".";
         char c;
+        fraction += '.';
         input.get(); // This will return a decimal point.
 
         if (!(input.get(c)) || !isdigit(c))
             throw std::runtime_error("After a decimal point there must be at least one digit");
 
         fraction += c;
-        fraction += readDigits(input);
-        return fraction;
+        readDigits(input, fraction);
     }
 
-    std::string JsonLexer::readExponent(std::istream &input)
+    void JsonLexer::readExponent(std::istream &input, std::string &exponent)
     {
-        std::string exponent;
         char c;
         input.get(c);
 
@@ -207,23 +227,21 @@ namespace json
             throw std::runtime_error("A valid exponent requires at least one digit");
 
         exponent += c;
-        exponent += readDigits(input);
-        return exponent;
+        readDigits(input, exponent);
     }
 
-    std::string JsonLexer::readString(std::istream &input)
+    void JsonLexer::readString(std::istream &input, std::string &string)
     {
-        std::string string;
         char c;
 
         while (true)
         {
             if (input.get(c))
             {
-                if (c == '\"') // We reached ending quotation mark, lets break the loop and return the string.
+                if (c == '\"') // We reached ending quotation mark, lets break the loop.
                     break;
                 else if (c == '\\') // Escape sequence found.
-                    string += readEscapeSequence(input);
+                    readEscapeSequence(input, string);
                 else
                     string += c;
             }
@@ -232,13 +250,10 @@ namespace json
                 throw std::runtime_error("Could not read the next character");
             }
         }
-
-        return string;
     }
 
-    std::string JsonLexer::readEscapeSequence(std::istream &input)
+    void JsonLexer::readEscapeSequence(std::istream &input, std::string &escaped)
     {
-        std::string escaped;
         char c;
 
         if (!input.get(c))
@@ -271,16 +286,14 @@ namespace json
             escaped += '\t';
             break;
         case 'u':
-            escaped += readUnicodeEscapeSequence(input);
+            readUnicodeEscapeSequence(input, escaped);
             break;
         default:
             throw std::runtime_error("Found illegal escape sequence: '\\" + std::string(1, c) + "'");
         }
-
-        return escaped;
     }
 
-    std::string JsonLexer::readUnicodeEscapeSequence(std::istream &input)
+    void JsonLexer::readUnicodeEscapeSequence(std::istream &input, std::string &result)
     {
         // We read four hexadecimal digits from the stream.
         std::string hex;
@@ -299,38 +312,302 @@ namespace json
             }
         }
 
-        std::string result;
-
         int code = std::stoi(hex, nullptr, 16);
+        char utf8[4];
+
+        // A character beyond U+FFFF is written as a surrogate pair, two escape sequences that make up one character.
+        if (0xD800 <= code && code <= 0xDBFF && input.peek() == '\\')
+        {
+            input.get(c);
+            if (input.peek() != 'u')
+            {
+                result.append(utf8, encodeUtf8(code, utf8));
+                readEscapeSequence(input, result);
+                return;
+            }
+            input.get(c);
+
+            std::string low;
+            readUnicodeEscapeSequence(input, low);
+            int lowCode = decodeUtf8Surrogate(low);
+            if (lowCode >= 0)
+                code = 0x10000 + ((code - 0xD800) << 10) + (lowCode - 0xDC00);
+            else
+            {
+                result.append(utf8, encodeUtf8(code, utf8));
+                result += low;
+                return;
+            }
+        }
+
+        result.append(utf8, encodeUtf8(code, utf8));
+    }
 
+    int JsonLexer::decodeUtf8Surrogate(const std::string &utf8)
+    {
+        // A surrogate on its own is encoded like any other character from U+0800 to U+FFFF.
+        if (utf8.size() != 3)
+            return -1;
+        int code = ((utf8[0] & 0x0F) << 12) | ((utf8[1] & 0x3F) << 6) | (utf8[2] & 0x3F);
+        return 0xDC00 <= code && code <= 0xDFFF ? code : -1;
+    }
+
+    size_t JsonLexer::encodeUtf8(int code, char *output)
+    {
         //  We convert the UTF-16 code into UTF-8.
         //
         //  Interval                    UTF-16                          UTF-8
         //  U+0000 – U+007F             00000000 0xxxxxxx               0xxxxxxx
         //  U+0080 – U+07FF             00000xxx xxxxxxxx	            110xxxxx 10xxxxxx
         //  U+0800 – U+FFFF             xxxxxxxx xxxxxxxx               1110xxxx 10xxxxxx 10xxxxxx
+        //  U+10000 – U+10FFFF          a surrogate pair                11110xxx 10xxxxxx 10xxxxxx 10xxxxxx
 
-        if (0 <= code && code <= 0x75)
+        if (0 <= code && code <= 0x7F)
         {
-            result += static_cast<char>(code);
+            output[0] = static_cast<char>(code);
+            return 1;
         }
         else if (0x80 <= code && code <= 0x7FF)
         {
-            result += static_cast<char>(((0xC0 & code) >> 6) | ((0x700 & code) >> 6) | 0xC0);
-            result += static_cast<char>((0x3F & code) | 0x80);
+            output[0] = static_cast<char>(((0xC0 & code) >> 6) | ((0x700 & code) >> 6) | 0xC0);
+            output[1] = static_cast<char>((0x3F & code) | 0x80);
+            return 2;
         }
         else if (0x800 <= code && code <= 0xFFFF)
         {
-            result += static_cast<char>(((0xF000 & code) >> 12) | 0xE0);
-            result += static_cast<char>(((0xC0 & code) >> 6) | ((0xF00 & code) >> 6) | 0x80);
-            result += static_cast<char>((0x3F & code) | 0x80);
+            output[0] = static_cast<char>(((0xF000 & code) >> 12) | 0xE0);
+            output[1] = static_cast<char>(((0xC0 & code) >> 6) | ((0xF00 & code) >> 6) | 0x80);
+            output[2] = static_cast<char>((0x3F & code) | 0x80);
+            return 3;
+        }
+        else if (0x10000 <= code && code <= 0x10FFFF)
+        {
+            output[0] = static_cast<char>((code >> 18) | 0xF0);
+            output[1] = static_cast<char>(((code >> 12) & 0x3F) | 0x80);
+            output[2] = static_cast<char>(((code >> 6) & 0x3F) | 0x80);
+            output[3] = static_cast<char>((code & 0x3F) | 0x80);
+            return 4;
+        }
+
+        throw std::runtime_error("Unsupported unicode escape sequence");
+    }
+
+    void JsonLexer::nextToken(char *&position, char *end, JsonToken &token)
+    {
+        token.value.clear();
+
+        // The same characters are skipped as when reading from a stream.
+        while (position != end && std::isspace(static_cast<unsigned char>(*position)))
+            position++;
+
+        if (position == end)
+        {
+            token.type = JsonTokenType::EndOfFile;
+            return;
         }
-        else
+
+        char c = *position;
+        switch (c)
         {
-            throw std::runtime_error("Unsupported unicode escape sequence");
+        case '[':
+            token.type = JsonTokenType::BeginArray;
+            break;
+        case '{':
+            token.type = JsonTokenType::BeginObject;
+            break;
+        case ']':
+            token.type = JsonTokenType::EndArray;
+            break;
+        case '}':
+            token.type = JsonTokenType::EndObject;
+            break;
+        case ':':
+            token.type = JsonTokenType::NameSeparator;
+            break;
+        case ',':
+            token.type = JsonTokenType::ValueSeparator;
+            break;
+        case 'f':
+            read(++position, end, "alse");
+            token.type = JsonTokenType::False;
+            return;
+        case 't':
+            read(++position, end, "rue");
+            token.type = JsonTokenType::True;
+            return;
+        case 'n':
+            read(++position, end, "ull");
+            token.type = JsonTokenType::Null;
+            return;
+        case '-':
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':
+            token.type = JsonTokenType::Number;
+            readNumber(position, end, token.text);
+            return;
+        case '\"':
+            token.type = JsonTokenType::String;
+            readString(++position, end, token.text);
+            return;
+        default:
+            throw std::runtime_error("Found illegal character: '" + std::string(1, c) + "'");
         }
+        position++;
+    }
 
-        return result;
+    void JsonLexer::read(char *&position, char *end, const char *str)
+    {
+        for (; *str; str++, position++)
+        {
+            if (position == end)
+                throw std::runtime_error("Could not read the next character");
+            if (*position != *str)
+                throw std::runtime_error("Found illegal character: '" + std::string(1, *position) + "'");
+        }
     }
 
+    void JsonLexer::readNumber(char *&position, char *end, JsonStringView &number)
+    {
+        char *start = position;
+
+        // Check for optional minus.
+        if (*position == '-' && ++position == end)
+            throw std::runtime_error("After a minus sign there must be at least one digit");
+        if (!isdigit(static_cast<unsigned char>(*position)))
+            throw std::runtime_error("After a minus sign there must be at least one digit");
+
+        // A number that starts with zero has no more digits before the fraction, "0123" is not a valid number.
+        if (*position++ != '0')
+            skipDigits(position, end);
+
+        if (position != end && *position == '.')
+        {
+            if (++position == end || !isdigit(static_cast<unsigned char>(*position)))
+                throw std::runtime_error("After a decimal point there must be at least one digit");
+            skipDigits(position, end);
+        }
+
+        if (position != end && (*position == 'e' || *position == 'E'))
+        {
+            if (++position == end)
+                throw std::runtime_error("A number cannot end with 'e' or 'E'");
+            if (*position == '-' || *position == '+')
+            {
+                if (++position == end || !isdigit(static_cast<unsigned char>(*position)))
+                    throw std::runtime_error("After a minus or plus sign there must be at least one digit");
+            }
+            if (!isdigit(static_cast<unsigned char>(*position)))
+                throw std::runtime_error("A valid exponent requires at least one digit");
+            skipDigits(position, end);
+        }
+
+        number = JsonStringView(start, static_cast<size_t>(position - start));
+    }
+
+    void JsonLexer::skipDigits(char *&position, char *end) noexcept
+    {
+        while (position != end && isdigit(static_cast<unsigned char>(*position)))
+            position++;
+    }
+
+    void JsonLexer::readString(char *&position, char *end, JsonStringView &string)
+    {
+        char *begin = position;
+
+        // Most strings have no escape sequences, they are found without writing to the buffer.
+        while (position != end && *position != '\"' && *position != '\\')
+            position++;
+
+        char *output = position;
+        while (true)
+        {
+            if (position == end)
+                throw std::runtime_error("Could not read the next character");
+
+            char c = *position++;
+            if (c == '\"') // We reached ending quotation mark, lets break the loop.
+                break;
+            else if (c == '\\') // Escape sequence found.
+                output = readEscapeSequence(position, end, output);
+            else
+                *output++ = c;
+        }
+
+        string = JsonStringView(begin, static_cast<size_t>(output - begin));
+    }
+
+    char *JsonLexer::readEscapeSequence(char *&position, char *end, char *output)
+    {
+        if (position == end)
+            throw std::runtime_error("There must be at least one more character after '\\'");
+
+        char c = *position++;
+        switch (c)
+        {
+        case '\"':
+        case '\\':
+        case '/':
+            *output = c;
+            break;
+        case 'b':
+            *output = '\b';
+            break;
+        case 'f':
+            *output = '\f';
+            break;
+        case 'n':
+            *output = '\n';
+            break;
+        case 'r':
+            *output = '\r';
+            break;
+        case 't':
+            *output = '\t';
+            break;
+        case 'u':
+        {
+            int code = readHexCode(position, end);
+
+            // A surrogate pair becomes one character of four bytes, which is shorter than the twelve characters escaping it.
+            if (0xD800 <= code && code <= 0xDBFF && end - position >= 6 && position[0] == '\\' && position[1] == 'u')
+            {
+                char *low = position + 2;
+                int lowCode = readHexCode(low, end);
+                if (0xDC00 <= lowCode && lowCode <= 0xDFFF)
+                {
+                    position = low;
+                    code = 0x10000 + ((code - 0xD800) << 10) + (lowCode - 0xDC00);
+                }
+            }
+            return output + encodeUtf8(code, output);
+        }
+        default:
+            throw std::runtime_error("Found illegal escape sequence: '\\" + std::string(1, c) + "'");
+        }
+        return output + 1;
+    }
+
+    int JsonLexer::readHexCode(char *&position, char *end)
+    {
+        // We read four hexadecimal digits from the buffer.
+        int code = 0;
+        for (size_t i = 0; i < 4; i++, position++)
+        {
+            if (position == end)
+                throw std::runtime_error("Could not read the next character");
+            char digit = *position;
+            if (!isxdigit(static_cast<unsigned char>(digit)))
+                throw std::runtime_error("Found illegal character: '" + std::string(1, digit) + "'");
+            code = code * 16 + (isdigit(static_cast<unsigned char>(digit)) ? digit - '0' : (digit | 0x20) - 'a' + 10);
+        }
+        return code;
+    }
 } // namespace json
\ No newline at end of file
@@ -0,0 +1,338 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "JsonMemoryResource.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace json
+{
+    namespace
+    {
+        // The first block of a monotonic resource without a size, every following block doubles in size.
+        const size_t defaultInitialSize = 1024;
+
+        // Small blocks are cut from slabs of this size, so that the upstream resource sees few allocations.
+        const size_t slabSize = 64 * 1024;
+
+        char *alignUp(char *pointer, size_t alignment)
+        {
+            uintptr_t value = reinterpret_cast<uintptr_t>(pointer);
+            return reinterpret_cast<char *>((value + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1));
+        }
+
+        size_t roundUp(size_t size, size_t alignment)
+        {
+            return (size + alignment - 1) & ~(alignment - 1);
+        }
+
+        class MallocResource : public JsonMemoryResource
+        {
+        private:
+            void *doAllocate(size_t bytes, size_t alignment) override
+            {
+                if (alignment <= alignof(std::max_align_t))
+                {
+                    void *result = std::malloc(bytes > 0 ? bytes : 1);
+                    if (!result)
+                        throw std::bad_alloc();
+                    return result;
+                }
+
+                // malloc() only aligns to std::max_align_t, so more is taken and the start of the block
+                // is stored right before the aligned pointer. There is always room for it, since the
+                // aligned pointer is at least std::max_align_t bytes into the block.
+                char *block = static_cast<char *>(std::malloc(bytes + alignment));
+                if (!block)
+                    throw std::bad_alloc();
+                char *result = alignUp(block + 1, alignment);
+                reinterpret_cast<char **>(result)[-1] = block;
+                return result;
+            }
+
+            void doDeallocate(void *pointer, size_t, size_t alignment) noexcept override
+            {
+                if (alignment <= alignof(std::max_align_t))
+                    std::free(pointer);
+                else if (pointer)
+                    std::free(static_cast<char **>(pointer)[-1]);
+            }
+
+            bool doIsEqual(const JsonMemoryResource &other) const noexcept override
+            {
+                return dynamic_cast<const MallocResource *>(&other) != nullptr;
+            }
+        };
+
+        std::atomic<JsonMemoryResource *> defaultResource(nullptr);
+    } // namespace
+
+    JsonMemoryResource::~JsonMemoryResource()
+    {
+    }
+
+    void *JsonMemoryResource::allocate(size_t bytes, size_t alignment)
+    {
+        return doAllocate(bytes, alignment);
+    }
+
+    void JsonMemoryResource::deallocate(void *pointer, size_t bytes, size_t alignment) noexcept
+    {
+        doDeallocate(pointer, bytes, alignment);
+    }
+
+    bool JsonMemoryResource::isEqual(const JsonMemoryResource &other) const noexcept
+    {
+        return this == &other || doIsEqual(other);
+    }
+
+    JsonMemoryResource *JsonMemoryResource::getDefault() noexcept
+    {
+        JsonMemoryResource *resource = defaultResource.load(std::memory_order_acquire);
+        return resource ? resource : getMalloc();
+    }
+
+    JsonMemoryResource *JsonMemoryResource::setDefault(JsonMemoryResource *resource) noexcept
+    {
+        JsonMemoryResource *previous = defaultResource.exchange(resource, std::memory_order_acq_rel);
+        return previous ? previous : getMalloc();
+    }
+
+    JsonMemoryResource *JsonMemoryResource::getMalloc() noexcept
+    {
+        // The resource is never destroyed, documents may still be released by destructors of static objects.
+        static JsonMemoryResource *resource = new MallocResource();
+        return resource;
+    }
+
+    JsonMonotonicResource::JsonMonotonicResource(JsonMemoryResource *upstream) : JsonMonotonicResource(defaultInitialSize, upstream)
+    {
+    }
+
+    JsonMonotonicResource::JsonMonotonicResource(size_t initialSize, JsonMemoryResource *upstream)
+        : upstream(upstream), buffer(nullptr), bufferSize(0), blocks(nullptr), position(nullptr), end(nullptr),
+          initialSize(initialSize > 0 ? initialSize : defaultInitialSize), nextSize(this->initialSize)
+    {
+    }
+
+    JsonMonotonicResource::JsonMonotonicResource(void *buffer, size_t size, JsonMemoryResource *upstream)
+        : upstream(upstream), buffer(static_cast<char *>(buffer)), bufferSize(size), blocks(nullptr),
+          position(static_cast<char *>(buffer)), end(static_cast<char *>(buffer) + size),
+          initialSize(size > 0 ? size : defaultInitialSize), nextSize(initialSize)
+    {
+    }
+
+    JsonMonotonicResource::~JsonMonotonicResource()
+    {
+        release();
+    }
+
+    void JsonMonotonicResource::release() noexcept
+    {
+        while (blocks)
+        {
+            Block *previous = blocks->previous;
+            upstream->deallocate(blocks, blocks->size);
+            blocks = previous;
+        }
+        position = buffer;
+        end = buffer + bufferSize;
+        nextSize = initialSize;
+    }
+
+    JsonMemoryResource *JsonMonotonicResource::getUpstream() const noexcept
+    {
+        return upstream;
+    }
+
+    void *JsonMonotonicResource::doAllocate(size_t bytes, size_t alignment)
+    {
+        char *result = position ? alignUp(position, alignment) : nullptr;
+
+        // The comparison is written this way to avoid computing a pointer past the end of the block.
+        if (!result || result > end || bytes > static_cast<size_t>(end - result))
+        {
+            // The block header is followed by the usable memory.
+            size_t headerSize = roundUp(sizeof(Block), alignof(std::max_align_t));
+            size_t required = headerSize + bytes + (alignment > alignof(std::max_align_t) ? alignment : 0);
+            size_t size = nextSize > required ? nextSize : required;
+
+            Block *block = static_cast<Block *>(upstream->allocate(size));
+            block->previous = blocks;
+            block->size = size;
+            blocks = block;
+            nextSize = size * 2;
+
+            position = reinterpret_cast<char *>(block) + headerSize;
+            end = reinterpret_cast<char *>(block) + size;
+            result = alignUp(position, alignment);
+        }
+
+        position = result + bytes;
+        return result;
+    }
+
+    void JsonMonotonicResource::doDeallocate(void *, size_t, size_t) noexcept
+    {
+    }
+
+    bool JsonMonotonicResource::doIsEqual(const JsonMemoryResource &other) const noexcept
+    {
+        return this == &other;
+    }
+
+    JsonPoolResource::JsonPoolResource(JsonMemoryResource *upstream) : upstream(upstream), freeBlocks(), slabs(nullptr)
+    {
+    }
+
+    JsonPoolResource::~JsonPoolResource()
+    {
+        release();
+    }
+
+    void JsonPoolResource::release() noexcept
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        while (slabs)
+        {
+            Slab *previous = slabs->previous;
+            upstream->deallocate(slabs, slabs->size, slabs->alignment);
+            slabs = previous;
+        }
+        for (size_t i = 0; i < classCount; i++)
+            freeBlocks[i] = nullptr;
+    }
+
+    JsonMemoryResource *JsonPoolResource::getUpstream() const noexcept
+    {
+        return upstream;
+    }
+
+    size_t JsonPoolResource::getMaximumBlockSize() noexcept
+    {
+        return static_cast<size_t>(16) << (classCount - 1);
+    }
+
+    size_t JsonPoolResource::getClass(size_t bytes, size_t alignment) noexcept
+    {
+        if (alignment > alignof(std::max_align_t) || bytes > getMaximumBlockSize())
+            return classCount;
+
+        size_t index = 0;
+        for (size_t size = 16; size < bytes; size *= 2)
+            index++;
+        return index;
+    }
+
+    size_t JsonPoolResource::getSlabHeaderSize(size_t alignment) noexcept
+    {
+        return roundUp(sizeof(Slab), alignment);
+    }
+
+    void *JsonPoolResource::allocateSlab(size_t size, size_t alignment)
+    {
+        if (alignment < alignof(std::max_align_t))
+            alignment = alignof(std::max_align_t);
+
+        size_t headerSize = getSlabHeaderSize(alignment);
+        Slab *slab = static_cast<Slab *>(upstream->allocate(headerSize + size, alignment));
+        slab->previous = slabs;
+        slab->next = nullptr;
+        slab->size = headerSize + size;
+        slab->alignment = alignment;
+        if (slabs)
+            slabs->next = slab;
+        slabs = slab;
+        return reinterpret_cast<char *>(slab) + headerSize;
+    }
+
+    void JsonPoolResource::deallocateSlab(void *pointer, size_t alignment) noexcept
+    {
+        if (alignment < alignof(std::max_align_t))
+            alignment = alignof(std::max_align_t);
+
+        Slab *slab = reinterpret_cast<Slab *>(static_cast<char *>(pointer) - getSlabHeaderSize(alignment));
+        if (slab->previous)
+            slab->previous->next = slab->next;
+        if (slab->next)
+            slab->next->previous = slab->previous;
+        else
+            slabs = slab->previous;
+        upstream->deallocate(slab, slab->size, slab->alignment);
+    }
+
+    void *JsonPoolResource::doAllocate(size_t bytes, size_t alignment)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // A large block is a slab of its own, it is recorded so that release() finds it if it is never deallocated.
+        size_t index = getClass(bytes, alignment);
+        if (index == classCount)
+            return allocateSlab(bytes, alignment);
+
+        FreeBlock *block = freeBlocks[index];
+        if (!block)
+        {
+            // A new slab is cut into blocks that are put on the list.
+            size_t blockSize = static_cast<size_t>(16) << index;
+            size_t count = blockSize < slabSize ? slabSize / blockSize : 1;
+            char *memory = static_cast<char *>(allocateSlab(blockSize * count, alignof(std::max_align_t)));
+            for (size_t i = count; i > 0; i--)
+            {
+                FreeBlock *free = reinterpret_cast<FreeBlock *>(memory + (i - 1) * blockSize);
+                free->next = block;
+                block = free;
+            }
+        }
+
+        freeBlocks[index] = block->next;
+        return block;
+    }
+
+    void JsonPoolResource::doDeallocate(void *pointer, size_t bytes, size_t alignment) noexcept
+    {
+        if (!pointer)
+            return;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t index = getClass(bytes, alignment);
+        if (index == classCount)
+        {
+            deallocateSlab(pointer, alignment);
+            return;
+        }
+
+        FreeBlock *block = static_cast<FreeBlock *>(pointer);
+        block->next = freeBlocks[index];
+        freeBlocks[index] = block;
+    }
+
+    bool JsonPoolResource::doIsEqual(const JsonMemoryResource &other) const noexcept
+    {
+        return this == &other;
+    }
+} // namespace json
\ No newline at end of file
@@ -23,16 +23,34 @@ THE SOFTWARE.
 */
 
 #include "JsonNode.hpp"
+#include "JsonArray.hpp"
+#include "JsonObject.hpp"
+#include "JsonBool.hpp"
+#include "JsonNull.hpp"
+#include "JsonNumber.hpp"
+#include "JsonString.hpp"
+#include "JsonArena.hpp"
+#include "JsonDocument.hpp"
+#include "JsonVisitor.hpp"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <stdexcept>
+#include <vector>
 
 namespace json
 {
-    JsonNode::JsonNode() : parent(nullptr)
+    const uint32_t JsonNode::sharedBit;
+    const uint16_t JsonNode::lastEpoch;
+    std::atomic<uint16_t> JsonNode::epoch(1);
+
+    JsonNode::JsonNode(JsonNodeType type) : parent(nullptr), type(type), checkedEpoch(0), references(1)
     {
     }
 
-    JsonNode::JsonNode(JsonNode *parent) : parent(parent)
+    JsonNode::JsonNode(JsonNode *parent, JsonNodeType type)
+        : parent(parent), type(type), checkedEpoch(parent ? parent->checkedEpoch : 0), references(1)
     {
     }
 
@@ -40,6 +58,878 @@ namespace json
     {
     }
 
+    void JsonNode::setParent(JsonNode *node, JsonNode *parent) noexcept
+    {
+        node->parent = parent;
+    }
+
+    JsonNode *JsonNode::share(JsonNode *node) noexcept
+    {
+        // The bit stays set when the other holders release the node, since a reference to the node
+        // may have been taken before it was shared.
+        node->references.fetch_or(sharedBit, std::memory_order_relaxed);
+        node->references.fetch_add(1, std::memory_order_relaxed);
+        return node;
+    }
+
+    JsonNode *JsonNode::copy(JsonArena *arena, JsonNode *parent, const JsonNode &node)
+    {
+        // The arena would never release children allocated with new, so they are copied as well.
+        switch (node.type)
+        {
+        case JsonNodeType::Array:
+            if (arena && !static_cast<const JsonArray &>(node).arena)
+                return copyTree(arena, parent, node);
+            return static_cast<const JsonArray &>(node).copy(arena, parent);
+        case JsonNodeType::Object:
+            if (arena && !static_cast<const JsonObject &>(node).arena)
+                return copyTree(arena, parent, node);
+            return static_cast<const JsonObject &>(node).copy(arena, parent);
+        case JsonNodeType::Bool:
+            return JsonArena::create<JsonBool>(arena, parent, node.toBool().data());
+        case JsonNodeType::Null:
+            return JsonArena::create<JsonNull>(arena, parent);
+        case JsonNodeType::Number:
+            return static_cast<const JsonNumber &>(node).copy(arena, parent);
+        case JsonNodeType::String:
+            return JsonArena::create<JsonString>(arena, parent, arena, node.toString().view());
+        }
+        return nullptr;
+    }
+
+    JsonMemoryUsage JsonNode::memoryUsage() const
+    {
+        JsonMemoryUsage usage;
+
+        // An explicit stack is used so that deeply nested documents can not overflow the call stack.
+        std::vector<const JsonNode *> pending(1, this);
+        while (!pending.empty())
+        {
+            const JsonNode *node = pending.back();
+            pending.pop_back();
+
+            addNodeMemoryUsage(*node, usage);
+            if (node->type == JsonNodeType::Array)
+            {
+                const JsonArray &array = static_cast<const JsonArray &>(*node);
+                pending.insert(pending.end(), array.children.begin(), array.children.end());
+            }
+            else if (node->type == JsonNodeType::Object)
+            {
+                const JsonObject &object = static_cast<const JsonObject &>(*node);
+                pending.insert(pending.end(), object.values.begin(), object.values.end());
+            }
+        }
+        return usage;
+    }
+
+    void JsonNode::addNodeMemoryUsage(const JsonNode &node, JsonMemoryUsage &usage) noexcept
+    {
+        switch (node.type)
+        {
+        case JsonNodeType::Array:
+            usage.nodeHeaders += sizeof(JsonArray);
+            static_cast<const JsonArray &>(node).addMemoryUsage(usage);
+            break;
+        case JsonNodeType::Object:
+            usage.nodeHeaders += sizeof(JsonObject);
+            static_cast<const JsonObject &>(node).addMemoryUsage(usage);
+            break;
+        case JsonNodeType::Bool:
+            usage.nodeHeaders += sizeof(JsonBool);
+            break;
+        case JsonNodeType::Null:
+            usage.nodeHeaders += sizeof(JsonNull);
+            break;
+        case JsonNodeType::Number:
+            usage.nodeHeaders += sizeof(JsonNumber);
+            usage.valueStrings += static_cast<const JsonNumber &>(node).getText().size();
+            break;
+        case JsonNodeType::String:
+            usage.nodeHeaders += sizeof(JsonString);
+            static_cast<const JsonString &>(node).addMemoryUsage(usage);
+            break;
+        }
+    }
+
+    JsonMemoryUsage JsonNode::findDuplicates(const JsonNode &node, DuplicateMap &duplicates)
+    {
+        // The node that stands for a subtree together with the hash of the subtree.
+        struct Result
+        {
+            const JsonNode *node;
+            uint64_t hash;
+        };
+
+        // A container whose children are being visited, the results of its children start at first.
+        struct Frame
+        {
+            const JsonNode *container;
+            size_t next;
+            size_t first;
+        };
+
+        auto mix = [](uint64_t hash, uint64_t value) {
+            return (hash ^ value) * 1099511628211ULL;
+        };
+        auto bits = [](double number) {
+            uint64_t result;
+            std::memcpy(&result, &number, sizeof(result));
+            return result;
+        };
+        auto original = [&](const JsonNode *child) {
+            auto it = duplicates.find(child);
+            return it == duplicates.end() ? child : it->second;
+        };
+
+        // The results of the children are on the stack, so a container is equal to an earlier one if the names are
+        // equal and the children stand for the same nodes. Nothing below the children has to be compared again.
+        std::vector<Result> results;
+        auto equal = [&](const JsonNode &a, const JsonNode &b, size_t first) {
+            if (a.type != b.type)
+                return false;
+            switch (a.type)
+            {
+            case JsonNodeType::Array:
+            {
+                const JsonArray &x = static_cast<const JsonArray &>(a);
+                const JsonArray &y = static_cast<const JsonArray &>(b);
+                if (x.packed != y.packed || x.getChildCount() != y.getChildCount())
+                    return false;
+                if (x.packed)
+                    return std::memcmp(x.getNumbers().data(), y.getNumbers().data(), x.getChildCount() * sizeof(double)) == 0;
+                for (size_t i = 0; i < y.children.size(); i++)
+                {
+                    if (results[first + i].node != original(y.children[i]))
+                        return false;
+                }
+                return true;
+            }
+            case JsonNodeType::Object:
+            {
+                const JsonObject &x = static_cast<const JsonObject &>(a);
+                const JsonObject &y = static_cast<const JsonObject &>(b);
+                if (x.values.size() != y.values.size())
+                    return false;
+                for (size_t i = 0; i < y.values.size(); i++)
+                {
+                    if (results[first + i].node != original(y.values[i]))
+                        return false;
+                    if (!(x.shape && x.shape == y.shape) && x.getNameAt(i) != y.getNameAt(i))
+                        return false;
+                }
+                return true;
+            }
+            case JsonNodeType::Bool:
+                return static_cast<const JsonBool &>(a).data() == static_cast<const JsonBool &>(b).data();
+            case JsonNodeType::Null:
+                return true;
+            case JsonNodeType::Number:
+            {
+                // Numbers written differently, such as 1 and 1.0, stay apart so that the document is written as it was read.
+                const JsonNumber &x = static_cast<const JsonNumber &>(a);
+                const JsonNumber &y = static_cast<const JsonNumber &>(b);
+                return bits(x.data()) == bits(y.data()) && x.getText() == y.getText();
+            }
+            case JsonNodeType::String:
+                return static_cast<const JsonString &>(a).view() == static_cast<const JsonString &>(b).view();
+            }
+            return false;
+        };
+
+        JsonMemoryUsage usage;
+        std::unordered_multimap<uint64_t, const JsonNode *> unique;
+
+        // Replaces the results of the children of a node with the result of the node itself.
+        // Only the duplicates among the children of a node that is kept are recorded, the children of a duplicate
+        // are never copied, so most of the duplicates never enter the map.
+        auto finish = [&](const JsonNode &current, uint64_t hash, size_t first) {
+            auto range = unique.equal_range(hash);
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                if (equal(current, *it->second, first))
+                {
+                    results.resize(first);
+                    results.push_back({it->second, hash});
+                    return;
+                }
+            }
+            unique.emplace(hash, &current);
+            addNodeMemoryUsage(current, usage);
+
+            for (size_t i = first; i < results.size(); i++)
+            {
+                const JsonNode *child = current.type == JsonNodeType::Array ? static_cast<const JsonArray &>(current).children[i - first]
+                                                                            : static_cast<const JsonObject &>(current).values[i - first];
+                if (results[i].node != child)
+                {
+                    duplicates[child] = results[i].node;
+                    duplicates.emplace(results[i].node, results[i].node);
+                }
+            }
+            results.resize(first);
+            results.push_back({&current, hash});
+        };
+
+        std::vector<Frame> frames;
+        const JsonNode *next = &node;
+        for (;;)
+        {
+            if (next)
+            {
+                const JsonNode &current = *next;
+                next = nullptr;
+                uint64_t hash = mix(14695981039346656037ULL, static_cast<uint64_t>(current.type));
+                switch (current.type)
+                {
+                case JsonNodeType::Array:
+                {
+                    const JsonArray &array = static_cast<const JsonArray &>(current);
+                    if (array.packed)
+                    {
+                        for (double number : array.getNumbers())
+                            hash = mix(hash, bits(number));
+                        finish(current, mix(hash, 1), results.size());
+                        break;
+                    }
+                    frames.push_back({&current, 0, results.size()});
+                    break;
+                }
+                case JsonNodeType::Object:
+                    frames.push_back({&current, 0, results.size()});
+                    break;
+                case JsonNodeType::Bool:
+                    finish(current, mix(hash, static_cast<const JsonBool &>(current).data()), results.size());
+                    break;
+                case JsonNodeType::Null:
+                    finish(current, hash, results.size());
+                    break;
+                case JsonNodeType::Number:
+                    finish(current, mix(hash, bits(static_cast<const JsonNumber &>(current).data())), results.size());
+                    break;
+                case JsonNodeType::String:
+                    finish(current, mix(hash, static_cast<const JsonString &>(current).view().hash()), results.size());
+                    break;
+                }
+            }
+
+            if (frames.empty())
+                break;
+
+            Frame &frame = frames.back();
+            const JsonNode *container = frame.container;
+            if (container->type == JsonNodeType::Array)
+            {
+                const JsonArray &array = static_cast<const JsonArray &>(*container);
+                if (frame.next < array.children.size())
+                {
+                    next = array.children[frame.next++];
+                    continue;
+                }
+            }
+            else
+            {
+                const JsonObject &object = static_cast<const JsonObject &>(*container);
+                if (frame.next < object.values.size())
+                {
+                    next = object.values[frame.next++];
+                    continue;
+                }
+            }
+
+            // All children are done, the hash of the container is made from their hashes and the names.
+            size_t first = frame.first;
+            frames.pop_back();
+            uint64_t hash = mix(14695981039346656037ULL, static_cast<uint64_t>(container->type));
+            for (size_t i = first; i < results.size(); i++)
+            {
+                hash = mix(hash, results[i].hash);
+                if (container->type == JsonNodeType::Object)
+                    hash = mix(hash, static_cast<const JsonObject &>(*container).getNameAt(i - first).hash());
+            }
+            finish(*container, hash, first);
+        }
+        return usage;
+    }
+
+    JsonNode *JsonNode::copyTree(JsonArena *arena, JsonNode *parent, const JsonNode &node)
+    {
+        // Builds the copy from the values of the tree, the containers being filled are kept on a stack.
+        // Every container is sized exactly before its children are added and an object gets all its names at once,
+        // so the children are simply appended. Every node is created in the arena, so nothing leaks if this fails half way.
+        class Builder : public JsonVisitor
+        {
+        public:
+            Builder(JsonArena *arena, JsonNode *parent) : arena(arena), parent(parent), result(nullptr)
+            {
+            }
+
+            bool beginArray(const JsonArray &array) override
+            {
+                JsonArray *copied = JsonArena::create<JsonArray>(arena, container(), arena);
+                add(copied);
+                containers.push_back(copied);
+
+                // The numbers of a packed array are copied as one block.
+                if (array.isPacked())
+                {
+                    copied->addNumbers(array.getNumbers());
+                    return false;
+                }
+                copied->reserve(array.getChildCount());
+                return true;
+            }
+
+            void endArray(const JsonArray &) override
+            {
+                containers.pop_back();
+            }
+
+            bool beginObject(const JsonObject &object) override
+            {
+                JsonObject *copied = JsonArena::create<JsonObject>(arena, container(), arena);
+                add(copied);
+                containers.push_back(copied);
+                copied->reserve(object.values.size());
+                copied->copyNames(object, &shapes);
+                return true;
+            }
+
+            void endObject(const JsonObject &) override
+            {
+                containers.pop_back();
+            }
+
+            void visitBool(bool value) override
+            {
+                add(JsonArena::create<JsonBool>(arena, container(), value));
+            }
+
+            void visitNull() override
+            {
+                add(JsonArena::create<JsonNull>(arena, container()));
+            }
+
+            void visitNumber(double value) override
+            {
+                add(JsonArena::create<JsonNumber>(arena, container(), value));
+            }
+
+            void visitNumberNode(const JsonNumber &number) override
+            {
+                add(number.copy(arena, container()));
+            }
+
+            void visitString(const JsonString &value) override
+            {
+                add(JsonArena::create<JsonString>(arena, container(), arena, value.view()));
+            }
+
+            JsonNode *getResult() const noexcept
+            {
+                return result;
+            }
+
+        private:
+            JsonNode *container() const noexcept
+            {
+                return containers.empty() ? parent : containers.back();
+            }
+
+            // The names of an object are already in place, so its values are added in the same order.
+            void add(JsonNode *node)
+            {
+                if (containers.empty())
+                    result = node;
+                else if (containers.back()->type == JsonNodeType::Array)
+                    static_cast<JsonArray *>(containers.back())->appendChild(node);
+                else
+                    static_cast<JsonObject *>(containers.back())->values.push_back(node, arena);
+            }
+
+            JsonArena *arena;
+            JsonNode *parent;
+            JsonNode *result;
+            std::vector<JsonNode *> containers;
+            JsonObject::ShapeMap shapes;
+        };
+
+        Builder builder(arena, parent);
+        node.accept(builder);
+        return builder.getResult();
+    }
+
+    JsonNode *JsonNode::relayout(JsonArena *arena, const JsonNode &node, const DuplicateMap *duplicates)
+    {
+        // A container of the tree and its copy, whose children have not been copied yet.
+        struct Pending
+        {
+            const JsonNode *source;
+            JsonNode *copy;
+        };
+
+        std::vector<Pending> pending;
+        JsonObject::ShapeMap shapes;
+        std::unordered_map<const JsonNode *, JsonNode *> copies;
+
+        // Copies a node without its children, which are copied when the container is taken from the stack.
+        auto copyShallow = [&](const JsonNode &source, JsonNode *parent) -> JsonNode * {
+            switch (source.type)
+            {
+            case JsonNodeType::Array:
+            {
+                const JsonArray &array = static_cast<const JsonArray &>(source);
+                JsonArray *copied = JsonArena::create<JsonArray>(arena, parent, arena);
+                if (array.packed)
+                {
+                    copied->addNumbers(array.getNumbers());
+                }
+                else if (!array.children.empty())
+                {
+                    copied->children.reserve(array.children.size(), arena);
+                    pending.push_back({&source, copied});
+                }
+                return copied;
+            }
+            case JsonNodeType::Object:
+            {
+                const JsonObject &object = static_cast<const JsonObject &>(source);
+                JsonObject *copied = JsonArena::create<JsonObject>(arena, parent, arena);
+                copied->reserve(object.values.size());
+                copied->copyNames(object, &shapes);
+                if (!object.values.empty())
+                    pending.push_back({&source, copied});
+                return copied;
+            }
+            case JsonNodeType::Bool:
+                return JsonArena::create<JsonBool>(arena, parent, static_cast<const JsonBool &>(source).data());
+            case JsonNodeType::Null:
+                return JsonArena::create<JsonNull>(arena, parent);
+            case JsonNodeType::Number:
+                return static_cast<const JsonNumber &>(source).copy(arena, parent);
+            case JsonNodeType::String:
+                return JsonArena::create<JsonString>(arena, parent, arena, static_cast<const JsonString &>(source).view());
+            }
+            return nullptr;
+        };
+
+        // A node with more than one reference, or with duplicates, is looked up first so that it is copied only once.
+        auto copyNode = [&](const JsonNode &source, JsonNode *parent) -> JsonNode * {
+            const JsonNode *original = &source;
+            bool shared = source.isShared();
+            if (duplicates)
+            {
+                auto it = duplicates->find(&source);
+                if (it != duplicates->end())
+                {
+                    original = it->second;
+                    shared = true;
+                }
+            }
+            if (!shared)
+                return copyShallow(source, parent);
+
+            auto it = copies.find(original);
+            if (it != copies.end())
+                return share(it->second);
+            JsonNode *copied = copyShallow(*original, parent);
+            copies.emplace(original, copied);
+            return copied;
+        };
+
+        JsonNode *result = copyNode(node, nullptr);
+        while (!pending.empty())
+        {
+            Pending container = pending.back();
+            pending.pop_back();
+
+            // The containers among the children are pushed in reverse, so the first one is filled next.
+            size_t first = pending.size();
+            if (container.source->type == JsonNodeType::Array)
+            {
+                JsonArray *copied = static_cast<JsonArray *>(container.copy);
+                for (const JsonNode *child : static_cast<const JsonArray *>(container.source)->children)
+                    copied->children.push_back(copyNode(*child, copied), arena);
+            }
+            else
+            {
+                JsonObject *copied = static_cast<JsonObject *>(container.copy);
+                for (const JsonNode *value : static_cast<const JsonObject *>(container.source)->values)
+                    copied->values.push_back(copyNode(*value, copied), arena);
+            }
+            std::reverse(pending.begin() + first, pending.end());
+        }
+        return result;
+    }
+
+    JsonDocument JsonNode::clone() const
+    {
+        return clone(std::make_shared<JsonStringPool>());
+    }
+
+    JsonDocument JsonNode::clone(std::shared_ptr<JsonStringPool> pool) const
+    {
+        return JsonDocument::clone(*this, std::move(pool), 0, JsonMemoryResource::getDefault());
+    }
+
+    void JsonNode::accept(JsonVisitor &visitor) const
+    {
+        // The position in every container that is being visited.
+        struct Frame
+        {
+            const JsonNode *container;
+            size_t next;
+        };
+
+        std::vector<Frame> frames;
+        const JsonNode *node = this;
+
+        for (;;)
+        {
+            if (node)
+            {
+                switch (node->type)
+                {
+                case JsonNodeType::Array:
+                {
+                    const JsonArray &array = static_cast<const JsonArray &>(*node);
+                    if (!visitor.beginArray(array))
+                    {
+                        visitor.endArray(array);
+                    }
+                    else if (array.packed)
+                    {
+                        // The numbers are visited without creating nodes for them.
+                        for (double number : array.getNumbers())
+                            visitor.visitNumber(number);
+                        visitor.endArray(array);
+                    }
+                    else
+                    {
+                        frames.push_back({node, 0});
+                    }
+                    break;
+                }
+                case JsonNodeType::Object:
+                {
+                    const JsonObject &object = static_cast<const JsonObject &>(*node);
+                    if (visitor.beginObject(object))
+                        frames.push_back({node, 0});
+                    else
+                        visitor.endObject(object);
+                    break;
+                }
+                case JsonNodeType::Bool:
+                    visitor.visitBool(static_cast<const JsonBool &>(*node).data());
+                    break;
+                case JsonNodeType::Null:
+                    visitor.visitNull();
+                    break;
+                case JsonNodeType::Number:
+                    visitor.visitNumberNode(static_cast<const JsonNumber &>(*node));
+                    break;
+                case JsonNodeType::String:
+                    visitor.visitString(static_cast<const JsonString &>(*node));
+                    break;
+                }
+            }
+
+            if (frames.empty())
+                return;
+
+            // Continue with the next child of the innermost container, or leave it if there are no more children.
+            Frame &frame = frames.back();
+            if (frame.container->type == JsonNodeType::Array)
+            {
+                const JsonArray &array = static_cast<const JsonArray &>(*frame.container);
+                if (frame.next < array.children.size())
+                {
+                    node = array.children[frame.next++];
+                    continue;
+                }
+                frames.pop_back();
+                visitor.endArray(array);
+            }
+            else
+            {
+                const JsonObject &object = static_cast<const JsonObject &>(*frame.container);
+                if (frame.next < object.values.size())
+                {
+                    size_t slot = frame.next++;
+                    visitor.visitName(object.shape ? object.shape->getName(slot) : object.dictionary->names[slot]);
+                    node = object.values[slot];
+                    continue;
+                }
+                frames.pop_back();
+                visitor.endObject(object);
+            }
+            node = nullptr;
+        }
+    }
+
+    bool JsonNode::equals(const JsonNode &other) const
+    {
+        // The other tree is followed while this tree is visited. For every value of this tree the node
+        // at the same place in the other tree is looked up, by index in arrays and by name in objects.
+        class Comparer : public JsonVisitor
+        {
+        public:
+            explicit Comparer(const JsonNode &other) : other(&other), equal(true)
+            {
+            }
+
+            bool beginArray(const JsonArray &array) override
+            {
+                const JsonNode *node = next();
+                if (!node || node->type != JsonNodeType::Array || static_cast<const JsonArray &>(*node).getChildCount() != array.getChildCount())
+                    return fail();
+                positions.push_back({node, 0});
+                return true;
+            }
+
+            void endArray(const JsonArray &) override
+            {
+                if (equal)
+                    positions.pop_back();
+            }
+
+            bool beginObject(const JsonObject &object) override
+            {
+                const JsonNode *node = next();
+                if (!node || node->type != JsonNodeType::Object || static_cast<const JsonObject &>(*node).getChildCount() != object.getChildCount())
+                    return fail();
+                positions.push_back({node, 0});
+                return true;
+            }
+
+            void endObject(const JsonObject &) override
+            {
+                if (equal)
+                    positions.pop_back();
+            }
+
+            void visitName(JsonStringView name) override
+            {
+                this->name = name;
+            }
+
+            void visitBool(bool value) override
+            {
+                const JsonNode *node = next();
+                if (!node || node->type != JsonNodeType::Bool || static_cast<const JsonBool &>(*node).data() != value)
+                    fail();
+            }
+
+            void visitNull() override
+            {
+                const JsonNode *node = next();
+                if (!node || node->type != JsonNodeType::Null)
+                    fail();
+            }
+
+            void visitNumber(double value) override
+            {
+                // The numbers of a packed array are compared without creating nodes for them.
+                if (equal && !positions.empty() && positions.back().container->type == JsonNodeType::Array)
+                {
+                    const JsonArray &array = static_cast<const JsonArray &>(*positions.back().container);
+                    if (array.packed)
+                    {
+                        if (array.getNumbers()[positions.back().next++] != value)
+                            fail();
+                        return;
+                    }
+                }
+
+                const JsonNode *node = next();
+                if (!node || node->type != JsonNodeType::Number || static_cast<const JsonNumber &>(*node).data() != value)
+                    fail();
+            }
+
+            void visitString(const JsonString &value) override
+            {
+                const JsonNode *node = next();
+                if (!node || node->type != JsonNodeType::String || static_cast<const JsonString &>(*node).view() != value.view())
+                    fail();
+            }
+
+            bool isEqual() const noexcept
+            {
+                return equal;
+            }
+
+        private:
+            // Returns the node of the other tree at the place of the value being visited, or nullptr if there is none.
+            const JsonNode *next()
+            {
+                if (!equal)
+                    return nullptr;
+                if (positions.empty())
+                    return other;
+
+                // The containers have the same number of children, so the index is always in range.
+                Position &position = positions.back();
+                if (position.container->type == JsonNodeType::Array)
+                {
+                    const JsonArray &array = static_cast<const JsonArray &>(*position.container);
+                    size_t index = position.next++;
+                    return array.packed ? nullptr : array.children[index];
+                }
+
+                const JsonObject &object = static_cast<const JsonObject &>(*position.container);
+                size_t slot = object.findSlot(name, false);
+                return slot < object.values.size() ? object.values[slot] : nullptr;
+            }
+
+            bool fail() noexcept
+            {
+                equal = false;
+                return false;
+            }
+
+            struct Position
+            {
+                const JsonNode *container;
+                size_t next;
+            };
+
+            const JsonNode *other;
+            bool equal;
+            std::vector<Position> positions;
+            JsonStringView name;
+        };
+
+        Comparer comparer(other);
+        accept(comparer);
+        return comparer.isEqual();
+    }
+
+    JsonNode &JsonNode::unshare(JsonArena *arena, JsonNode *parent, JsonNode *&child)
+    {
+        if (child->isShared())
+        {
+            JsonNode *copied = copy(arena, parent, *child);
+            destroy(arena, child);
+            child = copied;
+        }
+        else if (child->parent != parent)
+        {
+            // The child was shared when the parent was copied, so it still points to the parent it had before.
+            child->parent = parent;
+        }
+        return *child;
+    }
+
+    void JsonNode::checkWritable() const
+    {
+        // A node below a shared container is part of the same versions as the container, even if it is held only once.
+        // The walk stops at a container that has been checked since the last snapshot.
+        uint16_t current = epoch.load(std::memory_order_relaxed);
+        const JsonNode *node = this;
+        for (; node; node = node->parent)
+        {
+            if (node->isShared())
+                throw std::runtime_error("The node is shared with a snapshot of the document and can not be modified");
+            if (node->checkedEpoch == current && current != lastEpoch)
+                break;
+        }
+        for (const JsonNode *checked = this; checked != node; checked = checked->parent)
+            checked->checkedEpoch = current;
+    }
+
+    void JsonNode::beginEpoch() noexcept
+    {
+        uint16_t current = epoch.load(std::memory_order_relaxed);
+        while (current != lastEpoch && !epoch.compare_exchange_weak(current, static_cast<uint16_t>(current + 1), std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void JsonNode::destroy(JsonArena *arena, JsonNode *node) noexcept
+    {
+        if (!node)
+            return;
+
+        if (!release(node) || arena)
+            return;
+
+        node->parent = nullptr;
+        destroyPending(node, SIZE_MAX);
+    }
+
+    JsonNode *JsonNode::destroyPending(JsonNode *node, size_t limit) noexcept
+    {
+        // The children are taken from a container before it is deleted and destroyed by this loop instead of by the
+        // destructor, so deep trees do not use the call stack. The nodes waiting to be deleted are linked through
+        // their parent pointers, which nobody uses anymore, so nothing has to be allocated.
+        for (; node && limit > 0; limit--)
+        {
+            JsonNode *next = node->parent;
+
+            // The destructor is not virtual so we call the destructor of the derived class ourselves.
+            switch (node->type)
+            {
+            case JsonNodeType::Array:
+            {
+                JsonArray *array = static_cast<JsonArray *>(node);
+                for (JsonNode *child : array->children)
+                {
+                    if (release(child))
+                    {
+                        child->parent = next;
+                        next = child;
+                    }
+                }
+                array->children.clear();
+                delete array;
+                break;
+            }
+            case JsonNodeType::Object:
+            {
+                JsonObject *object = static_cast<JsonObject *>(node);
+                for (JsonNode *value : object->values)
+                {
+                    if (release(value))
+                    {
+                        value->parent = next;
+                        next = value;
+                    }
+                }
+                object->values.clear();
+                delete object;
+                break;
+            }
+            case JsonNodeType::Bool:
+                delete static_cast<JsonBool *>(node);
+                break;
+            case JsonNodeType::Null:
+                delete static_cast<JsonNull *>(node);
+                break;
+            case JsonNodeType::Number:
+                delete static_cast<JsonNumber *>(node);
+                break;
+            case JsonNodeType::String:
+                delete static_cast<JsonString *>(node);
+                break;
+            }
+            node = next;
+        }
+        return node;
+    }
+
+    bool JsonNode::release(JsonNode *node) noexcept
+    {
+        // Another container or document still holds the node. A node held by only one owner is
+        // never shared again by someone else, so the common case does not need the atomic update.
+        return (node->references.load(std::memory_order_acquire) & ~sharedBit) == 1 ||
+               (node->references.fetch_sub(1, std::memory_order_acq_rel) & ~sharedBit) == 1;
+    }
+
+    void JsonNodeDeleter::operator()(JsonNode *node) const noexcept
+    {
+        JsonNode::destroy(nullptr, node);
+    }
+
     bool JsonNode::hasParent() const noexcept
     {
         return parent != nullptr;
@@ -55,63 +945,97 @@ namespace json
         return *parent;
     }
 
+    JsonNodeType JsonNode::getType() const noexcept
+    {
+        return type;
+    }
+
+    bool JsonNode::isShared() const noexcept
+    {
+        return (references.load(std::memory_order_acquire) & sharedBit) != 0;
+    }
+
     JsonArray &JsonNode::toArray()
     {
+        if (type == JsonNodeType::Array)
+            return static_cast<JsonArray &>(*this);
         throw std::runtime_error("Could not convert this object to an object of type JsonArray");
     }
 
     const JsonArray &JsonNode::toArray() const
     {
+        if (type == JsonNodeType::Array)
+            return static_cast<const JsonArray &>(*this);
         throw std::runtime_error("Could not convert this object to an object of type JsonArray");
     }
 
     JsonObject &JsonNode::toObject()
     {
+        if (type == JsonNodeType::Object)
+            return static_cast<JsonObject &>(*this);
         throw std::runtime_error("Could not convert this object to an object of type JsonObject");
     }
 
     const JsonObject &JsonNode::toObject() const
     {
+        if (type == JsonNodeType::Object)
+            return static_cast<const JsonObject &>(*this);
         throw std::runtime_error("Could not convert this object to an object of type JsonObject");
     }
 
     JsonBool &JsonNode::toBool()
     {
+        if (type == JsonNodeType::Bool)
+            return static_cast<JsonBool &>(*this);
         throw std::runtime_error("Could not convert this object to an object of type JsonBool");
     }
 
     const JsonBool &JsonNode::toBool() const
     {
+        if (type == JsonNodeType::Bool)
+            return static_cast<const JsonBool &>(*this);
         throw std::runtime_error("Could not convert this object to an object of type JsonBool");
     }
 
     JsonNull &JsonNode::toNull()
     {
+        if (type == JsonNodeType::Null)
+            return static_cast<JsonNull &>(*this);
         throw std::runtime_error("Could not convert this object to an object of type JsonNull");
     }
 
     const JsonNull &JsonNode::toNull() const
     {
+        if (type == JsonNodeType::Null)
+            return static_cast<const JsonNull &>(*this);
         throw std::runtime_error("Could not convert this object to an object of type JsonNull");
     }
 
     JsonNumber &JsonNode::toNumber()
     {
+        if (type == JsonNodeType::Number)
+            return static_cast<JsonNumber &>(*this);
         throw std::runtime_error("Could not convert this object to an object of type JsonNumber");
     }
 
     const JsonNumber &JsonNode::toNumber() const
     {
+        if (type == JsonNodeType::Number)
+            return static_cast<const JsonNumber &>(*this);
         throw std::runtime_error("Could not convert this object to an object of type JsonNumber");
     }
 
     JsonString &JsonNode::toString()
     {
+        if (type == JsonNodeType::String)
+            return static_cast<JsonString &>(*this);
         throw std::runtime_error("Could not convert this object to an object of type JsonString");
     }
 
     const JsonString &JsonNode::toString() const
     {
+        if (type == JsonNodeType::String)
+            return static_cast<const JsonString &>(*this);
         throw std::runtime_error("Could not convert this object to an object of type JsonString");
     }
 
@@ -175,23 +1099,45 @@ namespace json
         return toString();
     }
 
-    JsonNode &JsonNode::operator[](size_t)
+    JsonNode &JsonNode::operator[](size_t index)
     {
+        if (type == JsonNodeType::Array)
+            return static_cast<JsonArray &>(*this)[index];
         throw std::runtime_error("The object is not of type JsonArray and therefore you cannot use the subscript operator to access child elements");
     }
 
-    const JsonNode &JsonNode::operator[](size_t) const
+    const JsonNode &JsonNode::operator[](size_t index) const
     {
+        if (type == JsonNodeType::Array)
+            return static_cast<const JsonArray &>(*this)[index];
         throw std::runtime_error("The object is not of type JsonArray and therefore you cannot use the subscript operator to access child elements");
     }
 
-    JsonNode &JsonNode::operator[](const std::string &)
+    JsonNode &JsonNode::operator[](JsonStringView name)
+    {
+        if (type == JsonNodeType::Object)
+            return static_cast<JsonObject &>(*this)[name];
+        throw std::runtime_error("The object is not of type JsonObject and therefore you cannot use the subscript operator to access child elements");
+    }
+
+    const JsonNode &JsonNode::operator[](JsonStringView name) const
+    {
+        if (type == JsonNodeType::Object)
+            return static_cast<const JsonObject &>(*this)[name];
+        throw std::runtime_error("The object is not of type JsonObject and therefore you cannot use the subscript operator to access child elements");
+    }
+
+    JsonNode &JsonNode::operator[](const JsonKey &key)
     {
+        if (type == JsonNodeType::Object)
+            return static_cast<JsonObject &>(*this)[key];
         throw std::runtime_error("The object is not of type JsonObject and therefore you cannot use the subscript operator to access child elements");
     }
 
-    const JsonNode &JsonNode::operator[](const std::string &) const
+    const JsonNode &JsonNode::operator[](const JsonKey &key) const
     {
+        if (type == JsonNodeType::Object)
+            return static_cast<const JsonObject &>(*this)[key];
         throw std::runtime_error("The object is not of type JsonObject and therefore you cannot use the subscript operator to access child elements");
     }
 } // namespace json
\ No newline at end of file
@@ -26,26 +26,12 @@ THE SOFTWARE.
 
 namespace json
 {
-    JsonNull::JsonNull() : JsonNode()
+    JsonNull::JsonNull() : JsonNode(JsonNodeType::Null)
     {
     }
 
-    JsonNull::JsonNull(JsonNode *parent) : JsonNode(parent)
+    JsonNull::JsonNull(JsonNode *parent) : JsonNode(parent, JsonNodeType::Null)
     {
     }
 
-    JsonNodeType JsonNull::getType() const noexcept
-    {
-        return JsonNodeType::Null;
-    }
-
-    JsonNull &JsonNull::toNull()
-    {
-        return *this;
-    }
-
-    const JsonNull &JsonNull::toNull() const
-    {
-        return *this;
-    }
 } // namespace json
\ No newline at end of file
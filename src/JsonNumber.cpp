@@ -23,49 +23,582 @@ THE SOFTWARE.
 */
 
 #include "JsonNumber.hpp"
+#include "JsonArena.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
 
 namespace json
 {
-    JsonNumber::JsonNumber(double value) : JsonNode(), value(value)
+    namespace
+    {
+        // Numbers with this many characters or more are converted when they are created,
+        // so that converting a shorter number can use a buffer on the stack.
+        const size_t maximumLazyLength = 64;
+
+        // The digits of the numbers from 00 to 99, so that two digits are written at a time.
+        const char digitPairs[] =
+            "0001020304050607080910111213141516171819"
+            "2021222324252627282930313233343536373839"
+            "4041424344454647484950515253545556575859"
+            "6061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+
+        const uint64_t powersOfTen[] = {
+            1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL,
+            10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL, 100000000000000ULL,
+            1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL,
+            10000000000000000000ULL};
+
+        // The powers 10^-348, 10^-340, ..., 10^340 as a 64-bit significand with the highest bit set and a binary exponent,
+        // rounded to nearest. Grisu2 scales a value by one of them, see getCachedPower().
+        const uint64_t cachedSignificands[] = {
+            0xFA8FD5A0081C0288ULL, 0xBAAEE17FA23EBF76ULL, 0x8B16FB203055AC76ULL, 0xCF42894A5DCE35EAULL,
+            0x9A6BB0AA55653B2DULL, 0xE61ACF033D1A45DFULL, 0xAB70FE17C79AC6CAULL, 0xFF77B1FCBEBCDC4FULL,
+            0xBE5691EF416BD60CULL, 0x8DD01FAD907FFC3CULL, 0xD3515C2831559A83ULL, 0x9D71AC8FADA6C9B5ULL,
+            0xEA9C227723EE8BCBULL, 0xAECC49914078536DULL, 0x823C12795DB6CE57ULL, 0xC21094364DFB5637ULL,
+            0x9096EA6F3848984FULL, 0xD77485CB25823AC7ULL, 0xA086CFCD97BF97F4ULL, 0xEF340A98172AACE5ULL,
+            0xB23867FB2A35B28EULL, 0x84C8D4DFD2C63F3BULL, 0xC5DD44271AD3CDBAULL, 0x936B9FCEBB25C996ULL,
+            0xDBAC6C247D62A584ULL, 0xA3AB66580D5FDAF6ULL, 0xF3E2F893DEC3F126ULL, 0xB5B5ADA8AAFF80B8ULL,
+            0x87625F056C7C4A8BULL, 0xC9BCFF6034C13053ULL, 0x964E858C91BA2655ULL, 0xDFF9772470297EBDULL,
+            0xA6DFBD9FB8E5B88FULL, 0xF8A95FCF88747D94ULL, 0xB94470938FA89BCFULL, 0x8A08F0F8BF0F156BULL,
+            0xCDB02555653131B6ULL, 0x993FE2C6D07B7FACULL, 0xE45C10C42A2B3B06ULL, 0xAA242499697392D3ULL,
+            0xFD87B5F28300CA0EULL, 0xBCE5086492111AEBULL, 0x8CBCCC096F5088CCULL, 0xD1B71758E219652CULL,
+            0x9C40000000000000ULL, 0xE8D4A51000000000ULL, 0xAD78EBC5AC620000ULL, 0x813F3978F8940984ULL,
+            0xC097CE7BC90715B3ULL, 0x8F7E32CE7BEA5C70ULL, 0xD5D238A4ABE98068ULL, 0x9F4F2726179A2245ULL,
+            0xED63A231D4C4FB27ULL, 0xB0DE65388CC8ADA8ULL, 0x83C7088E1AAB65DBULL, 0xC45D1DF942711D9AULL,
+            0x924D692CA61BE758ULL, 0xDA01EE641A708DEAULL, 0xA26DA3999AEF774AULL, 0xF209787BB47D6B85ULL,
+            0xB454E4A179DD1877ULL, 0x865B86925B9BC5C2ULL, 0xC83553C5C8965D3DULL, 0x952AB45CFA97A0B3ULL,
+            0xDE469FBD99A05FE3ULL, 0xA59BC234DB398C25ULL, 0xF6C69A72A3989F5CULL, 0xB7DCBF5354E9BECEULL,
+            0x88FCF317F22241E2ULL, 0xCC20CE9BD35C78A5ULL, 0x98165AF37B2153DFULL, 0xE2A0B5DC971F303AULL,
+            0xA8D9D1535CE3B396ULL, 0xFB9B7CD9A4A7443CULL, 0xBB764C4CA7A44410ULL, 0x8BAB8EEFB6409C1AULL,
+            0xD01FEF10A657842CULL, 0x9B10A4E5E9913129ULL, 0xE7109BFBA19C0C9DULL, 0xAC2820D9623BF429ULL,
+            0x80444B5E7AA7CF85ULL, 0xBF21E44003ACDD2DULL, 0x8E679C2F5E44FF8FULL, 0xD433179D9C8CB841ULL,
+            0x9E19DB92B4E31BA9ULL, 0xEB96BF6EBADF77D9ULL, 0xAF87023B9BF0EE6BULL};
+
+        const int16_t cachedExponents[] = {
+            -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+            -901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+            -582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+            -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+            56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+            375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+            694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+            1013, 1039, 1066};
+
+        // A floating point number with a 64-bit significand and a binary exponent, without a sign.
+        struct DiyFp
+        {
+            uint64_t f;
+            int e;
+        };
+
+        const uint64_t hiddenBit = 1ULL << 52;
+        const uint64_t significandMask = hiddenBit - 1;
+
+        // Returns the product rounded to 64 bits, the lower half is computed in pieces of 32 bits.
+        DiyFp multiply(DiyFp lhs, DiyFp rhs) noexcept
+        {
+            const uint64_t mask = 0xFFFFFFFF;
+            uint64_t a = lhs.f >> 32, b = lhs.f & mask, c = rhs.f >> 32, d = rhs.f & mask;
+            uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+            uint64_t middle = (bd >> 32) + (ad & mask) + (bc & mask) + (1ULL << 31);
+            return {ac + (ad >> 32) + (bc >> 32) + (middle >> 32), lhs.e + rhs.e + 64};
+        }
+
+        DiyFp normalize(DiyFp value) noexcept
+        {
+            while (!(value.f & (1ULL << 63)))
+            {
+                value.f <<= 1;
+                value.e--;
+            }
+            return value;
+        }
+
+        // Returns a power of ten c such that a value with the binary exponent e, multiplied by c, has a binary exponent
+        // between -60 and -32. k is set to the decimal exponent of 1/c.
+        DiyFp getCachedPower(int e, int &k) noexcept
+        {
+            double dk = (-61 - e) * 0.30102999566398114 + 347;
+            int estimate = static_cast<int>(dk);
+            if (dk - estimate > 0.0)
+                estimate++;
+
+            size_t index = static_cast<size_t>((estimate >> 3) + 1);
+            k = -(-348 + static_cast<int>(index << 3));
+            return {cachedSignificands[index], cachedExponents[index]};
+        }
+
+        // Moves the last digit towards the value, as long as the digits stay within the range that reads back as the value.
+        void roundDigits(char *digits, int length, uint64_t delta, uint64_t rest, uint64_t tenKappa, uint64_t distance) noexcept
+        {
+            while (rest < distance && delta - rest >= tenKappa &&
+                   (rest + tenKappa < distance || distance - rest > rest + tenKappa - distance))
+            {
+                digits[length - 1]--;
+                rest += tenKappa;
+            }
+        }
+
+        // Writes the digits of w, where high is the upper end of the values that read back as w and delta the width of that range.
+        void generateDigits(DiyFp w, DiyFp high, uint64_t delta, char *digits, int &length, int &k) noexcept
+        {
+            DiyFp one = {1ULL << -high.e, high.e};
+            uint64_t distance = high.f - w.f;
+            uint32_t integral = static_cast<uint32_t>(high.f >> -one.e);
+            uint64_t fraction = high.f & (one.f - 1);
+
+            int kappa = 1;
+            while (kappa < 10 && integral >= powersOfTen[kappa])
+                kappa++;
+
+            length = 0;
+            while (kappa > 0)
+            {
+                // Dividing by constants lets the compiler use multiplications instead of divisions.
+                uint32_t digit;
+                switch (kappa)
+                {
+                case 10: digit = integral / 1000000000; integral %= 1000000000; break;
+                case 9: digit = integral / 100000000; integral %= 100000000; break;
+                case 8: digit = integral / 10000000; integral %= 10000000; break;
+                case 7: digit = integral / 1000000; integral %= 1000000; break;
+                case 6: digit = integral / 100000; integral %= 100000; break;
+                case 5: digit = integral / 10000; integral %= 10000; break;
+                case 4: digit = integral / 1000; integral %= 1000; break;
+                case 3: digit = integral / 100; integral %= 100; break;
+                case 2: digit = integral / 10; integral %= 10; break;
+                default: digit = integral; integral = 0; break;
+                }
+                if (digit || length)
+                    digits[length++] = static_cast<char>('0' + digit);
+                kappa--;
+
+                uint64_t rest = (static_cast<uint64_t>(integral) << -one.e) + fraction;
+                if (rest <= delta)
+                {
+                    k += kappa;
+                    roundDigits(digits, length, delta, rest, powersOfTen[kappa] << -one.e, distance);
+                    return;
+                }
+            }
+
+            for (;;)
+            {
+                fraction *= 10;
+                delta *= 10;
+                char digit = static_cast<char>(fraction >> -one.e);
+                if (digit || length)
+                    digits[length++] = static_cast<char>('0' + digit);
+                fraction &= one.f - 1;
+                kappa--;
+
+                if (fraction < delta)
+                {
+                    k += kappa;
+                    roundDigits(digits, length, delta, fraction, one.f, distance * (-kappa < 20 ? powersOfTen[-kappa] : 0));
+                    return;
+                }
+            }
+        }
+
+        // Writes the shortest digits of a positive value with the Grisu2 algorithm by Florian Loitsch,
+        // the value is the digits times 10^k. The digits always read back as the value,
+        // and are the shortest ones for almost every value.
+        void grisu2(double value, char *digits, int &length, int &k) noexcept
+        {
+            uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            int exponent = static_cast<int>((bits >> 52) & 0x7FF);
+            uint64_t significand = bits & significandMask;
+            DiyFp v = exponent != 0 ? DiyFp{significand + hiddenBit, exponent - 1075} : DiyFp{significand, -1074};
+
+            // The values halfway to the neighbouring doubles, with the same exponent.
+            DiyFp high = {(v.f << 1) + 1, v.e - 1};
+            while (!(high.f & (hiddenBit << 1)))
+            {
+                high.f <<= 1;
+                high.e--;
+            }
+            high.f <<= 10;
+            high.e -= 10;
+            DiyFp low = v.f == hiddenBit ? DiyFp{(v.f << 2) - 1, v.e - 2} : DiyFp{(v.f << 1) - 1, v.e - 1};
+            low.f <<= low.e - high.e;
+            low.e = high.e;
+
+            DiyFp power = getCachedPower(high.e, k);
+            DiyFp w = multiply(normalize(v), power);
+            DiyFp scaledHigh = multiply(high, power);
+            DiyFp scaledLow = multiply(low, power);
+            scaledLow.f++;
+            scaledHigh.f--;
+            generateDigits(w, scaledHigh, scaledHigh.f - scaledLow.f, digits, length, k);
+        }
+
+        char *writeInteger(uint64_t value, char *output) noexcept
+        {
+            char buffer[20];
+            char *first = buffer + sizeof(buffer);
+            while (value >= 100)
+            {
+                first -= 2;
+                std::memcpy(first, digitPairs + (value % 100) * 2, 2);
+                value /= 100;
+            }
+            if (value >= 10)
+            {
+                first -= 2;
+                std::memcpy(first, digitPairs + value * 2, 2);
+            }
+            else
+                *--first = static_cast<char>('0' + value);
+
+            size_t size = static_cast<size_t>(buffer + sizeof(buffer) - first);
+            std::memcpy(output, first, size);
+            return output + size;
+        }
+
+        char *writeZeros(char *output, int count) noexcept
+        {
+            for (int i = 0; i < count; i++)
+                *output++ = '0';
+            return output;
+        }
+
+        // Writes digits times 10^k in the notation a JavaScript engine would use.
+        char *writeDigits(const char *digits, int length, int k, char *output) noexcept
+        {
+            // The value is between 10^(point - 1) and 10^point.
+            int point = length + k;
+            if (k >= 0 && point <= 21)
+            {
+                std::memcpy(output, digits, static_cast<size_t>(length));
+                return writeZeros(output + length, k);
+            }
+            if (point > 0 && point <= 21)
+            {
+                std::memcpy(output, digits, static_cast<size_t>(point));
+                output[point] = '.';
+                std::memcpy(output + point + 1, digits + point, static_cast<size_t>(length - point));
+                return output + length + 1;
+            }
+            if (point > -6 && point <= 0)
+            {
+                *output++ = '0';
+                *output++ = '.';
+                output = writeZeros(output, -point);
+                std::memcpy(output, digits, static_cast<size_t>(length));
+                return output + length;
+            }
+
+            *output++ = digits[0];
+            if (length > 1)
+            {
+                *output++ = '.';
+                std::memcpy(output, digits + 1, static_cast<size_t>(length - 1));
+                output += length - 1;
+            }
+            *output++ = 'e';
+            int exponent = point - 1;
+            if (exponent < 0)
+            {
+                *output++ = '-';
+                exponent = -exponent;
+            }
+            return writeInteger(static_cast<uint64_t>(exponent), output);
+        }
+
+        char *writeNull(char *output) noexcept
+        {
+            std::memcpy(output, "null", 4);
+            return output + 4;
+        }
+    } // namespace
+
+    const size_t JsonNumber::maximumFormatSize;
+    const int JsonNumber::maximumDecimals;
+
+    JsonNumber::JsonNumber(double value) : JsonNode(JsonNodeType::Number), external(false), state(Decoded), ownsText(false), textSize(0), text(nullptr), value(value)
     {
     }
 
-    JsonNumber::JsonNumber(JsonNode *parent, double value) : JsonNode(parent), value(value)
+    JsonNumber::JsonNumber(JsonNode *parent, double value) : JsonNode(parent, JsonNodeType::Number), external(false), state(Decoded), ownsText(false), textSize(0), text(nullptr), value(value)
     {
     }
 
-    JsonNodeType JsonNumber::getType() const noexcept
+    JsonNumber::JsonNumber(JsonNode *parent, JsonArena *arena, JsonStringView text, JsonStringStorage storage)
+        : JsonNode(parent, JsonNodeType::Number), external(false), state(Decoded), ownsText(false), textSize(0), text(nullptr), value(0)
     {
-        return JsonNodeType::Number;
+        if (text.size() > std::numeric_limits<uint32_t>::max())
+        {
+            value = parse(text);
+            return;
+        }
+
+        JsonStringView kept = text;
+        if (!arena)
+        {
+            char *copied = new char[text.size()];
+            std::memcpy(copied, text.data(), text.size());
+            kept = JsonStringView(copied, text.size());
+            ownsText = true;
+        }
+        else if (storage != JsonStringStorage::Borrow)
+            kept = arena->copyString(text);
+        this->text = kept.data();
+        textSize = static_cast<uint32_t>(kept.size());
+
+        if (textSize >= maximumLazyLength)
+            value = parse(kept);
+        else
+            state.store(Encoded, std::memory_order_relaxed);
     }
 
-    JsonNumber &JsonNumber::toNumber()
+    JsonNumber::~JsonNumber()
     {
-        return *this;
+        if (ownsText)
+            delete[] text;
     }
 
-    const JsonNumber &JsonNumber::toNumber() const
+    JsonNumber::JsonNumber(JsonNode *parent, double *slot, ExternalSlot) noexcept
+        : JsonNode(parent, JsonNodeType::Number), external(true), state(Decoded), ownsText(false), textSize(0), text(nullptr), slot(slot)
     {
+    }
+
+    JsonNumber &JsonNumber::operator=(double value)
+    {
+        data() = value;
         return *this;
     }
 
-    double &JsonNumber::data() noexcept
+    double &JsonNumber::data()
     {
+        checkWritable();
+        if (external)
+            return *slot;
+        decode();
+        if (ownsText)
+            delete[] text;
+        ownsText = false;
+        textSize = 0;
+        text = nullptr;
         return value;
     }
 
     const double &JsonNumber::data() const noexcept
     {
+        if (external)
+            return *slot;
+        decode();
         return value;
     }
 
+    bool JsonNumber::hasText() const noexcept
+    {
+        return textSize > 0;
+    }
+
+    JsonStringView JsonNumber::getText() const noexcept
+    {
+        return JsonStringView(text, textSize);
+    }
+
+    bool JsonNumber::isInteger() const noexcept
+    {
+        if (hasText())
+            return std::memchr(text, '.', textSize) == nullptr && std::memchr(text, 'e', textSize) == nullptr && std::memchr(text, 'E', textSize) == nullptr;
+
+        double number = data();
+        return std::isfinite(number) && number == std::trunc(number);
+    }
+
+    int64_t JsonNumber::getInteger() const
+    {
+        if (!isInteger())
+            throw std::runtime_error("The number is not an integer");
+
+        if (hasText())
+        {
+            // The digits are added as a negative number, which can also hold the smallest integer.
+            bool negative = text[0] == '-';
+            int64_t result = 0;
+            for (size_t i = negative ? 1 : 0; i < textSize; i++)
+            {
+                int digit = text[i] - '0';
+                if (result < (std::numeric_limits<int64_t>::min() + digit) / 10)
+                    throw std::runtime_error("The number does not fit in an integer");
+                result = result * 10 - digit;
+            }
+            if (!negative && result == std::numeric_limits<int64_t>::min())
+                throw std::runtime_error("The number does not fit in an integer");
+            return negative ? result : -result;
+        }
+
+        double number = data();
+        if (number < -9223372036854775808.0 || number >= 9223372036854775808.0)
+            throw std::runtime_error("The number does not fit in an integer");
+        return static_cast<int64_t>(number);
+    }
+
     JsonNumber::operator double &()
     {
-        return value;
+        return data();
     }
 
     JsonNumber::operator const double &() const
     {
-        return value;
+        return data();
+    }
+
+    double JsonNumber::parse(JsonStringView text)
+    {
+        // The text does not end with a null character, so it is copied first.
+        char buffer[maximumLazyLength];
+        if (text.size() < sizeof(buffer))
+        {
+            std::memcpy(buffer, text.data(), text.size());
+            buffer[text.size()] = '\0';
+            return std::strtod(buffer, nullptr);
+        }
+        return std::strtod(std::string(text.data(), text.size()).c_str(), nullptr);
+    }
+
+    bool JsonNumber::formatsAs(double value, JsonStringView text) noexcept
+    {
+        char buffer[maximumFormatSize];
+        char *end = format(value, buffer);
+        return static_cast<size_t>(end - buffer) == text.size() && std::memcmp(buffer, text.data(), text.size()) == 0;
+    }
+
+    char *JsonNumber::format(double value, char *output) noexcept
+    {
+        if (!std::isfinite(value))
+            return writeNull(output);
+
+        if (std::signbit(value))
+        {
+            *output++ = '-';
+            value = -value;
+        }
+
+        // Integers take an exact path, which also gives every digit of large integers.
+        if (value < 18446744073709551616.0 && value == std::trunc(value))
+            return writeInteger(static_cast<uint64_t>(value), output);
+
+        char digits[20];
+        int length;
+        int k;
+        grisu2(value, digits, length, k);
+        return writeDigits(digits, length, k, output);
+    }
+
+    char *JsonNumber::format(double value, int decimals, char *output) noexcept
+    {
+        if (!std::isfinite(value))
+            return writeNull(output);
+        if (std::fabs(value) >= 1e21)
+            return format(value, output);
+        if (decimals < 0)
+            decimals = 0;
+        if (decimals > maximumDecimals)
+            decimals = maximumDecimals;
+
+        bool negative = std::signbit(value);
+        value = std::fabs(value);
+
+        // The shortest digits are rounded half up, so the decimals are those of the shortest text of the value.
+        // There is room for a carry in front of the digits.
+        char buffer[21];
+        char *digits = buffer + 1;
+        int length = 1;
+        int k = 0;
+        if (value == 0)
+            digits[0] = '0';
+        else
+            grisu2(value, digits, length, k);
+
+        int point = length + k;
+        int kept = point + decimals;
+        if (kept < length)
+        {
+            bool roundUp = kept >= 0 && digits[kept] >= '5';
+            length = kept > 0 ? kept : 0;
+            if (roundUp)
+            {
+                int i = length - 1;
+                while (i >= 0 && digits[i] == '9')
+                    digits[i--] = '0';
+                if (i >= 0)
+                    digits[i]++;
+                else
+                {
+                    // Every digit was a nine, or none was kept, so the value gains a digit in front.
+                    *--digits = '1';
+                    length++;
+                    point++;
+                }
+            }
+        }
+
+        // A value that rounds to zero is written without its sign, -0.001 with two decimals is 0.00.
+        if (negative && value != 0 && length > 0)
+            *output++ = '-';
+        if (point <= 0)
+            *output++ = '0';
+        for (int i = 0; i < point; i++)
+            *output++ = i < length ? digits[i] : '0';
+
+        if (decimals > 0)
+        {
+            *output++ = '.';
+            for (int i = point; i < point + decimals; i++)
+                *output++ = i >= 0 && i < length ? digits[i] : '0';
+        }
+        return output;
+    }
+
+    char *JsonNumber::formatInteger(int64_t value, char *output) noexcept
+    {
+        if (value >= 0)
+            return writeInteger(static_cast<uint64_t>(value), output);
+
+        // The magnitude is computed without overflow, also for the smallest value.
+        *output++ = '-';
+        return writeInteger(0 - static_cast<uint64_t>(value), output);
+    }
+
+    char *JsonNumber::formatInteger(uint64_t value, char *output) noexcept
+    {
+        return writeInteger(value, output);
+    }
+
+    JsonNumber *JsonNumber::copy(JsonArena *target, JsonNode *parent) const
+    {
+        if (hasText())
+            return JsonArena::create<JsonNumber>(target, parent, target, getText(), JsonStringStorage::Copy);
+        return JsonArena::create<JsonNumber>(target, parent, data());
+    }
+
+    void JsonNumber::decode() const noexcept
+    {
+        unsigned char current = state.load(std::memory_order_acquire);
+        if (current == Decoded)
+            return;
+
+        if (current == Encoded && state.compare_exchange_strong(current, Decoding, std::memory_order_acquire))
+        {
+            value = parse(getText());
+            state.store(Decoded, std::memory_order_release);
+            return;
+        }
+
+        while (state.load(std::memory_order_acquire) != Decoded)
+            std::this_thread::yield();
     }
-} // namespace json
\ No newline at end of file
+} // namespace json
@@ -28,319 +28,730 @@ THE SOFTWARE.
 #include "JsonNull.hpp"
 #include "JsonNumber.hpp"
 #include "JsonString.hpp"
+#include "JsonStringPool.hpp"
+#include "JsonDocument.hpp"
 
-#include <algorithm>
+#include <cstring>
+#include <stdexcept>
 
 namespace json
 {
-    JsonObject::JsonObject() : JsonNode(), childCounter(0)
+    namespace
+    {
+        // Objects with more names than this will use an index to find a name.
+        const size_t maximumLinearSearchSize = 8;
+
+        uint32_t *allocateIndex(JsonArena *arena, size_t capacity)
+        {
+            uint32_t *index = arena ? static_cast<uint32_t *>(arena->allocate(capacity * sizeof(uint32_t), alignof(uint32_t)))
+                                    : new uint32_t[capacity];
+            std::memset(index, 0, capacity * sizeof(uint32_t));
+            return index;
+        }
+
+        void deallocateIndex(JsonArena *arena, uint32_t *index) noexcept
+        {
+            if (!arena)
+                delete[] index;
+        }
+    } // namespace
+
+    JsonObject::JsonObject() : JsonObject(nullptr, nullptr)
     {
     }
 
-    JsonObject::JsonObject(JsonNode *parent) : JsonNode(parent), childCounter(0)
+    JsonObject::JsonObject(JsonNode *parent) : JsonObject(parent, nullptr)
     {
     }
 
-    JsonNodeType JsonObject::getType() const noexcept
+    JsonObject::JsonObject(JsonNode *parent, JsonArena *arena)
+        : JsonNode(parent, JsonNodeType::Object), arena(arena), shape(nullptr), dictionary(nullptr)
     {
-        return JsonNodeType::Object;
+        JsonStringPool *pool = arena ? arena->getStringPool() : nullptr;
+        if (pool)
+            shape = pool->getEmptyShape();
     }
 
-    JsonObject &JsonObject::toObject()
+    JsonObject::~JsonObject()
     {
-        return *this;
+        for (JsonNode *value : values)
+            destroy(arena, value);
+        values.deallocate(arena);
+
+        if (!dictionary)
+            return;
+
+        for (JsonStringView name : dictionary->names)
+            JsonArena::destroyString(arena, name);
+        dictionary->names.deallocate(arena);
+        deallocateIndex(arena, dictionary->index);
+
+        // Everything in an arena is released together with the arena.
+        if (!arena)
+            delete dictionary;
     }
 
-    const JsonObject &JsonObject::toObject() const
+    size_t JsonObject::findSlot(JsonStringView name, bool interned) const noexcept
     {
-        return *this;
+        if (shape)
+            return interned ? shape->findInterned(name) : shape->find(name);
+
+        if (!dictionary)
+            return 0;
+
+        if (dictionary->index)
+            return findInIndex(name, name.hash(), interned);
+
+        const JsonSmallVector<JsonStringView, 4> &names = dictionary->names;
+        for (size_t i = 0; i < names.size(); i++)
+        {
+            if (interned ? names[i].data() == name.data() : names[i] == name)
+                return i;
+        }
+        return names.size();
+    }
+
+    size_t JsonObject::findSlot(const JsonKey &key) const noexcept
+    {
+        // Objects with the same shape keep the name in the same slot.
+        if (shape && shape == key.shape)
+            return key.slot;
+
+        // All names of objects using the same pool are interned, so the pointers can be compared.
+        JsonStringPool *pool = arena ? arena->getStringPool() : nullptr;
+        bool interned = pool && pool == key.pool.get();
+        JsonStringView name = interned ? JsonStringView(key.interned, key.name.size()) : key.view();
+
+        size_t slot;
+        if (!shape && dictionary && dictionary->index)
+            slot = findInIndex(name, key.hash(), interned);
+        else
+            slot = findSlot(name, interned);
+
+        if (slot >= values.size())
+            return values.size();
+
+        if (pool && !interned)
+        {
+            key.pool = arena->getSharedStringPool();
+            key.interned = shape ? shape->getName(slot).data() : dictionary->names[slot].data();
+            key.shape = nullptr;
+        }
+        if (shape)
+        {
+            key.shape = shape;
+            key.slot = slot;
+        }
+        return slot;
     }
 
-    JsonNode &JsonObject::operator[](const std::string &name)
+    size_t JsonObject::findInIndex(JsonStringView name, size_t hash, bool interned) const noexcept
     {
-        // Can throw out_of_range exception.
-        return *children.at(name).node;
+        const JsonSmallVector<JsonStringView, 4> &names = dictionary->names;
+        size_t mask = dictionary->indexCapacity - 1;
+        for (size_t i = hash & mask; dictionary->index[i] != 0; i = (i + 1) & mask)
+        {
+            size_t slot = dictionary->index[i] - 1;
+            if (interned ? names[slot].data() == name.data() : names[slot] == name)
+                return slot;
+        }
+        return names.size();
+    }
+
+    void JsonObject::addName(JsonStringView name, JsonStringPool *pool)
+    {
+        if (shape)
+        {
+            const JsonShape *next = pool->addName(shape, name);
+            if (next)
+            {
+                shape = next;
+                return;
+            }
+
+            // The object is too large for a shape, or the pool has run out of shapes.
+            createDictionary();
+        }
+
+        if (!dictionary)
+            dictionary = JsonArena::create<Dictionary>(arena);
+
+        // The name is copied so that it lives as long as the child, unless it already lives in the pool.
+        JsonStringView key = pool ? name : JsonArena::copyString(arena, name, JsonMemoryCategory::KeyStrings);
+        try
+        {
+            dictionary->names.push_back(key, arena);
+            size_t count = dictionary->names.size();
+
+            // The index is kept at most half full.
+            if (dictionary->index && count * 2 <= dictionary->indexCapacity)
+                addToIndex(count - 1);
+            else if (count > maximumLinearSearchSize)
+                createIndex(dictionary->index ? dictionary->indexCapacity * 2 : 32);
+        }
+        catch (...)
+        {
+            if (dictionary->names.size() > values.size())
+                dictionary->names.pop_back();
+            if (!pool)
+                JsonArena::destroyString(arena, key);
+            throw;
+        }
+    }
+
+    void JsonObject::createDictionary()
+    {
+        Dictionary *result = JsonArena::create<Dictionary>(arena);
+        try
+        {
+            result->names.reserve(shape->size(), arena);
+            for (size_t i = 0; i < shape->size(); i++)
+                result->names.push_back(shape->getName(i), arena);
+        }
+        catch (...)
+        {
+            result->names.deallocate(arena);
+            if (!arena)
+                delete result;
+            throw;
+        }
+
+        dictionary = result;
+        shape = nullptr;
+
+        if (dictionary->names.size() > maximumLinearSearchSize)
+            createIndex(64);
+    }
+
+    void JsonObject::createIndex(size_t capacity)
+    {
+        uint32_t *index = allocateIndex(arena, capacity);
+        deallocateIndex(arena, dictionary->index);
+        dictionary->index = index;
+        dictionary->indexCapacity = capacity;
+
+        for (size_t i = 0; i < dictionary->names.size(); i++)
+            addToIndex(i);
+    }
+
+    void JsonObject::addToIndex(size_t slot) noexcept
+    {
+        size_t mask = dictionary->indexCapacity - 1;
+        size_t i = dictionary->names[slot].hash() & mask;
+        while (dictionary->index[i] != 0)
+            i = (i + 1) & mask;
+        dictionary->index[i] = static_cast<uint32_t>(slot + 1);
+    }
+
+    JsonNode &JsonObject::writableChild(size_t slot)
+    {
+        // A shared object is only read.
+        if (isShared())
+            return *values[slot];
+        return unshare(arena, this, values[slot]);
+    }
+
+    JsonObject *JsonObject::copy(JsonArena *target, JsonNode *parent) const
+    {
+        JsonObject *result = JsonArena::create<JsonObject>(target, parent, target);
+        try
+        {
+            result->values.reserve(values.size(), target);
+            result->copyNames(*this, nullptr);
+            for (JsonNode *value : values)
+                result->values.push_back(share(value), target);
+        }
+        catch (...)
+        {
+            destroy(target, result);
+            throw;
+        }
+        return result;
     }
 
-    const JsonNode &JsonObject::operator[](const std::string &name) const
+    void JsonObject::copyNames(const JsonObject &source, ShapeMap *shapes)
     {
-        // Can throw out_of_range exception.
-        return *children.at(name).node;
+        JsonStringPool *pool = arena ? arena->getStringPool() : nullptr;
+
+        // Objects with the same names share the shape, as long as the names come from the same pool.
+        if (source.shape && pool == source.arena->getStringPool())
+        {
+            shape = source.shape;
+            return;
+        }
+
+        if (source.shape && shapes)
+        {
+            auto it = shapes->find(source.shape);
+            if (it != shapes->end())
+            {
+                shape = it->second;
+                return;
+            }
+        }
+
+        for (size_t i = 0; i < source.values.size(); i++)
+        {
+            JsonStringView name = source.shape ? source.shape->getName(i) : source.dictionary->names[i];
+            addName(pool ? pool->intern(name) : name, pool);
+        }
+
+        if (source.shape && shapes && shape)
+            shapes->emplace(source.shape, shape);
     }
 
-    template <typename ChildType>
-    ChildType &JsonObject::setChild(const std::string &name)
+    void JsonObject::addMemoryUsage(JsonMemoryUsage &usage) const noexcept
     {
-        std::unique_ptr<JsonNode> child(new ChildType(this));
-        ChildType &ref = *child; // We take a reference to the child before we move it into the unordered_map.
-        children[name] = {std::move(child), childCounter++};
-        return ref;
+        values.addMemoryUsage(usage, JsonMemoryCategory::ContainerStorage);
+        if (!dictionary)
+            return;
+
+        usage.containerStorage += sizeof(Dictionary) + dictionary->indexCapacity * sizeof(uint32_t);
+        dictionary->names.addMemoryUsage(usage, JsonMemoryCategory::ContainerStorage);
+
+        // Names interned in the pool are counted by the pool.
+        if (arena && arena->getStringPool())
+            return;
+        for (const JsonStringView &name : dictionary->names)
+            usage.keyStrings += name.size();
     }
 
-    template <typename ChildType>
-    ChildType &JsonObject::setChild(std::string &&name)
+    JsonNode &JsonObject::operator[](JsonStringView name)
     {
-        std::unique_ptr<JsonNode> child(new ChildType(this));
-        ChildType &ref = *child;
-        children[std::move(name)] = {std::move(child), childCounter++};
-        return ref;
+        return getChild(name);
     }
 
-    template <typename ChildType, typename ArgType>
-    ChildType &JsonObject::setChild(const std::string &name, ArgType arg)
+    const JsonNode &JsonObject::operator[](JsonStringView name) const
     {
-        std::unique_ptr<JsonNode> child(new ChildType(this, arg));
-        ChildType &ref = *child;
-        children[name] = {std::move(child), childCounter++};
-        return ref;
+        return getChild(name);
     }
 
-    template <typename ChildType, typename ArgType>
-    ChildType &JsonObject::setChild(std::string &&name, ArgType arg)
+    JsonNode &JsonObject::operator[](const JsonKey &key)
     {
-        std::unique_ptr<JsonNode> child(new ChildType(this, arg));
-        ChildType &ref = *child;
-        children[std::move(name)] = {std::move(child), childCounter++};
-        return ref;
+        return getChild(key);
+    }
+
+    const JsonNode &JsonObject::operator[](const JsonKey &key) const
+    {
+        return getChild(key);
+    }
+
+    template <typename ChildType, typename... Args>
+    ChildType &JsonObject::setChild(JsonStringView name, Args &&... args)
+    {
+        ChildType *child = JsonArena::create<ChildType>(arena, std::forward<Args>(args)...);
+
+        try
+        {
+            insertChild(name, child);
+        }
+        catch (...)
+        {
+            destroy(arena, child);
+            throw;
+        }
+        return *child;
+    }
+
+    void JsonObject::insertChild(JsonStringView name, JsonNode *child)
+    {
+        checkWritable();
+
+        // Interned names are equal exactly when they point to the same characters.
+        JsonStringPool *pool = arena ? arena->getStringPool() : nullptr;
+        if (pool)
+            name = pool->intern(name);
+
+        size_t slot = findSlot(name, pool != nullptr);
+
+        if (slot < values.size())
+        {
+            // The name is already taken, we keep the name and its position and replace the old node.
+            destroy(arena, values[slot]);
+            values[slot] = child;
+            return;
+        }
+
+        values.reserve(values.size() + 1, arena);
+        addName(name, pool);
+
+        // There is room for the value, so this can not fail.
+        values.push_back(child, arena);
+    }
+
+    JsonNode *JsonObject::takeChild(size_t slot)
+    {
+        // The other objects with this shape still have the name, so this object gets names of its own.
+        if (shape)
+            createDictionary();
+
+        JsonNode *node = values[slot];
+        JsonStringView key = dictionary->names[slot];
+        values.erase(slot);
+        dictionary->names.erase(slot);
+
+        // The following names have moved one slot to the front, so the index is built again.
+        if (dictionary->index)
+        {
+            std::memset(dictionary->index, 0, dictionary->indexCapacity * sizeof(uint32_t));
+            for (size_t i = 0; i < dictionary->names.size(); i++)
+                addToIndex(i);
+        }
+
+        JsonArena::destroyString(arena, key);
+        return node;
     }
 
     JsonArray &JsonObject::setArray(const std::string &name)
     {
-        return setChild<JsonArray>(name);
+        return setChild<JsonArray>(name, this, arena);
     }
 
     JsonArray &JsonObject::setArray(std::string &&name)
     {
-        return setChild<JsonArray>(std::move(name));
+        return setChild<JsonArray>(name, this, arena);
     }
 
     JsonObject &JsonObject::setObject(const std::string &name)
     {
-        return setChild<JsonObject>(name);
+        return setChild<JsonObject>(name, this, arena);
     }
 
     JsonObject &JsonObject::setObject(std::string &&name)
     {
-        return setChild<JsonObject>(std::move(name));
+        return setChild<JsonObject>(name, this, arena);
     }
 
     JsonBool &JsonObject::setBool(const std::string &name, bool value)
     {
-        return setChild<JsonBool, bool>(name, value);
+        return setChild<JsonBool>(name, this, value);
     }
 
     JsonBool &JsonObject::setBool(std::string &&name, bool value)
     {
-        return setChild<JsonBool, bool>(std::move(name), value);
+        return setChild<JsonBool>(name, this, value);
     }
 
     JsonNull &JsonObject::setNull(const std::string &name)
     {
-        return setChild<JsonNull>(name);
+        return setChild<JsonNull>(name, this);
     }
 
     JsonNull &JsonObject::setNull(std::string &&name)
     {
-        return setChild<JsonNull>(std::move(name));
+        return setChild<JsonNull>(name, this);
     }
 
     JsonNumber &JsonObject::setNumber(const std::string &name, double value)
     {
-        return setChild<JsonNumber, double>(name, value);
+        return setChild<JsonNumber>(name, this, value);
     }
 
     JsonNumber &JsonObject::setNumber(std::string &&name, double value)
     {
-        return setChild<JsonNumber, double>(std::move(name), value);
+        return setChild<JsonNumber>(name, this, value);
     }
 
     JsonString &JsonObject::setString(const std::string &name, const std::string &value)
     {
-        return setChild<JsonString, const std::string &>(name, value);
+        return setChild<JsonString>(name, this, arena, JsonStringView(value));
     }
 
     JsonString &JsonObject::setString(std::string &&name, const std::string &value)
     {
-        return setChild<JsonString, const std::string &>(std::move(name), value);
+        return setChild<JsonString>(name, this, arena, JsonStringView(value));
     }
 
     JsonString &JsonObject::setString(const std::string &name, std::string &&value)
     {
-        std::unique_ptr<JsonNode> child(new JsonString(this, std::move(value)));
-        JsonString &ref = *child;
-        children[name] = {std::move(child), childCounter++};
-        return ref;
+        if (arena)
+            return setChild<JsonString>(name, this, arena, JsonStringView(value));
+        return setChild<JsonString>(name, this, std::move(value));
     }
 
     JsonString &JsonObject::setString(std::string &&name, std::string &&value)
     {
-        std::unique_ptr<JsonNode> child(new JsonString(this, std::move(value)));
-        JsonString &ref = *child;
-        children[std::move(name)] = {std::move(child), childCounter++};
-        return ref;
+        if (arena)
+            return setChild<JsonString>(name, this, arena, JsonStringView(value));
+        return setChild<JsonString>(name, this, std::move(value));
     }
 
     bool JsonObject::empty() const noexcept
     {
-        return children.empty();
+        return values.empty();
     }
 
     size_t JsonObject::getChildCount() const noexcept
     {
-        return children.size();
+        return values.size();
+    }
+
+    bool JsonObject::hasChild(JsonStringView name) const noexcept
+    {
+        return findSlot(name, false) < values.size();
+    }
+
+    bool JsonObject::hasChild(const JsonKey &key) const noexcept
+    {
+        return findSlot(key) < values.size();
+    }
+
+    JsonNode &JsonObject::getChild(JsonStringView name)
+    {
+        size_t slot = findSlot(name, false);
+
+        if (slot >= values.size())
+            throw std::out_of_range("JsonObject has no child named \"" + name.str() + "\"");
+
+        return writableChild(slot);
+    }
+
+    const JsonNode &JsonObject::getChild(JsonStringView name) const
+    {
+        size_t slot = findSlot(name, false);
+
+        if (slot >= values.size())
+            throw std::out_of_range("JsonObject has no child named \"" + name.str() + "\"");
+
+        return *values[slot];
+    }
+
+    JsonNode &JsonObject::getChild(const JsonKey &key)
+    {
+        size_t slot = findSlot(key);
+
+        if (slot >= values.size())
+            throw std::out_of_range("JsonObject has no child named \"" + key.view().str() + "\"");
+
+        return writableChild(slot);
+    }
+
+    const JsonNode &JsonObject::getChild(const JsonKey &key) const
+    {
+        size_t slot = findSlot(key);
+
+        if (slot >= values.size())
+            throw std::out_of_range("JsonObject has no child named \"" + key.view().str() + "\"");
+
+        return *values[slot];
+    }
+
+    JsonNode &JsonObject::getChildAt(size_t index)
+    {
+        if (index >= values.size())
+            throw std::out_of_range("JsonObject index out of range");
+
+        return writableChild(index);
     }
 
-    bool JsonObject::hasChild(const std::string &name) const noexcept
+    const JsonNode &JsonObject::getChildAt(size_t index) const
     {
-        return children.find(name) != children.end();
+        if (index >= values.size())
+            throw std::out_of_range("JsonObject index out of range");
+
+        return *values[index];
     }
 
-    JsonNode &JsonObject::getChild(const std::string &name)
+    JsonStringView JsonObject::getNameAt(size_t index) const
     {
-        return *children.at(name).node;
+        if (index >= values.size())
+            throw std::out_of_range("JsonObject index out of range");
+
+        return shape ? shape->getName(index) : dictionary->names[index];
     }
 
-    const JsonNode &JsonObject::getChild(const std::string &name) const
+    const JsonShape *JsonObject::getShape() const noexcept
     {
-        return *children.at(name).node;
+        return shape;
     }
 
-    void JsonObject::removeChild(const std::string &name)
+    void JsonObject::removeChild(JsonStringView name)
     {
-        children.erase(name);
+        checkWritable();
+        size_t slot = findSlot(name, false);
+
+        if (slot >= values.size())
+            return;
+
+        destroy(arena, takeChild(slot));
+    }
+
+    void JsonObject::reserve(size_t capacity)
+    {
+        checkWritable();
+        values.reserve(capacity, arena);
+
+        // An object that is going to outgrow the shapes gets names of its own right away.
+        if (shape && capacity > JsonStringPool::getMaximumShapeSize())
+            createDictionary();
+
+        if (shape)
+            return;
+
+        if (!dictionary)
+            dictionary = JsonArena::create<Dictionary>(arena);
+        dictionary->names.reserve(capacity, arena);
+
+        // The index is kept at most half full, so it is made large enough for all the names at once.
+        if (capacity > maximumLinearSearchSize)
+        {
+            size_t indexCapacity = 32;
+            while (indexCapacity < capacity * 2)
+                indexCapacity *= 2;
+            if (indexCapacity > dictionary->indexCapacity)
+                createIndex(indexCapacity);
+        }
+    }
+
+    JsonDocument JsonObject::detach(const std::string &name)
+    {
+        checkWritable();
+        size_t slot = findSlot(name, false);
+
+        if (slot >= values.size())
+            throw std::out_of_range("JsonObject has no child named \"" + name + "\"");
+
+        JsonDocument subtree = JsonDocument::adopt(arena, &unshare(arena, this, values[slot]));
+        JsonNode *child = takeChild(slot);
+        setParent(child, nullptr);
+        return subtree;
+    }
+
+    JsonNode &JsonObject::attach(const std::string &name, JsonDocument &&subtree)
+    {
+        checkWritable();
+        JsonDocument::Transfer transfer(subtree, *this, arena);
+        JsonNode *child = transfer.getNode();
+
+        insertChild(name, child);
+        transfer.commit();
+        setParent(child, this);
+        return *child;
+    }
+
+    JsonNode &JsonObject::splice(const std::string &name, JsonObject &source, const std::string &sourceName)
+    {
+        // Moving a child onto itself would move it to the end of the insertion order.
+        if (&source == this && sourceName == name)
+            return getChild(name);
+
+        JsonDocument subtree = source.detach(sourceName);
+        try
+        {
+            return attach(name, std::move(subtree));
+        }
+        catch (...)
+        {
+            // Put the child back under its old name, the order of the source may change.
+            source.attach(sourceName, std::move(subtree));
+            throw;
+        }
     }
 
     using iterator = JsonObject::iterator;
 
-    iterator::iterator(std::unordered_map<std::string, Value>::iterator it) : it(it)
+    iterator::iterator(JsonObject *object, size_t index) : object(object), index(index)
     {
     }
 
     iterator iterator::operator++()
     {
-        return ++it;
+        index++;
+        return *this;
     }
 
     iterator iterator::operator++(int)
     {
-        return it++;
+        return iterator(object, index++);
     }
 
     bool iterator::operator!=(const iterator &rhs)
     {
-        return it != rhs.it;
+        return index != rhs.index || object != rhs.object;
     }
 
     bool iterator::operator==(const iterator &rhs)
     {
-        return it == rhs.it;
+        return index == rhs.index && object == rhs.object;
     }
 
-    std::pair<const std::string &, JsonNode &> iterator::operator*()
+    std::pair<JsonStringView, JsonNode &> iterator::operator*()
     {
-        return {it->first, *it->second.node};
+        return {object->shape ? object->shape->getName(index) : object->dictionary->names[index], object->writableChild(index)};
     }
 
     using const_iterator = JsonObject::const_iterator;
 
-    const_iterator::const_iterator(std::unordered_map<std::string, Value>::const_iterator it) : it(it)
+    const_iterator::const_iterator(const JsonObject *object, size_t index) : object(object), index(index)
     {
     }
 
     const_iterator const_iterator::operator++()
     {
-        return ++it;
+        index++;
+        return *this;
     }
 
     const_iterator const_iterator::operator++(int)
     {
-        return it++;
+        return const_iterator(object, index++);
     }
 
     bool const_iterator::operator!=(const const_iterator &rhs)
     {
-        return it != rhs.it;
+        return index != rhs.index || object != rhs.object;
     }
 
     bool const_iterator::operator==(const const_iterator &rhs)
     {
-        return it == rhs.it;
+        return index == rhs.index && object == rhs.object;
     }
 
-    std::pair<const std::string &, const JsonNode &> const_iterator::operator*() const
+    std::pair<JsonStringView, const JsonNode &> const_iterator::operator*() const
     {
-        return {it->first, *it->second.node};
+        return {object->shape ? object->shape->getName(index) : object->dictionary->names[index], *object->values[index]};
     }
 
     iterator JsonObject::begin()
     {
-        return iterator(children.begin());
+        return iterator(this, 0);
     }
 
     iterator JsonObject::end()
     {
-        return iterator(children.end());
+        return iterator(this, values.size());
     }
 
     const_iterator JsonObject::begin() const
     {
-        return const_iterator(children.begin());
+        return const_iterator(this, 0);
     }
 
     const_iterator JsonObject::end() const
     {
-        return const_iterator(children.end());
+        return const_iterator(this, values.size());
     }
 
-    std::vector<std::pair<const std::string &, JsonNode &>> JsonObject::sort()
+    std::vector<std::pair<JsonStringView, JsonNode &>> JsonObject::sort()
     {
-        // Create a new vector and reserve enough space.
-        std::vector<std::pair<const std::string *, Value *>> temp;
-        temp.reserve(children.size());
+        // The children are already stored in insertion order.
+        std::vector<std::pair<JsonStringView, JsonNode &>> result;
+        result.reserve(values.size());
 
-        // Fill up the array.
-        for (auto &pair : children)
-            temp.emplace_back(&pair.first, &pair.second);
-
-        // Sort the array based on the insertion order.
-        std::sort(temp.begin(), temp.end(), [](const std::pair<const std::string *, Value *> &left, const std::pair<const std::string *, Value *> &right) {
-            return left.second->orderIndex < right.second->orderIndex;
-        });
-
-        // We don't want to return a vector of std::pair<const std::string *, Value*>
-        // therefore we create a new vector of the type we want to return.
-        std::vector<std::pair<const std::string &, JsonNode &>> result;
-        result.reserve(children.size());
-
-        for (auto &pair : temp)
-            result.emplace_back(*pair.first, *pair.second->node);
+        for (auto pair : *this)
+            result.emplace_back(pair.first, pair.second);
 
         return result;
     }
 
-    std::vector<std::pair<const std::string &, const JsonNode &>> JsonObject::sort() const
+    std::vector<std::pair<JsonStringView, const JsonNode &>> JsonObject::sort() const
     {
-        // Create a new vector and reserve enough space.
-        std::vector<std::pair<const std::string *, const Value *>> temp;
-        temp.reserve(children.size());
-
-        // Fill up the array.
-        for (const auto &pair : children)
-            temp.emplace_back(&pair.first, &pair.second);
-
-        // Sort the array based on the insertion order.
-        std::sort(temp.begin(), temp.end(), [](const std::pair<const std::string *, const Value *> &left, const std::pair<const std::string *, const Value *> &right) {
-            return left.second->orderIndex < right.second->orderIndex;
-        });
-
-        // We don't want to return a vector of std::pair<const std::string *, Value*>
-        // therefore we create a new vector of the type we want to return.
-        std::vector<std::pair<const std::string &, const JsonNode &>> result;
-        result.reserve(children.size());
+        std::vector<std::pair<JsonStringView, const JsonNode &>> result;
+        result.reserve(values.size());
 
-        for (const auto &pair : temp)
-            result.emplace_back(*pair.first, *pair.second->node);
+        for (auto pair : *this)
+            result.emplace_back(pair.first, pair.second);
 
         return result;
     }
-} // namespace json
\ No newline at end of file
+} // namespace json
@@ -0,0 +1,132 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "JsonOutputBuffer.hpp"
+
+namespace json
+{
+    namespace
+    {
+        // The room a string gets when it is first written to.
+        const size_t initialStringSize = 256;
+    } // namespace
+
+    JsonOutputBuffer::JsonOutputBuffer(std::string &output)
+        : string(&output), stream(nullptr), blockSize(0), begin(nullptr), position(nullptr), end(nullptr), written(0)
+    {
+    }
+
+    JsonOutputBuffer::JsonOutputBuffer(std::ostream &output, size_t blockSize)
+        : string(nullptr), stream(&output), blockSize(blockSize > 0 ? blockSize : 1), begin(nullptr), position(nullptr),
+          end(nullptr), written(0)
+    {
+    }
+
+    JsonOutputBuffer::~JsonOutputBuffer()
+    {
+        try
+        {
+            flush();
+        }
+        catch (...)
+        {
+            // A stream that reports errors with exceptions has already been told about them by an earlier write.
+        }
+    }
+
+    void JsonOutputBuffer::flush()
+    {
+        if (string)
+        {
+            // The string was grown ahead of the text, so it is cut back to what was written.
+            // The next write grows it again.
+            if (begin)
+            {
+                written += static_cast<size_t>(position - begin);
+                string->resize(static_cast<size_t>(position - &(*string)[0]));
+            }
+            begin = position = end = nullptr;
+        }
+        else
+        {
+            flushBlock();
+            stream->flush();
+        }
+    }
+
+    size_t JsonOutputBuffer::size() const noexcept
+    {
+        return written + static_cast<size_t>(position - begin);
+    }
+
+    void JsonOutputBuffer::makeRoom(size_t size)
+    {
+        if (string)
+        {
+            // The string is grown ahead of the text by doubling its size, which uses the capacity it already has
+            // without filling all of it at once.
+            size_t offset = begin ? static_cast<size_t>(begin - &(*string)[0]) : string->size();
+            size_t used = begin ? static_cast<size_t>(position - &(*string)[0]) : offset;
+            size_t required = used + size;
+            size_t grown = string->size() * 2;
+            if (grown < initialStringSize)
+                grown = initialStringSize;
+            string->resize(grown > required ? grown : required);
+
+            begin = &(*string)[0] + offset;
+            position = &(*string)[0] + used;
+            end = &(*string)[0] + string->size();
+            return;
+        }
+
+        flushBlock();
+        if (block.size() < size || block.size() < blockSize)
+            block.resize(size > blockSize ? size : blockSize);
+        begin = position = &block[0];
+        end = begin + block.size();
+    }
+
+    void JsonOutputBuffer::writeSlow(const char *data, size_t size)
+    {
+        // Large pieces bypass the block, so they are not copied twice.
+        if (stream && size >= blockSize)
+        {
+            flushBlock();
+            stream->write(data, static_cast<std::streamsize>(size));
+            written += size;
+            return;
+        }
+        makeRoom(size);
+        std::memcpy(position, data, size);
+        position += size;
+    }
+
+    void JsonOutputBuffer::flushBlock()
+    {
+        if (position != begin)
+            stream->write(begin, static_cast<std::streamsize>(position - begin));
+        written += static_cast<size_t>(position - begin);
+        position = begin;
+    }
+} // namespace json
\ No newline at end of file
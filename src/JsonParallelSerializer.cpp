@@ -0,0 +1,278 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "JsonParallelSerializer.hpp"
+#include "JsonArray.hpp"
+#include "JsonObject.hpp"
+#include "JsonSerializer.hpp"
+#include "JsonString.hpp"
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace json
+{
+    namespace
+    {
+        // Every thread gets several chunks, so a thread that finishes early takes over work from the others.
+        const size_t chunksPerThread = 8;
+
+        // How many chunks per thread may be written ahead of the output, which bounds the memory used for the text.
+        const size_t chunksAhead = 2;
+
+        // Below this number of nodes starting threads takes longer than writing the container on the calling thread.
+        const size_t minimumNodes = 16384;
+
+        bool isContainer(const JsonNode &node) noexcept
+        {
+            return node.getType() == JsonNodeType::Array || node.getType() == JsonNodeType::Object;
+        }
+
+        size_t getChildCount(const JsonNode &node) noexcept
+        {
+            if (node.getType() == JsonNodeType::Array)
+                return static_cast<const JsonArray &>(node).getChildCount();
+            if (node.getType() == JsonNodeType::Object)
+                return static_cast<const JsonObject &>(node).getChildCount();
+            return 0;
+        }
+
+        // Returns the only child of a container if it is an array or an object, otherwise nullptr.
+        const JsonNode *getOnlyContainer(const JsonNode &node)
+        {
+            if (getChildCount(node) != 1)
+                return nullptr;
+            const JsonNode *child = nullptr;
+            if (node.getType() == JsonNodeType::Object)
+                child = &static_cast<const JsonObject &>(node).getChildAt(0);
+            else if (!static_cast<const JsonArray &>(node).isPacked())
+                child = &static_cast<const JsonArray &>(node).getChild(0);
+            return child && isContainer(*child) ? child : nullptr;
+        }
+
+        // Returns true if a container holds at least minimumNodes nodes. At most that many nodes are visited,
+        // so the check takes the same short time for a container of any size.
+        bool isLarge(const JsonNode &container)
+        {
+            std::vector<const JsonNode *> pending(1, &container);
+            size_t count = 0;
+            while (!pending.empty())
+            {
+                const JsonNode &node = *pending.back();
+                pending.pop_back();
+                count += getChildCount(node);
+                if (count >= minimumNodes)
+                    return true;
+
+                // The numbers of a packed array have no nodes to visit.
+                if (node.getType() == JsonNodeType::Array)
+                {
+                    const JsonArray &array = static_cast<const JsonArray &>(node);
+                    if (array.isPacked())
+                        continue;
+                    for (size_t i = 0; i < array.getChildCount(); i++)
+                    {
+                        if (isContainer(array.getChild(i)))
+                            pending.push_back(&array.getChild(i));
+                    }
+                }
+                else
+                {
+                    const JsonObject &object = static_cast<const JsonObject &>(node);
+                    for (size_t i = 0; i < object.getChildCount(); i++)
+                    {
+                        if (isContainer(object.getChildAt(i)))
+                            pending.push_back(&object.getChildAt(i));
+                    }
+                }
+            }
+            return false;
+        }
+    } // namespace
+
+    JsonParallelSerializer::JsonParallelSerializer(JsonOutputBuffer &output, const JsonFormat &format) : output(output), format(format)
+    {
+    }
+
+    void JsonParallelSerializer::write(const JsonNode &node)
+    {
+        size_t threads = format.threads > 0 ? format.threads : std::thread::hardware_concurrency();
+
+        // The containers from the top of the tree down to the one that is split.
+        std::vector<const JsonNode *> path(1, &node);
+        while (const JsonNode *child = getOnlyContainer(*path.back()))
+            path.push_back(child);
+
+        const JsonNode &container = *path.back();
+        if (threads <= 1 || getChildCount(container) < 2 || !isLarge(container))
+        {
+            JsonSerializer serializer(output, format);
+            serializer.write(node);
+            return;
+        }
+
+        // The containers above the one that is split are written here, each of them holds nothing but the next one.
+        size_t depth = path.size() - 1;
+        for (size_t i = 0; i < depth; i++)
+        {
+            open(*path[i]);
+            indent(i + 1);
+            if (path[i]->getType() == JsonNodeType::Object)
+            {
+                output.write('\"');
+                JsonString::escape(static_cast<const JsonObject &>(*path[i]).getNameAt(0), output, format.ensureAscii);
+                if (format.pretty)
+                    output.write("\": ", 3);
+                else
+                    output.write("\":", 2);
+            }
+        }
+
+        open(container);
+        writeChunks(container, depth, threads);
+        indent(depth);
+        close(container);
+
+        for (size_t i = depth; i-- > 0;)
+        {
+            if (format.pretty)
+                output.write('\n');
+            indent(i);
+            close(*path[i]);
+        }
+    }
+
+    void JsonParallelSerializer::writeChunks(const JsonNode &container, size_t depth, size_t threads)
+    {
+        size_t count = getChildCount(container);
+        if (threads > count)
+            threads = count;
+
+        size_t chunkCount = threads * chunksPerThread < count ? threads * chunksPerThread : count;
+        std::vector<Chunk> chunks(chunkCount);
+        for (size_t i = 0; i < chunkCount; i++)
+            chunks[i] = {count * i / chunkCount, count * (i + 1) / chunkCount, std::string(), false};
+
+        std::mutex mutex;
+        std::condition_variable changed;
+        size_t next = 0;
+        size_t written = 0;
+        std::exception_ptr error;
+
+        auto work = [&]() {
+            for (;;)
+            {
+                size_t index;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    changed.wait(lock, [&]() { return error || next == chunkCount || next < written + threads * chunksAhead; });
+                    if (error || next == chunkCount)
+                        return;
+                    index = next++;
+                }
+
+                try
+                {
+                    JsonOutputBuffer buffer(chunks[index].text);
+                    JsonSerializer serializer(buffer, format);
+                    serializer.writeChildren(container, chunks[index].first, chunks[index].last, depth);
+                    buffer.flush();
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!error)
+                        error = std::current_exception();
+                    changed.notify_all();
+                    return;
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                chunks[index].done = true;
+                changed.notify_all();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        try
+        {
+            for (size_t i = 0; i < threads; i++)
+                workers.emplace_back(work);
+
+            // The calling thread hands the chunks to the output in order while the workers write the next ones.
+            for (size_t i = 0; i < chunkCount; i++)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    changed.wait(lock, [&]() { return error || chunks[i].done; });
+                    if (error)
+                        break;
+                }
+
+                output.write(chunks[i].text.data(), chunks[i].text.size());
+                std::string().swap(chunks[i].text);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                written = i + 1;
+                changed.notify_all();
+            }
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error)
+                error = std::current_exception();
+            changed.notify_all();
+        }
+
+        for (std::thread &worker : workers)
+            worker.join();
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    void JsonParallelSerializer::open(const JsonNode &container)
+    {
+        output.write(container.getType() == JsonNodeType::Array ? '[' : '{');
+        if (format.pretty)
+            output.write('\n');
+    }
+
+    void JsonParallelSerializer::close(const JsonNode &container)
+    {
+        output.write(container.getType() == JsonNodeType::Array ? ']' : '}');
+    }
+
+    void JsonParallelSerializer::indent(size_t depth)
+    {
+        size_t width = depth * format.tabSize;
+        if (!format.pretty || width == 0)
+            return;
+        if (spaces.size() < width)
+            spaces.resize(width, ' ');
+        output.write(spaces.data(), width);
+    }
+} // namespace json
\ No newline at end of file
@@ -34,172 +34,361 @@ THE SOFTWARE.
 
 namespace json
 {
-    std::unique_ptr<JsonNode> JsonParser::parse(std::istream &input)
+    namespace
     {
-        std::unique_ptr<JsonNode> root = nullptr;
-        JsonToken current = JsonLexer::nextToken(input);
+        // Arrays with at least this many numbers and nothing else are stored packed.
+        const size_t minimumPackedSize = 8;
+    } // namespace
+
+    JsonParser::Context::Context(std::istream *input, char *position, char *end, JsonArena *arena, JsonStringStorage storage)
+        : input(input), position(position), end(end), arena(arena), storage(storage), current(JsonTokenType::EndOfFile), nameCount(0)
+    {
+    }
+
+    JsonNodePtr JsonParser::parse(std::istream &input)
+    {
+        Context context(&input, nullptr, nullptr, nullptr, JsonStringStorage::Copy);
+        return JsonNodePtr(parseRoot(context));
+    }
+
+    JsonNode *JsonParser::parse(std::istream &input, JsonArena &arena)
+    {
+        Context context(&input, nullptr, nullptr, &arena, JsonStringStorage::Copy);
+        return parseRoot(context);
+    }
+
+    JsonNode *JsonParser::parse(char *buffer, size_t size, JsonArena &arena)
+    {
+        Context context(nullptr, buffer, buffer + size, &arena, JsonStringStorage::Borrow);
+        return parseRoot(context);
+    }
+
+    void JsonParser::nextToken(Context &context)
+    {
+        if (context.input)
+            JsonLexer::nextToken(*context.input, context.current);
+        else
+            JsonLexer::nextToken(context.position, context.end, context.current);
+    }
+
+    JsonNode *JsonParser::parseRoot(Context &context)
+    {
+        JsonArena *arena = context.arena;
+        JsonToken &current = context.current;
+        nextToken(context);
 
         // Check if the the JSON text is empty.
         if (current.type == JsonTokenType::EndOfFile)
-            return root;
+            return nullptr;
 
-        // Create the root node.
-        switch (current.type)
+        // Nodes allocated with new are owned by this pointer until we know the JSON text is valid.
+        // Nodes living in the arena are released together with the arena.
+        JsonNodePtr owner;
+        JsonNode *root = nullptr;
+
+        try
         {
-        case JsonTokenType::BeginArray:
-            root = std::unique_ptr<JsonArray>(new JsonArray());
-            parseArray(input, *root);
+            // Create the root node.
+            switch (current.type)
+            {
+            case JsonTokenType::BeginArray:
+            {
+                JsonArray *array = JsonArena::create<JsonArray>(arena, nullptr, arena);
+                root = array;
+                if (!arena)
+                    owner.reset(root);
+                parseContainers(context, *array);
+            }
             break;
-        case JsonTokenType::BeginObject:
-            root = std::unique_ptr<JsonObject>(new JsonObject());
-            parseObject(input, *root);
-            break;
-        case JsonTokenType::False:
-            root = std::unique_ptr<JsonBool>(new JsonBool(false));
-            break;
-        case JsonTokenType::True:
-            root = std::unique_ptr<JsonBool>(new JsonBool(true));
-            break;
-        case JsonTokenType::Null:
-            root = std::unique_ptr<JsonNull>(new JsonNull());
+            case JsonTokenType::BeginObject:
+            {
+                JsonObject *object = JsonArena::create<JsonObject>(arena, nullptr, arena);
+                root = object;
+                if (!arena)
+                    owner.reset(root);
+                parseContainers(context, *object);
+            }
             break;
-        case JsonTokenType::Number:
-            root = std::unique_ptr<JsonNumber>(new JsonNumber(std::stod(current.value)));
-            break;
-        case JsonTokenType::String:
-            root = std::unique_ptr<JsonString>(new JsonString(std::move(current.value)));
-            break;
-        default:
-            throw std::runtime_error("Illegal root value");
+            case JsonTokenType::False:
+                root = JsonArena::create<JsonBool>(arena, nullptr, false);
+                break;
+            case JsonTokenType::True:
+                root = JsonArena::create<JsonBool>(arena, nullptr, true);
+                break;
+            case JsonTokenType::Null:
+                root = JsonArena::create<JsonNull>(arena, nullptr);
+                break;
+            case JsonTokenType::Number:
+                root = JsonArena::create<JsonNumber>(arena, nullptr, arena, current.text, context.storage);
+                break;
+            case JsonTokenType::String:
+                root = JsonArena::create<JsonString>(arena, nullptr, arena, current.text, context.storage);
+                break;
+            default:
+                throw std::runtime_error("Illegal root value");
+            }
+        }
+        catch (...)
+        {
+            // The children that no container has taken yet are not owned by the root.
+            if (!arena)
+            {
+                for (JsonNode *child : context.children)
+                    JsonNodeDeleter()(child);
+            }
+            throw;
         }
 
-        current = JsonLexer::nextToken(input);
+        if (!arena && !owner)
+            owner.reset(root);
+
+        nextToken(context);
 
         // Make sure there is only one root node.
         if (current.type != JsonTokenType::EndOfFile)
             throw std::runtime_error("Valid json text can only have one root value");
 
+        owner.release();
         return root;
     }
 
-    void JsonParser::parseArray(std::istream &input, JsonArray &parent)
+    template <typename NodeType, typename... Args>
+    NodeType &JsonParser::createChild(Context &context, Args &&... args)
+    {
+        // The slot is added first so that the node cannot leak if the stack fails to grow.
+        context.children.push_back(nullptr);
+        NodeType *node = JsonArena::create<NodeType>(context.arena, std::forward<Args>(args)...);
+        context.children.back() = node;
+        return *node;
+    }
+
+    void JsonParser::finishArray(Context &context, JsonArray &parent, size_t first)
+    {
+        std::vector<JsonNode *> &children = context.children;
+        parent.reserve(parent.getChildCount() + children.size() - first);
+
+        // There is room for every child, so this can not fail.
+        for (size_t i = first; i < children.size(); i++)
+            parent.appendChild(children[i]);
+        children.resize(first);
+    }
+
+    void JsonParser::finishObject(Context &context, JsonObject &parent, size_t first, size_t firstName)
     {
-        JsonToken current = JsonLexer::nextToken(input);
+        std::vector<JsonNode *> &children = context.children;
+        parent.reserve(parent.getChildCount() + children.size() - first);
+
+        for (size_t i = first; i < children.size(); i++)
+        {
+            size_t name = firstName + i - first;
+            parent.insertChild(context.input ? JsonStringView(context.names[name]) : context.borrowedNames[name], children[i]);
+            children[i] = nullptr;
+        }
+        children.resize(first);
+        context.nameCount = firstName;
+    }
+
+    void JsonParser::parseContainers(Context &context, JsonNode &root)
+    {
+        JsonToken &current = context.current;
+        std::vector<Frame> &frames = context.frames;
+        bool expectValue = openContainer(context, root);
+
+        // The containers being parsed are kept on the frames stack instead of the call stack,
+        // so a deeply nested document only needs memory proportional to its depth.
+        for (;;)
+        {
+            if (expectValue)
+            {
+                JsonNode *container = parseValue(context, *frames.back().container);
+                if (container)
+                {
+                    expectValue = openContainer(context, *container);
+                    continue;
+                }
+                nextToken(context);
+            }
+
+            // Parse the next comma separated child of the innermost container.
+            if (current.type == JsonTokenType::ValueSeparator)
+            {
+                nextToken(context);
+                if (frames.back().container->getType() == JsonNodeType::Object)
+                    parseMemberName(context);
+                expectValue = true;
+                continue;
+            }
+
+            closeContainer(context);
+            if (frames.empty())
+                return;
+
+            // The closed container was a value of the container below it.
+            nextToken(context);
+            expectValue = false;
+        }
+    }
+
+    bool JsonParser::openContainer(Context &context, JsonNode &container)
+    {
+        JsonToken &current = context.current;
+        context.frames.push_back({&container, context.children.size(), context.nameCount});
+        nextToken(context);
+
+        if (container.getType() == JsonNodeType::Object)
+        {
+            if (current.type == JsonTokenType::EndObject)
+                return false;
+            parseMemberName(context);
+            return true;
+        }
 
         // Check if the JsonArray is empty.
         if (current.type == JsonTokenType::EndArray)
-            return;
+            return false;
 
-        // If not empty then parse the first child.
-        parseArrayValue(input, current, parent);
-        current = JsonLexer::nextToken(input);
+        // The leading numbers are collected first, so that an array of numbers can be stored packed.
+        // They are only converted for a packed array, otherwise they become nodes that keep their text.
+        // A packed array does not keep the texts, so it is only used if every number is written back the way it was read.
+        JsonArray &array = static_cast<JsonArray &>(container);
+        std::vector<JsonStringView> &texts = context.numberTexts;
+        std::string &scratch = context.numberScratch;
+        texts.clear();
+        scratch.clear();
+        bool separated = false;
+
+        while (current.type == JsonTokenType::Number)
+        {
+            texts.push_back(current.text);
+            if (context.input)
+                scratch += current.value;
+            nextToken(context);
+            separated = current.type == JsonTokenType::ValueSeparator;
+            if (!separated)
+                break;
+            nextToken(context);
+        }
+
+        // The token of a stream is reused, so the texts refer to the copies in the scratch string.
+        if (context.input)
+        {
+            const char *position = scratch.data();
+            for (JsonStringView &text : texts)
+            {
+                text = JsonStringView(position, text.size());
+                position += text.size();
+            }
+        }
 
-        // Parse all comma separated childs.
-        while (current.type == JsonTokenType::ValueSeparator)
+        if (!texts.empty() && !separated && current.type == JsonTokenType::EndArray && texts.size() >= minimumPackedSize)
         {
-            current = JsonLexer::nextToken(input);
-            parseArrayValue(input, current, parent);
-            current = JsonLexer::nextToken(input);
+            std::vector<double> &numbers = context.numbers;
+            numbers.clear();
+            for (JsonStringView text : texts)
+            {
+                double value = JsonNumber::parse(text);
+                if (!JsonNumber::formatsAs(value, text))
+                    break;
+                numbers.push_back(value);
+            }
+
+            if (numbers.size() == texts.size())
+            {
+                array.addNumbers(JsonSpan<const double>(numbers.data(), numbers.size()));
+                return false;
+            }
         }
 
-        // Make sure the JsonArray ends with ']'.
-        if (current.type != JsonTokenType::EndArray)
-            throw std::runtime_error("Could not read the end of the array");
+        for (JsonStringView text : texts)
+            createChild<JsonNumber>(context, &array, context.arena, text, context.storage);
+
+        // If the numbers were followed by a comma the current token is the next child.
+        return texts.empty() || separated;
     }
 
-    void JsonParser::parseArrayValue(std::istream &input, JsonToken &current, JsonArray &parent)
+    JsonNode *JsonParser::parseValue(Context &context, JsonNode &parent)
     {
-        // Identify the child and add it to the JsonArray.
+        JsonToken &current = context.current;
+        JsonArena *arena = context.arena;
+
+        // Identify the child and add it to the pending children of the container.
         switch (current.type)
         {
         case JsonTokenType::BeginArray:
-            parseArray(input, parent.addArray());
-            break;
+            return &createChild<JsonArray>(context, &parent, arena);
         case JsonTokenType::BeginObject:
-            parseObject(input, parent.addObject());
-            break;
+            return &createChild<JsonObject>(context, &parent, arena);
         case JsonTokenType::False:
-            parent.addBool(false);
+            createChild<JsonBool>(context, &parent, false);
             break;
         case JsonTokenType::True:
-            parent.addBool(true);
+            createChild<JsonBool>(context, &parent, true);
             break;
         case JsonTokenType::Null:
-            parent.addNull();
+            createChild<JsonNull>(context, &parent);
             break;
         case JsonTokenType::Number:
-            parent.addNumber(std::stod(current.value));
+            createChild<JsonNumber>(context, &parent, arena, current.text, context.storage);
             break;
         case JsonTokenType::String:
-            parent.addString(std::move(current.value));
+            createChild<JsonString>(context, &parent, arena, current.text, context.storage);
             break;
         default:
             throw std::runtime_error("Could not read the next value");
         }
+        return nullptr;
     }
 
-    void JsonParser::parseObject(std::istream &input, JsonObject &parent)
+    void JsonParser::parseMemberName(Context &context)
     {
-        JsonToken current = JsonLexer::nextToken(input);
-
-        if (current.type == JsonTokenType::EndObject)
-            return;
-
-        parseObjectMember(input, current, parent);
-        current = JsonLexer::nextToken(input);
+        JsonToken &current = context.current;
 
-        while (current.type == JsonTokenType::ValueSeparator)
-        {
-            current = JsonLexer::nextToken(input);
-            parseObjectMember(input, current, parent);
-            current = JsonLexer::nextToken(input);
-        }
-
-        if (current.type != JsonTokenType::EndObject)
-            throw std::runtime_error("Could not read the end of the object");
-    }
-
-    void JsonParser::parseObjectMember(std::istream &input, JsonToken &current, JsonObject &parent)
-    {
         if (current.type != JsonTokenType::String)
             throw std::runtime_error("Every object member must start with a string");
 
-        // This is the name for the new child.
-        std::string name = std::move(current.value);
+        // This is the name for the new child. We swap the buffers instead of copying,
+        // both buffers keep their capacity for the following members. A name in a buffer stays where it is.
+        if (!context.input)
+        {
+            if (context.nameCount == context.borrowedNames.size())
+                context.borrowedNames.emplace_back();
+            context.borrowedNames[context.nameCount++] = current.text;
+        }
+        else
+        {
+            if (context.nameCount == context.names.size())
+                context.names.emplace_back();
+            context.names[context.nameCount++].swap(current.value);
+        }
 
-        current = JsonLexer::nextToken(input);
+        nextToken(context);
 
         if (current.type != JsonTokenType::NameSeparator)
             throw std::runtime_error("After the string there must be a name separator");
 
-        current = JsonLexer::nextToken(input);
+        nextToken(context);
+    }
 
-        // Identify the child and add it to the JsonObject.
-        switch (current.type)
+    void JsonParser::closeContainer(Context &context)
+    {
+        Frame frame = context.frames.back();
+        bool pending = frame.first < context.children.size();
+
+        if (frame.container->getType() == JsonNodeType::Array)
         {
-        case JsonTokenType::BeginArray:
-            parseArray(input, parent.setArray(std::move(name)));
-            break;
-        case JsonTokenType::BeginObject:
-            parseObject(input, parent.setObject(std::move(name)));
-            break;
-        case JsonTokenType::False:
-            parent.setBool(std::move(name), false);
-            break;
-        case JsonTokenType::True:
-            parent.setBool(std::move(name), true);
-            break;
-        case JsonTokenType::Null:
-            parent.setNull(std::move(name));
-            break;
-        case JsonTokenType::Number:
-            parent.setNumber(std::move(name), std::stod(current.value));
-            break;
-        case JsonTokenType::String:
-            parent.setString(std::move(name), std::move(current.value));
-            break;
-        default:
-            throw std::runtime_error("Could not read the next value");
+            // Make sure the JsonArray ends with ']'.
+            if (context.current.type != JsonTokenType::EndArray)
+                throw std::runtime_error("Could not read the end of the array");
+            if (pending)
+                finishArray(context, static_cast<JsonArray &>(*frame.container), frame.first);
+        }
+        else
+        {
+            if (context.current.type != JsonTokenType::EndObject)
+                throw std::runtime_error("Could not read the end of the object");
+            if (pending)
+                finishObject(context, static_cast<JsonObject &>(*frame.container), frame.first, frame.firstName);
         }
+        context.frames.pop_back();
     }
-} // namespace json
\ No newline at end of file
+} // namespace json
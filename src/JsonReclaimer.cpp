@@ -0,0 +1,116 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "JsonReclaimer.hpp"
+
+namespace json
+{
+    namespace
+    {
+        // The number of nodes freed before the background thread gives other threads a chance to run.
+        const size_t nodesPerStep = 4096;
+    } // namespace
+
+    JsonReclaimer::JsonReclaimer(size_t maximumPending)
+        : maximumPending(maximumPending > 0 ? maximumPending : 1), active(0), stopping(false)
+    {
+        // The thread is started last, once every member it uses has been initialized.
+        thread = std::thread(&JsonReclaimer::run, this);
+    }
+
+    JsonReclaimer::~JsonReclaimer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        available.notify_one();
+        thread.join();
+    }
+
+    void JsonReclaimer::reclaim(JsonDocument &&document)
+    {
+        Garbage garbage{nullptr, std::move(document.arena)};
+
+        // Releasing the reference is cheap, the nodes are only freed if this was the last one.
+        // Nodes living in the arena are freed together with the arena.
+        JsonNode *root = document.root;
+        document.root = nullptr;
+        if (root && !document.rootInArena && JsonNode::release(root))
+        {
+            JsonNode::setParent(root, nullptr);
+            garbage.nodes = root;
+        }
+        document.rootInArena = false;
+
+        if (!garbage.nodes && !garbage.arena)
+            return;
+
+        std::unique_lock<std::mutex> lock(mutex);
+        freed.wait(lock, [this] { return queue.size() + active < maximumPending; });
+        queue.push_back(std::move(garbage));
+        lock.unlock();
+        available.notify_one();
+    }
+
+    void JsonReclaimer::drain()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        freed.wait(lock, [this] { return queue.empty() && active == 0; });
+    }
+
+    size_t JsonReclaimer::getPendingCount() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return queue.size() + active;
+    }
+
+    void JsonReclaimer::run()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;)
+        {
+            // The pending documents are still freed when the reclaimer is stopped.
+            available.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (queue.empty())
+                return;
+
+            Garbage garbage = std::move(queue.front());
+            queue.pop_front();
+            active++;
+            lock.unlock();
+
+            while (garbage.nodes)
+            {
+                garbage.nodes = JsonNode::destroyPending(garbage.nodes, nodesPerStep);
+                std::this_thread::yield();
+            }
+            garbage.arena.reset();
+
+            lock.lock();
+            active--;
+            freed.notify_all();
+        }
+    }
+} // namespace json
\ No newline at end of file
@@ -0,0 +1,217 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "JsonSerializer.hpp"
+#include "JsonArray.hpp"
+#include "JsonObject.hpp"
+#include "JsonNumber.hpp"
+#include "JsonString.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+namespace json
+{
+    JsonSerializer::JsonSerializer(JsonOutputBuffer &output, const JsonFormat &format) : output(output), format(format), baseDepth(0)
+    {
+    }
+
+    void JsonSerializer::write(const JsonNode &node)
+    {
+        write(node, 0);
+    }
+
+    void JsonSerializer::write(const JsonNode &node, size_t depth)
+    {
+        levels.clear();
+        baseDepth = depth;
+        node.accept(*this);
+    }
+
+    void JsonSerializer::writeChildren(const JsonNode &container, size_t first, size_t last, size_t depth)
+    {
+        levels.clear();
+        baseDepth = depth;
+        if (container.getType() == JsonNodeType::Array)
+        {
+            const JsonArray &array = static_cast<const JsonArray &>(container);
+            levels.push_back({array.getChildCount() - first, true, false});
+            if (array.isPacked())
+            {
+                JsonSpan<const double> numbers = array.getNumbers();
+                for (size_t i = first; i < last; i++)
+                    visitNumber(numbers[i]);
+            }
+            else
+            {
+                for (size_t i = first; i < last; i++)
+                    array.getChild(i).accept(*this);
+            }
+        }
+        else
+        {
+            const JsonObject &object = static_cast<const JsonObject &>(container);
+            levels.push_back({object.getChildCount() - first, false, false});
+            for (size_t i = first; i < last; i++)
+            {
+                visitName(object.getNameAt(i));
+                object.getChildAt(i).accept(*this);
+            }
+        }
+        levels.clear();
+    }
+
+    bool JsonSerializer::beginArray(const JsonArray &array)
+    {
+        beginValue();
+        output.write('[');
+        open(array.getChildCount(), true);
+        return true;
+    }
+
+    void JsonSerializer::endArray(const JsonArray &)
+    {
+        close(']');
+    }
+
+    bool JsonSerializer::beginObject(const JsonObject &object)
+    {
+        beginValue();
+        output.write('{');
+        open(object.getChildCount(), false);
+        return true;
+    }
+
+    void JsonSerializer::endObject(const JsonObject &)
+    {
+        close('}');
+    }
+
+    void JsonSerializer::visitName(JsonStringView name)
+    {
+        indent(levels.size());
+        output.write('\"');
+        JsonString::escape(name, output, format.ensureAscii);
+        if (format.pretty)
+            output.write("\": ", 3);
+        else
+            output.write("\":", 2);
+    }
+
+    void JsonSerializer::visitBool(bool value)
+    {
+        beginValue();
+        if (value)
+            output.write("true", 4);
+        else
+            output.write("false", 5);
+        endValue();
+    }
+
+    void JsonSerializer::visitNull()
+    {
+        beginValue();
+        output.write("null", 4);
+        endValue();
+    }
+
+    void JsonSerializer::visitNumber(double value)
+    {
+        if (!std::isfinite(value))
+            throw std::runtime_error("Infinity and NaN cannot be written as JSON");
+        beginValue();
+        char *buffer = output.reserve(JsonNumber::maximumFormatSize);
+        if (format.decimals >= 0 && value != std::trunc(value))
+            output.commit(JsonNumber::format(value, format.decimals, buffer));
+        else
+            output.commit(JsonNumber::format(value, buffer));
+        endValue();
+    }
+
+    // A parsed number that has not been modified is written exactly as it was read,
+    // unless it needs to be rounded to a number of decimals. A number too large for a double keeps its text.
+    void JsonSerializer::visitNumberNode(const JsonNumber &number)
+    {
+        if (!number.hasText() || (format.decimals >= 0 && !number.isInteger() && std::isfinite(number.data())))
+        {
+            visitNumber(number.data());
+            return;
+        }
+        beginValue();
+        output.write(number.getText());
+        endValue();
+    }
+
+    void JsonSerializer::visitString(const JsonString &value)
+    {
+        beginValue();
+        output.write('\"');
+        JsonString::escape(value.view(), output, format.ensureAscii);
+        output.write('\"');
+        endValue();
+    }
+
+    void JsonSerializer::beginValue()
+    {
+        if (!levels.empty() && levels.back().array)
+            indent(levels.size());
+    }
+
+    void JsonSerializer::endValue()
+    {
+        if (levels.empty())
+            return;
+        if (--levels.back().remaining > 0) // If last child don't print ','.
+            output.write(',');
+        if (format.pretty)
+            output.write('\n');
+    }
+
+    void JsonSerializer::open(size_t count, bool array)
+    {
+        levels.push_back({count, array, count == 0});
+        if (count > 0 && format.pretty)
+            output.write('\n');
+    }
+
+    void JsonSerializer::close(char end)
+    {
+        bool empty = levels.back().empty;
+        levels.pop_back();
+        if (!empty)
+            indent(levels.size());
+        output.write(end);
+        endValue();
+    }
+
+    void JsonSerializer::indent(size_t depth)
+    {
+        size_t width = (baseDepth + depth) * format.tabSize;
+        if (!format.pretty || width == 0)
+            return;
+        if (spaces.size() < width)
+            spaces.resize(width, ' ');
+        output.write(spaces.data(), width);
+    }
+} // namespace json
\ No newline at end of file
@@ -0,0 +1,62 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "JsonShape.hpp"
+
+namespace json
+{
+    JsonShape::JsonShape(const JsonStringView *names, size_t count) noexcept : names(names), count(count)
+    {
+    }
+
+    size_t JsonShape::size() const noexcept
+    {
+        return count;
+    }
+
+    JsonStringView JsonShape::getName(size_t slot) const noexcept
+    {
+        return names[slot];
+    }
+
+    size_t JsonShape::find(JsonStringView name) const noexcept
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            if (names[i] == name)
+                return i;
+        }
+        return count;
+    }
+
+    size_t JsonShape::findInterned(JsonStringView name) const noexcept
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            if (names[i].data() == name.data())
+                return i;
+        }
+        return count;
+    }
+} // namespace json
\ No newline at end of file
@@ -10,114 +10,370 @@ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
 copies of the Software, and to permit persons to whom the Software is
 furnished to do so, subject to the following conditions:
 
-The above copyright notice and this permission notice shall be included in all
-copies or substantial portions of the Software.
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
 
 THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
 IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
 FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
 AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
 LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
-OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
-SOFTWARE.
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
 */
 
 #include "JsonString.hpp"
+#include "JsonArena.hpp"
+#include "JsonStringPool.hpp"
+#include "JsonOutputBuffer.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#endif
 
 namespace json
 {
-    JsonString::JsonString(const std::string &value) : JsonNode(), value(value)
+    namespace
+    {
+        void deleteMaterialized(void *value)
+        {
+            delete static_cast<std::string *>(value);
+        }
+
+        const char hexDigits[] = "0123456789abcdef";
+
+        // Returns the lowest bit set in a mask that is not zero.
+        unsigned lowestBit(unsigned mask) noexcept
+        {
+#if defined(__GNUC__)
+            return static_cast<unsigned>(__builtin_ctz(mask));
+#else
+            unsigned index = 0;
+            while (!(mask & 1))
+            {
+                mask >>= 1;
+                index++;
+            }
+            return index;
+#endif
+        }
+
+        bool needsEscape(unsigned char c, bool ensureAscii) noexcept
+        {
+            return c < 0x20 || c == '\"' || c == '\\' || (ensureAscii && c >= 0x80);
+        }
+
+        // Returns the first character that needs an escape sequence, or last if there is none.
+        const char *findEscape(const char *first, const char *last, bool ensureAscii) noexcept
+        {
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+            // A control character is one that is not changed by taking the minimum with 0x1F.
+            const __m128i quote = _mm_set1_epi8('\"');
+            const __m128i backslash = _mm_set1_epi8('\\');
+            const __m128i control = _mm_set1_epi8(0x1F);
+            while (last - first >= 16)
+            {
+                __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+                __m128i found = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chars, quote), _mm_cmpeq_epi8(chars, backslash)),
+                                             _mm_cmpeq_epi8(_mm_min_epu8(chars, control), chars));
+                unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(found));
+                if (ensureAscii)
+                    mask |= static_cast<unsigned>(_mm_movemask_epi8(chars));
+                if (mask)
+                    return first + lowestBit(mask);
+                first += 16;
+            }
+#else
+            // Without SSE2 eight characters are tested at a time in a 64-bit word. A byte of the word is zero
+            // when the character is the one searched for, and subtracting one from a zero byte sets its high bit.
+            const uint64_t ones = 0x0101010101010101ULL;
+            const uint64_t highBits = 0x8080808080808080ULL;
+            while (last - first >= 8)
+            {
+                uint64_t chars;
+                std::memcpy(&chars, first, sizeof(chars));
+                uint64_t quotes = chars ^ (ones * '\"');
+                uint64_t backslashes = chars ^ (ones * '\\');
+                uint64_t found = ((quotes - ones) & ~quotes) | ((backslashes - ones) & ~backslashes) | ((chars - ones * 0x20) & ~chars);
+                if (ensureAscii)
+                    found |= chars;
+                if (found & highBits)
+                    break;
+                first += 8;
+            }
+#endif
+            while (first != last && !needsEscape(static_cast<unsigned char>(*first), ensureAscii))
+                first++;
+            return first;
+        }
+
+        char *writeUnicodeEscape(unsigned code, char *output) noexcept
+        {
+            output[0] = '\\';
+            output[1] = 'u';
+            output[2] = hexDigits[(code >> 12) & 0xF];
+            output[3] = hexDigits[(code >> 8) & 0xF];
+            output[4] = hexDigits[(code >> 4) & 0xF];
+            output[5] = hexDigits[code & 0xF];
+            return output + 6;
+        }
+
+        // Decodes the UTF-8 sequence starting at first and returns its length. A surrogate on its own, which the parser
+        // stores for an escape such as "\ud800" without its pair, is decoded like any other character.
+        // A sequence that is not valid UTF-8 is decoded as U+FFFD, and its length covers the lead byte and the
+        // continuation bytes after it, so a broken sequence is replaced once instead of once per byte.
+        size_t decodeUtf8(const unsigned char *first, const unsigned char *last, unsigned &code) noexcept
+        {
+            unsigned char lead = first[0];
+            size_t length;
+            unsigned minimum;
+            if (lead >= 0xC0 && lead < 0xE0)
+            {
+                length = 2;
+                code = lead & 0x1F;
+                minimum = 0x80;
+            }
+            else if (lead >= 0xE0 && lead < 0xF0)
+            {
+                length = 3;
+                code = lead & 0x0F;
+                minimum = 0x800;
+            }
+            else if (lead >= 0xF0 && lead < 0xF5)
+            {
+                length = 4;
+                code = lead & 0x07;
+                minimum = 0x10000;
+            }
+            else
+            {
+                code = 0xFFFD;
+                return 1;
+            }
+
+            size_t count = 1;
+            while (count < length && first + count != last && (first[count] & 0xC0) == 0x80)
+                code = (code << 6) | (first[count++] & 0x3F);
+
+            // Truncated and overlong sequences and code points beyond U+10FFFF are not valid.
+            if (count < length || code < minimum || code > 0x10FFFF)
+                code = 0xFFFD;
+            return count;
+        }
+
+        // Writes the escape sequence of the character at first and returns the character after it.
+        // The output must have room for 12 characters.
+        const char *escapeCharacter(const char *first, const char *last, char *&output) noexcept
+        {
+            unsigned char c = static_cast<unsigned char>(*first);
+            char shortForm = 0;
+            switch (c)
+            {
+            case '\"':
+                shortForm = '\"';
+                break;
+            case '\\':
+                shortForm = '\\';
+                break;
+            case '\b':
+                shortForm = 'b';
+                break;
+            case '\f':
+                shortForm = 'f';
+                break;
+            case '\n':
+                shortForm = 'n';
+                break;
+            case '\r':
+                shortForm = 'r';
+                break;
+            case '\t':
+                shortForm = 't';
+                break;
+            }
+
+            if (shortForm)
+            {
+                *output++ = '\\';
+                *output++ = shortForm;
+                return first + 1;
+            }
+            if (c < 0x80)
+            {
+                output = writeUnicodeEscape(c, output);
+                return first + 1;
+            }
+
+            // Only reached when the output must be ASCII.
+            unsigned code;
+            size_t length = decodeUtf8(reinterpret_cast<const unsigned char *>(first), reinterpret_cast<const unsigned char *>(last), code);
+            if (code >= 0x10000)
+            {
+                code -= 0x10000;
+                output = writeUnicodeEscape(0xD800 + (code >> 10), output);
+                output = writeUnicodeEscape(0xDC00 + (code & 0x3FF), output);
+            }
+            else
+                output = writeUnicodeEscape(code, output);
+            return first + length;
+        }
+    } // namespace
+
+    JsonString::JsonString(const std::string &value) : JsonNode(JsonNodeType::String), arena(nullptr), materialized(new std::string(value))
     {
     }
 
-    JsonString::JsonString(std::string &&value) : JsonNode(), value(std::move(value))
+    JsonString::JsonString(std::string &&value) : JsonNode(JsonNodeType::String), arena(nullptr), materialized(new std::string(std::move(value)))
     {
     }
 
-    JsonString::JsonString(JsonNode *parent, const std::string &value) : JsonNode(parent), value(value)
+    JsonString::JsonString(JsonNode *parent, const std::string &value) : JsonNode(parent, JsonNodeType::String), arena(nullptr), materialized(new std::string(value))
     {
     }
 
-    JsonString::JsonString(JsonNode *parent, std::string &&value) : JsonNode(parent), value(std::move(value))
+    JsonString::JsonString(JsonNode *parent, std::string &&value) : JsonNode(parent, JsonNodeType::String), arena(nullptr), materialized(new std::string(std::move(value)))
     {
     }
 
-    JsonNodeType JsonString::getType() const noexcept
+    JsonString::JsonString(JsonNode *parent, JsonArena *arena, JsonStringView value) : JsonString(parent, arena, value, JsonStringStorage::Copy)
     {
-        return JsonNodeType::String;
     }
 
-    JsonString &JsonString::toString()
+    JsonString::JsonString(JsonNode *parent, JsonArena *arena, JsonStringView value, JsonStringStorage storage)
+        : JsonNode(parent, JsonNodeType::String), arena(arena), materialized(nullptr)
+    {
+        JsonStringPool *pool = arena ? arena->getStringPool() : nullptr;
+
+        // Borrowed characters are used where they are. Otherwise short values such as "OK" or "error",
+        // which are often repeated, may be stored once in the pool.
+        if (arena && storage == JsonStringStorage::Borrow)
+            chars = value;
+        else if (pool && pool->shouldInternValue(value))
+            chars = pool->intern(value);
+        else if (arena)
+            chars = arena->copyString(value);
+        else
+            materialized = new std::string(value.data(), value.size());
+    }
+
+    JsonString::~JsonString()
     {
+        // A std::string created for an arena-backed value is released by the arena.
+        if (!arena)
+            delete materialized.load();
+    }
+
+    JsonString &JsonString::operator=(const std::string &value)
+    {
+        checkWritable();
+        materialize() = value;
         return *this;
     }
 
-    const JsonString &JsonString::toString() const
+    JsonString &JsonString::operator=(std::string &&value)
     {
+        checkWritable();
+        materialize() = std::move(value);
         return *this;
     }
 
-    std::string &JsonString::data() noexcept
+    JsonStringView JsonString::view() const noexcept
     {
-        return value;
+        std::string *value = materialized.load(std::memory_order_acquire);
+        return value ? JsonStringView(*value) : chars;
     }
 
-    const std::string &JsonString::data() const noexcept
+    std::string &JsonString::data()
     {
-        return value;
+        checkWritable();
+        return materialize();
+    }
+
+    const std::string &JsonString::data() const
+    {
+        return materialize();
     }
 
     JsonString::operator std::string &()
     {
-        return value;
+        return data();
     }
 
     JsonString::operator const std::string &() const
     {
-        return value;
+        return materialize();
     }
 
     JsonString::operator const char *() const
     {
-        return value.c_str();
+        return materialize().c_str();
     }
 
     std::string JsonString::escaped() const noexcept
     {
         std::string result;
+        JsonOutputBuffer output(result);
+        escape(view(), output);
+        output.flush();
+        return result;
+    }
 
-        // Go through each character and check if one of them need to be escaped.
-        for (size_t i = 0; i < value.length(); i++)
+    void JsonString::escape(JsonStringView value, JsonOutputBuffer &output, bool ensureAscii)
+    {
+        const char *position = value.data();
+        const char *last = position + value.size();
+        while (position != last)
         {
-            switch (value[i])
-            {
-            case '\"':
-                result += "\\\"";
-                break;
-            case '\\':
-                result += "\\\\";
+            const char *next = findEscape(position, last, ensureAscii);
+            output.write(position, static_cast<size_t>(next - position));
+            if (next == last)
                 break;
-            case '\b':
-                result += "\\b";
-                break;
-            case '\f':
-                result += "\\f";
-                break;
-            case '\n':
-                result += "\\n";
-                break;
-            case '\r':
-                result += "\\r";
-                break;
-            case '\t':
-                result += "\\t";
-                break;
-            default:
-                result += value[i];
-                break;
-            }
+
+            char *buffer = output.reserve(12);
+            position = escapeCharacter(next, last, buffer);
+            output.commit(buffer);
         }
+    }
 
-        return result;
+    void JsonString::addMemoryUsage(JsonMemoryUsage &usage) const noexcept
+    {
+        std::string *value = materialized.load(std::memory_order_acquire);
+        if (value)
+        {
+            usage.valueStrings += sizeof(std::string) + value->size();
+            usage.slack += value->capacity() - value->size();
+        }
+
+        // The characters stay in the arena after a std::string has been created, unless the pool holds them.
+        JsonStringPool *pool = arena ? arena->getStringPool() : nullptr;
+        if (arena && !(pool && pool->shouldInternValue(chars)))
+            usage.valueStrings += chars.size();
+    }
+
+    std::string &JsonString::materialize() const
+    {
+        std::string *value = materialized.load(std::memory_order_acquire);
+        if (value)
+            return *value;
+
+        // Several threads may get here at the same time, only one of them gets to install its copy.
+        std::string *created = new std::string(chars.data(), chars.size());
+        if (materialized.compare_exchange_strong(value, created, std::memory_order_acq_rel))
+        {
+            arena->addCleanup(deleteMaterialized, created);
+
+            // Only the size at this point is counted, the arena does not see the string grow later.
+            JsonMemoryUsage usage;
+            usage.valueStrings = sizeof(std::string) + created->size();
+            usage.slack = created->capacity() - created->size();
+            arena->account(usage);
+            return *created;
+        }
+
+        delete created;
+        return *value;
     }
 } // namespace json
\ No newline at end of file
@@ -0,0 +1,216 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "JsonStringPool.hpp"
+
+#include <cstring>
+#include <functional>
+#include <new>
+
+namespace json
+{
+    namespace
+    {
+        const size_t initialCapacity = 64;
+
+        // The first chunk of the storage, the same size as the first chunk of a JsonArena.
+        const size_t initialStorageSize = 1024;
+
+        // Larger objects are better served by a hash table of their own.
+        const size_t maximumShapeSize = 32;
+
+        // Limits the memory used by shapes when the names are not repeated, for example when the names are ids.
+        const size_t maximumShapeCount = 65536;
+    } // namespace
+
+    JsonStringPool::JsonStringPool(size_t maximumValueLength, JsonMemoryResource *resource)
+        : storage(initialStorageSize, resource), entries(allocateEntries(initialCapacity)), capacity(initialCapacity), count(0),
+          maximumValueLength(maximumValueLength), emptyShape(nullptr, 0),
+          transitions(0, TransitionHash(), std::equal_to<Transition>(), JsonResourceAllocator<std::pair<const Transition, const JsonShape *>>(resource))
+    {
+    }
+
+    JsonStringPool::~JsonStringPool()
+    {
+        storage.getMemoryResource()->deallocate(entries, capacity * sizeof(Entry), alignof(Entry));
+    }
+
+    std::shared_ptr<JsonStringPool> JsonStringPool::createShared(size_t maximumValueLength, JsonMemoryResource *resource)
+    {
+        return std::allocate_shared<JsonStringPool>(JsonResourceAllocator<JsonStringPool>(resource), maximumValueLength, resource);
+    }
+
+    JsonMemoryResource *JsonStringPool::getMemoryResource() const noexcept
+    {
+        return storage.getMemoryResource();
+    }
+
+    JsonStringView JsonStringPool::intern(JsonStringView str)
+    {
+        size_t hash = str.hash();
+        Entry *slot = findSlot(str, hash);
+
+        if (slot->chars)
+            return JsonStringView(slot->chars, slot->size);
+
+        // Keep the table at most half full so that the probe sequences stay short.
+        if ((count + 1) * 2 > capacity)
+        {
+            grow();
+            slot = findSlot(str, hash);
+        }
+
+        // The copy is null terminated, which also gives the empty string a unique address.
+        char *chars = static_cast<char *>(storage.allocate(str.size() + 1, 1));
+        std::memcpy(chars, str.data(), str.size());
+        chars[str.size()] = '\0';
+
+        *slot = {chars, str.size(), hash};
+        count++;
+        return JsonStringView(chars, str.size());
+    }
+
+    JsonStringView JsonStringPool::find(JsonStringView str) const noexcept
+    {
+        Entry *slot = findSlot(str, str.hash());
+        return JsonStringView(slot->chars, slot->size);
+    }
+
+    bool JsonStringPool::shouldInternValue(JsonStringView value) const noexcept
+    {
+        return maximumValueLength > 0 && value.size() <= maximumValueLength;
+    }
+
+    size_t JsonStringPool::getMaximumValueLength() const noexcept
+    {
+        return maximumValueLength;
+    }
+
+    const JsonShape *JsonStringPool::getEmptyShape() const noexcept
+    {
+        return &emptyShape;
+    }
+
+    const JsonShape *JsonStringPool::addName(const JsonShape *shape, JsonStringView name)
+    {
+        auto it = transitions.find({shape, name.data()});
+
+        if (it != transitions.end())
+            return it->second;
+
+        if (shape->size() >= maximumShapeSize || transitions.size() >= maximumShapeCount)
+            return nullptr;
+
+        // Every shape has its own copy of the names so that a lookup is a scan over one array.
+        size_t count = shape->size() + 1;
+        JsonStringView *names = static_cast<JsonStringView *>(storage.allocate(count * sizeof(JsonStringView), alignof(JsonStringView)));
+        for (size_t i = 0; i + 1 < count; i++)
+            new (names + i) JsonStringView(shape->getName(i));
+        new (names + count - 1) JsonStringView(name);
+
+        JsonShape *next = new (storage.allocate(sizeof(JsonShape), alignof(JsonShape))) JsonShape(names, count);
+        transitions.emplace(Transition{shape, name.data()}, next);
+        return next;
+    }
+
+    size_t JsonStringPool::getShapeCount() const noexcept
+    {
+        return transitions.size() + 1;
+    }
+
+    size_t JsonStringPool::getMaximumShapeSize() noexcept
+    {
+        return maximumShapeSize;
+    }
+
+    size_t JsonStringPool::size() const noexcept
+    {
+        return count;
+    }
+
+    size_t JsonStringPool::getBytesUsed() const noexcept
+    {
+        // Every transition is a map node holding the pair and a link to the next node.
+        size_t transitionBytes = transitions.size() * (sizeof(std::pair<const Transition, const JsonShape *>) + sizeof(void *)) +
+                                 transitions.bucket_count() * sizeof(void *);
+        return storage.getBytesUsed() + capacity * sizeof(Entry) + transitionBytes;
+    }
+
+    JsonMemoryUsage JsonStringPool::getMemoryUsage() const noexcept
+    {
+        JsonMemoryUsage usage;
+        usage.keyStrings = getBytesUsed();
+        usage.slack = storage.getBytesReserved() - storage.getBytesUsed();
+        return usage;
+    }
+
+    size_t JsonStringPool::TransitionHash::operator()(const Transition &transition) const noexcept
+    {
+        std::hash<const void *> hash;
+        return hash(transition.shape) * 31 + hash(transition.name);
+    }
+
+    JsonStringPool::Entry *JsonStringPool::findSlot(JsonStringView str, size_t hash) const noexcept
+    {
+        size_t mask = capacity - 1;
+        for (size_t i = hash & mask;; i = (i + 1) & mask)
+        {
+            Entry *slot = entries + i;
+            if (!slot->chars)
+                return slot;
+            if (slot->hash == hash && slot->size == str.size() && std::memcmp(slot->chars, str.data(), str.size()) == 0)
+                return slot;
+        }
+    }
+
+    void JsonStringPool::grow()
+    {
+        size_t newCapacity = capacity * 2;
+        Entry *newEntries = allocateEntries(newCapacity);
+        size_t mask = newCapacity - 1;
+
+        for (size_t i = 0; i < capacity; i++)
+        {
+            if (!entries[i].chars)
+                continue;
+
+            size_t j = entries[i].hash & mask;
+            while (newEntries[j].chars)
+                j = (j + 1) & mask;
+            newEntries[j] = entries[i];
+        }
+
+        storage.getMemoryResource()->deallocate(entries, capacity * sizeof(Entry), alignof(Entry));
+        entries = newEntries;
+        capacity = newCapacity;
+    }
+
+    JsonStringPool::Entry *JsonStringPool::allocateEntries(size_t capacity)
+    {
+        Entry *result = static_cast<Entry *>(storage.getMemoryResource()->allocate(capacity * sizeof(Entry), alignof(Entry)));
+        for (size_t i = 0; i < capacity; i++)
+            new (result + i) Entry();
+        return result;
+    }
+} // namespace json
\ No newline at end of file
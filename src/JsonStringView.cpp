@@ -0,0 +1,132 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "JsonStringView.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace json
+{
+    JsonStringView::JsonStringView() noexcept : chars(""), count(0)
+    {
+    }
+
+    JsonStringView::JsonStringView(const char *str) noexcept : chars(str), count(std::strlen(str))
+    {
+    }
+
+    JsonStringView::JsonStringView(const char *data, size_t size) noexcept : chars(data), count(size)
+    {
+    }
+
+    JsonStringView::JsonStringView(const std::string &str) noexcept : chars(str.data()), count(str.size())
+    {
+    }
+
+    const char *JsonStringView::data() const noexcept
+    {
+        return chars;
+    }
+
+    size_t JsonStringView::size() const noexcept
+    {
+        return count;
+    }
+
+    size_t JsonStringView::length() const noexcept
+    {
+        return count;
+    }
+
+    bool JsonStringView::empty() const noexcept
+    {
+        return count == 0;
+    }
+
+    char JsonStringView::operator[](size_t index) const noexcept
+    {
+        return chars[index];
+    }
+
+    const char *JsonStringView::begin() const noexcept
+    {
+        return chars;
+    }
+
+    const char *JsonStringView::end() const noexcept
+    {
+        return chars + count;
+    }
+
+    std::string JsonStringView::str() const
+    {
+        return std::string(chars, count);
+    }
+
+    JsonStringView::operator std::string() const
+    {
+        return std::string(chars, count);
+    }
+
+    size_t JsonStringView::hash() const noexcept
+    {
+        // 64-bit FNV-1a, it is simple and good enough for the short keys found in JSON text.
+        unsigned long long result = 14695981039346656037ULL;
+        for (size_t i = 0; i < count; i++)
+        {
+            result ^= static_cast<unsigned char>(chars[i]);
+            result *= 1099511628211ULL;
+        }
+        return static_cast<size_t>(result);
+    }
+
+    size_t JsonStringView::Hash::operator()(const JsonStringView &view) const noexcept
+    {
+        return view.hash();
+    }
+
+    bool operator==(const JsonStringView &lhs, const JsonStringView &rhs) noexcept
+    {
+        if (lhs.size() != rhs.size())
+            return false;
+        return lhs.data() == rhs.data() || std::memcmp(lhs.data(), rhs.data(), lhs.size()) == 0;
+    }
+
+    bool operator!=(const JsonStringView &lhs, const JsonStringView &rhs) noexcept
+    {
+        return !(lhs == rhs);
+    }
+
+    bool operator<(const JsonStringView &lhs, const JsonStringView &rhs) noexcept
+    {
+        int result = std::memcmp(lhs.data(), rhs.data(), std::min(lhs.size(), rhs.size()));
+        return result < 0 || (result == 0 && lhs.size() < rhs.size());
+    }
+
+    std::ostream &operator<<(std::ostream &output, const JsonStringView &view)
+    {
+        return output.write(view.data(), static_cast<std::streamsize>(view.size()));
+    }
+} // namespace json
\ No newline at end of file
@@ -0,0 +1,76 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "JsonVisitor.hpp"
+#include "JsonNumber.hpp"
+
+namespace json
+{
+    JsonVisitor::~JsonVisitor()
+    {
+    }
+
+    bool JsonVisitor::beginArray(const JsonArray &)
+    {
+        return true;
+    }
+
+    void JsonVisitor::endArray(const JsonArray &)
+    {
+    }
+
+    bool JsonVisitor::beginObject(const JsonObject &)
+    {
+        return true;
+    }
+
+    void JsonVisitor::endObject(const JsonObject &)
+    {
+    }
+
+    void JsonVisitor::visitName(JsonStringView)
+    {
+    }
+
+    void JsonVisitor::visitBool(bool)
+    {
+    }
+
+    void JsonVisitor::visitNull()
+    {
+    }
+
+    void JsonVisitor::visitNumber(double)
+    {
+    }
+
+    void JsonVisitor::visitNumberNode(const JsonNumber &number)
+    {
+        visitNumber(number.data());
+    }
+
+    void JsonVisitor::visitString(const JsonString &)
+    {
+    }
+} // namespace json
\ No newline at end of file
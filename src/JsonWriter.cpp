@@ -0,0 +1,254 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "JsonWriter.hpp"
+#include "JsonNumber.hpp"
+#include "JsonSerializer.hpp"
+#include "JsonString.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+namespace json
+{
+    JsonWriter::JsonWriter(std::ostream &output, const JsonFormat &format) : output(output), format(format), started(false)
+    {
+    }
+
+    JsonWriter::JsonWriter(std::string &output, const JsonFormat &format) : output(output), format(format), started(false)
+    {
+    }
+
+    JsonWriter::~JsonWriter()
+    {
+        frames.deallocate(nullptr);
+    }
+
+    JsonWriter &JsonWriter::beginObject()
+    {
+        beginValue();
+        frames.push_back({0, true, false}, nullptr);
+        output.write('{');
+        return *this;
+    }
+
+    JsonWriter &JsonWriter::endObject()
+    {
+        return end(true);
+    }
+
+    JsonWriter &JsonWriter::beginArray()
+    {
+        beginValue();
+        frames.push_back({0, false, false}, nullptr);
+        output.write('[');
+        return *this;
+    }
+
+    JsonWriter &JsonWriter::endArray()
+    {
+        return end(false);
+    }
+
+    JsonWriter &JsonWriter::key(JsonStringView name)
+    {
+        if (frames.empty() || !frames.back().object)
+            throw std::runtime_error("A key can only be written inside an object");
+        Frame &frame = frames.back();
+        if (frame.named)
+            throw std::runtime_error("The member already has a key, a value must follow it");
+
+        beginItem(frame);
+        frame.named = true;
+        output.write('\"');
+        JsonString::escape(name, output, format.ensureAscii);
+        if (format.pretty)
+            output.write("\": ", 3);
+        else
+            output.write("\":", 2);
+        return *this;
+    }
+
+    JsonWriter &JsonWriter::value(JsonStringView str)
+    {
+        beginValue();
+        output.write('\"');
+        JsonString::escape(str, output, format.ensureAscii);
+        output.write('\"');
+        endValue();
+        return *this;
+    }
+
+    JsonWriter &JsonWriter::value(const char *str)
+    {
+        if (!str)
+            return null();
+        return value(JsonStringView(str));
+    }
+
+    JsonWriter &JsonWriter::value(const std::string &str)
+    {
+        return value(JsonStringView(str));
+    }
+
+    JsonWriter &JsonWriter::value(double number)
+    {
+        if (!std::isfinite(number))
+            throw std::runtime_error("Infinity and NaN cannot be written as JSON");
+        beginValue();
+        char *buffer = output.reserve(JsonNumber::maximumFormatSize);
+        if (format.decimals >= 0 && number != std::trunc(number))
+            output.commit(JsonNumber::format(number, format.decimals, buffer));
+        else
+            output.commit(JsonNumber::format(number, buffer));
+        endValue();
+        return *this;
+    }
+
+    JsonWriter &JsonWriter::value(bool boolean)
+    {
+        beginValue();
+        if (boolean)
+            output.write("true", 4);
+        else
+            output.write("false", 5);
+        endValue();
+        return *this;
+    }
+
+    JsonWriter &JsonWriter::value(const JsonNode &node)
+    {
+        beginValue();
+        JsonSerializer serializer(output, format);
+        serializer.write(node, frames.size());
+        endValue();
+        return *this;
+    }
+
+    JsonWriter &JsonWriter::null()
+    {
+        beginValue();
+        output.write("null", 4);
+        endValue();
+        return *this;
+    }
+
+    void JsonWriter::flush()
+    {
+        output.flush();
+    }
+
+    bool JsonWriter::isComplete() const noexcept
+    {
+        return started && frames.empty();
+    }
+
+    size_t JsonWriter::getDepth() const noexcept
+    {
+        return frames.size();
+    }
+
+    void JsonWriter::beginValue()
+    {
+        if (frames.empty())
+        {
+            if (started)
+                throw std::runtime_error("The root value has already been written");
+            started = true;
+            return;
+        }
+
+        Frame &frame = frames.back();
+        if (frame.object)
+        {
+            if (!frame.named)
+                throw std::runtime_error("A value inside an object must follow a key");
+            return;
+        }
+        beginItem(frame);
+    }
+
+    void JsonWriter::endValue() noexcept
+    {
+        if (frames.empty())
+            return;
+        Frame &frame = frames.back();
+        frame.count++;
+        frame.named = false;
+    }
+
+    void JsonWriter::beginItem(Frame &frame)
+    {
+        // The separator is written in front of the next item, since the number of items is not known in advance.
+        if (frame.count > 0)
+            output.write(',');
+        newline(frames.size());
+    }
+
+    JsonWriter &JsonWriter::end(bool object)
+    {
+        if (frames.empty() || frames.back().object != object)
+            throw std::runtime_error(object ? "There is no object to end" : "There is no array to end");
+        if (frames.back().named)
+            throw std::runtime_error("The last key of the object has no value");
+
+        // An empty container is written as [] or {} without a newline in the middle.
+        bool empty = frames.back().count == 0;
+        frames.pop_back();
+        if (!empty)
+            newline(frames.size());
+        output.write(object ? '}' : ']');
+        endValue();
+        return *this;
+    }
+
+    JsonWriter &JsonWriter::writeInteger(int64_t number)
+    {
+        beginValue();
+        output.commit(JsonNumber::formatInteger(number, output.reserve(20)));
+        endValue();
+        return *this;
+    }
+
+    JsonWriter &JsonWriter::writeUnsigned(uint64_t number)
+    {
+        beginValue();
+        output.commit(JsonNumber::formatInteger(number, output.reserve(20)));
+        endValue();
+        return *this;
+    }
+
+    void JsonWriter::newline(size_t depth)
+    {
+        if (!format.pretty)
+            return;
+        size_t width = 1 + depth * format.tabSize;
+        if (spaces.size() < width)
+        {
+            spaces.resize(width, ' ');
+            spaces[0] = '\n';
+        }
+        output.write(spaces.data(), width);
+    }
+} // namespace json
\ No newline at end of file
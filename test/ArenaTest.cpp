@@ -0,0 +1,125 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "Json.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+using namespace json;
+
+// Counts the cleanups that have run, the counter is passed as the argument.
+static void countCleanup(void *counter)
+{
+    ++*static_cast<int *>(counter);
+}
+
+static void testArena()
+{
+    int cleanups = 0;
+    {
+        JsonArena arena(64);
+        if (arena.getChunkCount() != 0)
+            throw std::runtime_error("No chunk should be reserved before the first allocation");
+
+        void *small = arena.allocate(24, 8);
+        void *aligned = arena.allocate(1, 64);
+        if (reinterpret_cast<uintptr_t>(small) % 8 != 0)
+            throw std::runtime_error("The allocation should be aligned to 8 bytes");
+        if (reinterpret_cast<uintptr_t>(aligned) % 64 != 0)
+            throw std::runtime_error("The allocation should be aligned to 64 bytes");
+        if (arena.getBytesUsed() < 25)
+            throw std::runtime_error("The bytes handed out should be counted");
+
+        // An allocation larger than the chunk size gets a chunk of its own.
+        arena.allocate(1000);
+        if (arena.getChunkCount() < 2)
+            throw std::runtime_error("A large allocation should reserve another chunk");
+        if (arena.getBytesReserved() < arena.getBytesUsed())
+            throw std::runtime_error("The arena can not hand out more than it reserved");
+
+        JsonStringView copy = arena.copyString("hello");
+        if (copy != JsonStringView("hello"))
+            throw std::runtime_error("The copied string should be equal to the original");
+
+        arena.addCleanup(countCleanup, &cleanups);
+        if (cleanups != 0)
+            throw std::runtime_error("A cleanup should not run before the arena is destroyed");
+    }
+    if (cleanups != 1)
+        throw std::runtime_error("The cleanup should run once when the arena is destroyed");
+}
+
+static void testDocumentArena()
+{
+    JsonDocument document = JsonDocument::createFromString("{\"name\": \"John\", \"tags\": [\"a\", \"b\"], \"age\": 45}");
+
+    // Strings living in the arena can be replaced.
+    JsonString &name = document.getRoot()["name"];
+    name = std::string("Jane");
+    if (name.data() != "Jane")
+        throw std::runtime_error("The string should have been replaced");
+    const std::string other = "Jim";
+    name = other;
+    if (name.view() != JsonStringView("Jim"))
+        throw std::runtime_error("The string should have been replaced");
+
+    JsonArray &tags = document.getRoot()["tags"];
+    for (int i = 0; i < 1000; i++)
+        tags.addString("tag" + std::to_string(i));
+    if (tags.getChildCount() != 1002)
+        throw std::runtime_error("Every string should have been added");
+    if (tags[1001].toString().data() != "tag999")
+        throw std::runtime_error("The last string should be intact after the buffer grew");
+    if (tags[0].toString().data() != "a")
+        throw std::runtime_error("The first string should be intact after the buffer grew");
+
+    tags.removeChild(0);
+    if (tags[0].toString().data() != "b")
+        throw std::runtime_error("The string after the removed one should move forward");
+    if (document.getRoot()["age"].toNumber().data() != 45)
+        throw std::runtime_error("The number should be unchanged");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+        throw std::runtime_error("Provide the name of a test");
+
+    std::string test = argv[1];
+
+    if (test == "arena")
+    {
+        testArena();
+    }
+    else if (test == "document-arena")
+    {
+        testDocumentArena();
+    }
+    else
+    {
+        throw std::runtime_error("Unknown test: " + test);
+    }
+}
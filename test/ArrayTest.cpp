@@ -0,0 +1,203 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "Json.hpp"
+
+#include <stdexcept>
+#include <string>
+
+using namespace json;
+
+// Returns true if the document is written like a document parsed from the text, without indentation so deep documents stay small.
+static bool writesAs(const JsonDocument &document, const std::string &text)
+{
+    return document.toString(0) == JsonDocument::createFromString(text).toString(0);
+}
+
+static void testInlineContainers()
+{
+    JsonSmallVector<int, 4> vector;
+    for (int i = 0; i < 4; i++)
+        vector.push_back(i, nullptr);
+    if (!vector.isInline())
+        throw std::runtime_error("Four elements should be stored inside the vector");
+    vector.push_back(4, nullptr);
+    if (vector.isInline())
+        throw std::runtime_error("The fifth element should move the elements out of the vector");
+    vector.insert(0, -1, nullptr);
+    vector.erase(3);
+    const int expected[] = {-1, 0, 1, 3, 4};
+    if (vector.size() != 5)
+        throw std::runtime_error("The vector should hold five elements");
+    for (size_t i = 0; i < 5; i++)
+    {
+        if (vector[i] != expected[i])
+            throw std::runtime_error("The elements should keep their order after insert and erase");
+    }
+    vector.deallocate(nullptr);
+    if (!vector.isInline() || !vector.empty())
+        throw std::runtime_error("A deallocated vector should be empty and inline");
+
+    // A small array grows beyond its inline storage and keeps the order of its children.
+    JsonDocument document = JsonDocument::createFromString("{\"small\": [\"a\", \"b\"], \"point\": {\"x\": 1, \"y\": 2}}");
+    JsonArray &small = document.getRoot()["small"];
+    for (int i = 0; i < 10; i++)
+        small.addString(std::to_string(i));
+    if (small.getChildCount() != 12)
+        throw std::runtime_error("A small array should grow beyond its inline storage");
+    for (int i = 0; i < 10; i++)
+    {
+        if (small[i + 2].toString().data() != std::to_string(i))
+            throw std::runtime_error("The children should keep their order");
+    }
+
+    // A small object is searched in order, a larger one moves its members to a map.
+    JsonObject &point = document.getRoot()["point"];
+    for (int i = 0; i < 10; i++)
+        point.setNumber("z" + std::to_string(i), i);
+    point.removeChild("x");
+    if (point.hasChild("x") || point["y"].toNumber().data() != 2 || point["z9"].toNumber().data() != 9)
+        throw std::runtime_error("The members of a large object should be found");
+    try
+    {
+        point.getChild("missing");
+        throw std::runtime_error("Looking up a missing member should throw");
+    }
+    catch (const std::out_of_range &)
+    {
+    }
+
+}
+
+static void testPackedArrays()
+{
+    JsonDocument document = JsonDocument::createFromString("{\"values\": [1, 2, 3, 4, 5, 6, 7, 8, 9, 10], \"mixed\": [1, \"a\"]}");
+    JsonArray &values = document.getRoot()["values"];
+    JsonArray &mixed = document.getRoot()["mixed"];
+    if (!values.isPacked())
+        throw std::runtime_error("A parsed array of numbers should be packed");
+    if (mixed.pack() || mixed.isPacked())
+        throw std::runtime_error("An array holding a string can not be packed");
+
+    JsonSpan<double> numbers = values.getNumbers();
+    if (numbers.size() != 10 || numbers[9] != 10)
+        throw std::runtime_error("The packed buffer should hold every number");
+
+    // A node of a packed number sees the buffer, and the other way round.
+    JsonNumber &third = values[2];
+    third.data() = 30;
+    if (values.getNumbers()[2] != 30)
+        throw std::runtime_error("Changing a node should change the buffer");
+    values.getNumbers()[3] = 40;
+    if (values[3].toNumber().data() != 40)
+        throw std::runtime_error("Changing the buffer should change the node");
+
+    const double more[] = {11.5, 12};
+    values.addNumbers(JsonSpan<const double>(more, 2));
+    if (!values.isPacked() || values.getChildCount() != 12)
+        throw std::runtime_error("Adding numbers should keep the array packed");
+    if (!writesAs(document, "{\"values\":[1,2,30,40,5,6,7,8,9,10,11.5,12],\"mixed\":[1,\"a\"]}"))
+        throw std::runtime_error("A packed array should be written like any other array");
+
+    // Adding a child that is not a number unpacks the array.
+    values.addString("end");
+    if (values.isPacked())
+        throw std::runtime_error("Adding a string should unpack the array");
+    if (values[11].toNumber().data() != 12 || values[12].toString().data() != "end")
+        throw std::runtime_error("The children should survive unpacking");
+    try
+    {
+        values.getNumbers();
+        throw std::logic_error("getNumbers() should throw for an array that is not packed");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+
+    values.removeChild(12);
+    if (!values.pack() || !values.isPacked())
+        throw std::runtime_error("An array of numbers should be packed again");
+}
+
+static void testReserve()
+{
+    // The parser sizes every container exactly, so parsed containers have no unused capacity.
+    std::string text = "{\"list\": [";
+    for (int i = 0; i < 100; i++)
+        text += (i > 0 ? ", \"" : "\"") + std::to_string(i) + "\"";
+    text += "], \"object\": {";
+    for (int i = 0; i < 20; i++)
+        text += (i > 0 ? ", \"k" : "\"k") + std::to_string(i) + "\": null";
+    text += "}}";
+    JsonDocument document = JsonDocument::createFromString(text);
+    if (document.getRoot()["list"].memoryUsage().slack != 0)
+        throw std::runtime_error("A parsed array should have no unused capacity");
+    if (document.getRoot()["object"].memoryUsage().slack != 0)
+        throw std::runtime_error("A parsed object should have no unused capacity");
+
+    // Adding up to the reserved capacity does not grow the buffer.
+    JsonArray &array = document.getRoot().toObject().setArray("reserved");
+    array.reserve(50);
+    size_t capacity = array.memoryUsage().containerStorage + array.memoryUsage().slack;
+    if (capacity < 50 * sizeof(JsonNode *))
+        throw std::runtime_error("The array should have room for 50 children");
+    for (int i = 0; i < 50; i++)
+        array.addNull();
+    if (array.memoryUsage().slack != 0)
+        throw std::runtime_error("The reserved capacity should be used up");
+    if (array.memoryUsage().containerStorage != capacity)
+        throw std::runtime_error("Adding reserved children should not grow the buffer");
+
+    JsonObject &object = document.getRoot().toObject().setObject("reservedObject");
+    object.reserve(30);
+    for (int i = 0; i < 30; i++)
+        object.setNumber("k" + std::to_string(i), i);
+    if (object.getChildCount() != 30 || object["k29"].toNumber().data() != 29)
+        throw std::runtime_error("The reserved object should hold its members");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+        throw std::runtime_error("Provide the name of a test");
+
+    std::string test = argv[1];
+
+    if (test == "inline-containers")
+    {
+        testInlineContainers();
+    }
+    else if (test == "packed-arrays")
+    {
+        testPackedArrays();
+    }
+    else if (test == "reserve")
+    {
+        testReserve();
+    }
+    else
+    {
+        throw std::runtime_error("Unknown test: " + test);
+    }
+}
@@ -0,0 +1,492 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "Json.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace json;
+
+// Returns true if the document is written like a document parsed from the text, without indentation so deep documents stay small.
+static bool writesAs(const JsonDocument &document, const std::string &text)
+{
+    return document.toString(0) == JsonDocument::createFromString(text).toString(0);
+}
+
+static void testMoveSubtrees()
+{
+    JsonDocument source = JsonDocument::createFromString("{\"a\": [1, 2], \"b\": {\"c\": \"text\"}, \"d\": true}");
+    JsonDocument target = JsonDocument::createFromString("{\"list\": [\"x\"]}");
+    JsonObject &sourceRoot = source.getRoot();
+    JsonObject &targetRoot = target.getRoot();
+
+    // A detached subtree keeps the arena of its document alive.
+    JsonDocument detached = sourceRoot.detach("b");
+    if (sourceRoot.hasChild("b"))
+        throw std::runtime_error("The detached child should be removed");
+    targetRoot.attach("b", std::move(detached));
+    if (detached.hasRoot())
+        throw std::runtime_error("The attached document should be empty");
+
+    targetRoot["list"].toArray().splice(0, sourceRoot["a"].toArray(), 1);
+    targetRoot.splice("flag", sourceRoot, "d");
+    if (!writesAs(source, "{\"a\":[1]}"))
+        throw std::runtime_error("The moved children should be gone from the source");
+    if (!writesAs(target, "{\"list\":[2,\"x\"],\"b\":{\"c\":\"text\"},\"flag\":true}"))
+        throw std::runtime_error("The moved children should be in the target");
+
+    // Moving a child onto itself changes nothing.
+    targetRoot.splice("list", targetRoot, "list");
+    if (targetRoot.getNameAt(0) != JsonStringView("list"))
+        throw std::runtime_error("Splicing a child onto itself should keep its position");
+
+    // Moving subtrees in the other direction as well copies them, so the arenas do not keep each other alive.
+    JsonDocument back = targetRoot.detach("b");
+    sourceRoot.attach("b", std::move(back));
+    if (!writesAs(source, "{\"a\":[1],\"b\":{\"c\":\"text\"}}"))
+        throw std::runtime_error("The subtree should be moved back");
+
+    try
+    {
+        sourceRoot.attach("empty", JsonDocument());
+        throw std::logic_error("Attaching an empty document should throw");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+
+    source = JsonDocument();
+    if (!writesAs(target, "{\"list\":[2,\"x\"],\"flag\":true}"))
+        throw std::runtime_error("The target should survive the source");
+}
+
+static void testSnapshots()
+{
+    JsonDocument document = JsonDocument::createFromString("{\"users\": [{\"name\": \"a\"}, {\"name\": \"b\"}], \"count\": 2}");
+    JsonDocument snapshot = document.snapshot();
+    if (!(static_cast<const JsonDocument &>(document).getRoot().isShared()))
+        throw std::runtime_error("The root should be shared after a snapshot");
+
+    JsonArray &users = document.getRoot()["users"];
+    users[1].toObject().setString("name", "c");
+    users.addObject().setString("name", "d");
+    document.getRoot()["count"].toNumber() = 3;
+
+    if (!writesAs(snapshot, "{\"users\":[{\"name\":\"a\"},{\"name\":\"b\"}],\"count\":2}"))
+        throw std::runtime_error("The snapshot should not see the changes");
+    if (!writesAs(document, "{\"users\":[{\"name\":\"a\"},{\"name\":\"c\"},{\"name\":\"d\"}],\"count\":3}"))
+        throw std::runtime_error("The document should see its changes");
+
+    // Only the containers on the path to a change are copied, the rest stays shared.
+    const JsonDocument &constSnapshot = snapshot;
+    const JsonDocument &constDocument = document;
+    if (&constSnapshot.getRoot()["users"][0] != &constDocument.getRoot()["users"][0])
+        throw std::runtime_error("An unchanged subtree should stay shared");
+    if (&constSnapshot.getRoot()["users"][1] == &constDocument.getRoot()["users"][1])
+        throw std::runtime_error("A changed subtree should be copied");
+
+    // A snapshot outlives its document.
+    document = JsonDocument();
+    if (constSnapshot.getRoot()["users"][1]["name"].toString().data() != "b")
+        throw std::runtime_error("The snapshot should outlive the document");
+}
+
+static void testSnapshotReferences()
+{
+    const std::string text = "{\"user\": {\"name\": \"a\", \"age\": 1, \"active\": true, \"tags\": [\"x\"]}}";
+    JsonDocument document = JsonDocument::createFromString(text);
+    JsonObject &user = document.getRoot()["user"];
+    JsonString &name = user["name"];
+    JsonNumber &age = user["age"];
+    JsonBool &active = user["active"];
+    JsonArray &tags = user["tags"];
+
+    JsonDocument snapshot = document.snapshot();
+
+    // References taken before the snapshot refer to nodes the snapshot shares, changes through them throw.
+    try
+    {
+        user.setString("name", "b");
+        throw std::logic_error("Changing a shared object should throw");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+    try
+    {
+        tags.addString("y");
+        throw std::logic_error("Changing a shared array should throw");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+    try
+    {
+        name = std::string("b");
+        throw std::logic_error("Changing a shared string should throw");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+    try
+    {
+        age = 2;
+        throw std::logic_error("Changing a shared number should throw");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+    try
+    {
+        active = false;
+        throw std::logic_error("Changing a shared bool should throw");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+    if (!writesAs(snapshot, text))
+        throw std::runtime_error("The snapshot should not see any change");
+
+    // Reaching the nodes again through the document copies them, and the copies can be changed.
+    JsonObject &current = document.getRoot()["user"];
+    if (&current == &user)
+        throw std::runtime_error("The document should use a copy of the shared object");
+    current.setString("name", "b");
+    current["age"].toNumber() = 2;
+    current["active"].toBool() = false;
+    current["tags"].toArray().addString("y");
+    if (!writesAs(document, "{\"user\": {\"name\": \"b\", \"age\": 2, \"active\": false, \"tags\": [\"x\", \"y\"]}}"))
+        throw std::runtime_error("The document should see its changes");
+    if (!writesAs(snapshot, text))
+        throw std::runtime_error("The snapshot should not see the changes of the document");
+}
+
+static void testReadmeModifyExample()
+{
+    {
+        std::ofstream file("customers.json");
+        file << "[{\"firstName\": \"James\", \"lastName\": \"Smith\", \"age\": 40, \"married\": true, "
+                "\"hobbies\": [\"Golf\", \"Football\"]}, "
+                "{\"firstName\": \"John\", \"lastName\": \"Wilson\", \"age\": 32, \"married\": false, "
+                "\"hobbies\": [\"Basketball\", \"Skiing\", \"Surfing\"]}]";
+    }
+
+    // The example "Modify a value in a JSON file and save it" from the README.
+    {
+        JsonDocument doc = JsonDocument::createFromFile("customers.json");
+
+        JsonArray &customers = doc.getRoot();
+
+        JsonObject &james = customers[0];
+        JsonObject &john = customers[1];
+
+        JsonArray &hobbies = james["hobbies"];
+        hobbies.addString("Baseball");
+
+        JsonBool &married = john["married"];
+        married = true;
+
+        john["hobbies"].toArray().removeChild(2);
+
+        doc.saveToFile("customers.json");
+    }
+
+    JsonDocument saved = JsonDocument::createFromFile("customers.json");
+    if (!writesAs(saved, "[{\"firstName\": \"James\", \"lastName\": \"Smith\", \"age\": 40, \"married\": true, "
+                         "\"hobbies\": [\"Golf\", \"Football\", \"Baseball\"]}, "
+                         "{\"firstName\": \"John\", \"lastName\": \"Wilson\", \"age\": 32, \"married\": true, "
+                         "\"hobbies\": [\"Basketball\", \"Skiing\"]}]"))
+        throw std::runtime_error("The example should make its three changes");
+}
+
+static void testMemoryUsage()
+{
+    JsonDocument document = JsonDocument::create();
+    JsonArray &root = document.setArrayAsRoot();
+    root.addNull();
+    root.addBool(true);
+    root.addString("a string that is too long to be interned");
+
+    JsonMemoryUsage subtree = root.memoryUsage();
+    if (subtree.nodeHeaders != sizeof(JsonArray) + sizeof(JsonNull) + sizeof(JsonBool) + sizeof(JsonString))
+        throw std::runtime_error("Every node should be counted once");
+    if (subtree.valueStrings < 40)
+        throw std::runtime_error("The characters of the string should be counted");
+    if (subtree.keyStrings != 0)
+        throw std::runtime_error("An array has no names");
+
+    // The document reads the counters of its arena, which include everything the subtree uses.
+    JsonMemoryUsage total = document.memoryUsage();
+    if (total.nodeHeaders < subtree.nodeHeaders || total.valueStrings < subtree.valueStrings)
+        throw std::runtime_error("The document should count at least what its tree uses");
+    if (total.getBytesReserved() < total.getBytesUsed())
+        throw std::runtime_error("The reserved bytes include the used bytes");
+
+    JsonObject &object = root.addObject();
+    object.setString("name", "value");
+    JsonMemoryUsage grown = document.memoryUsage();
+    if (grown.getBytesUsed() <= total.getBytesUsed())
+        throw std::runtime_error("Adding nodes should increase the memory used");
+    if (grown.keyStrings <= total.keyStrings)
+        throw std::runtime_error("A new name should be counted as a key string");
+    if (object.memoryUsage().nodeHeaders != sizeof(JsonObject) + sizeof(JsonString))
+        throw std::runtime_error("The object and its member should be counted");
+}
+
+static void testDeepDocuments()
+{
+    // Far deeper than the call stack could handle if parsing, writing or destroying were recursive.
+    const size_t depth = 200000;
+    std::string text;
+    for (size_t i = 0; i < depth; i++)
+        text += i % 2 == 0 ? "[" : "{\"k\":";
+    text += "null";
+    for (size_t i = depth; i-- > 0;)
+        text += i % 2 == 0 ? "]" : "}";
+
+    {
+        JsonDocument document = JsonDocument::createFromString(text);
+        if (!writesAs(document, text))
+            throw std::runtime_error("A deep document should be written back unchanged");
+        if (document.memoryUsage().nodeHeaders <= 0)
+            throw std::runtime_error("A deep document should be measured");
+
+        JsonDocument copy = document.clone();
+        if (!copy.getRoot().equals(document.getRoot()))
+            throw std::runtime_error("A deep copy should be equal to the original");
+    }
+
+    // A deep tree built through the API is destroyed without recursion as well.
+    JsonDocument built = JsonDocument::create();
+    JsonArray *array = &built.setArrayAsRoot();
+    for (size_t i = 0; i < depth; i++)
+        array = &array->addArray();
+    built = JsonDocument();
+    if (built.hasRoot())
+        throw std::runtime_error("The deep document should be destroyed");
+}
+
+static void testClone()
+{
+    JsonDocument document = JsonDocument::createFromString("{\"price\": 1.50, \"items\": [{\"name\": \"a\"}, {\"name\": \"b\"}], \"packed\": [1, 2, 3, 4, 5, 6, 7, 8]}");
+
+    JsonDocument copy = document.clone();
+    if (copy.toString() != document.toString())
+        throw std::runtime_error("The copy should be written like the original");
+    if (!copy.getRoot().equals(document.getRoot()))
+        throw std::runtime_error("The copy should be equal to the original");
+    if (copy.getStringPool() == document.getStringPool())
+        throw std::runtime_error("The copy should have a pool of its own");
+    if (!copy.getRoot()["packed"].toArray().isPacked())
+        throw std::runtime_error("The copy of a packed array should be packed");
+
+    // The copy is independent of the original.
+    copy.getRoot()["items"][0]["name"].toString() = std::string("changed");
+    if (document.getRoot()["items"][0]["name"].toString().data() != "a")
+        throw std::runtime_error("Changing the copy should not change the original");
+
+    // Copying with the same pool shares the names and the shapes.
+    JsonDocument sameNames = document.clone(document.getStringPool());
+    if (sameNames.getRoot().toObject().getNameAt(1).data() != document.getRoot().toObject().getNameAt(1).data())
+        throw std::runtime_error("A copy with the same pool should share the names");
+    if (sameNames.getRoot()["items"][0].toObject().getShape() != document.getRoot()["items"][0].toObject().getShape())
+        throw std::runtime_error("A copy with the same pool should share the shapes");
+
+    // A subtree is copied into a document of its own, which outlives the original.
+    JsonDocument subtree = document.getRoot()["items"][1].clone();
+    document = JsonDocument();
+    if (!writesAs(subtree, "{\"name\":\"b\"}"))
+        throw std::runtime_error("The copy of a subtree should outlive the original");
+}
+
+static void testCompact()
+{
+    JsonDocument document = JsonDocument::create();
+    JsonArray &root = document.setArrayAsRoot();
+    for (int i = 0; i < 2000; i++)
+    {
+        JsonObject &row = root.addObject();
+        row.setNumber("id", i);
+        row.setString("text", "a value that is long enough to take some room " + std::to_string(i));
+    }
+    for (int i = 1999; i >= 0; i -= 2)
+        root.removeChild(static_cast<size_t>(i));
+    std::string before = document.toString();
+    size_t reserved = document.memoryUsage().getBytesReserved();
+
+    size_t reclaimed = document.compact();
+    if (reclaimed <= 0)
+        throw std::runtime_error("Compacting after many removals should reclaim memory");
+    if (document.memoryUsage().getBytesReserved() + reclaimed != reserved)
+        throw std::runtime_error("The reclaimed bytes should be measured with memoryUsage()");
+    if (document.toString() != before)
+        throw std::runtime_error("Compacting should not change the text");
+    if (document.memoryUsage().slack >= document.memoryUsage().getBytesUsed() / 4)
+        throw std::runtime_error("A compacted document should have little slack");
+
+    // The document can be changed after it has been compacted, and a snapshot keeps the old arena alive.
+    JsonDocument snapshot = document.snapshot();
+    JsonDocument expected = JsonDocument::createFromString(before);
+    expected.getRoot().toArray().addNull();
+    document.getRoot().toArray().addNull();
+    document.compact();
+    if (snapshot.toString() != before)
+        throw std::runtime_error("A snapshot should survive compacting its document");
+    if (document.toString() != expected.toString())
+        throw std::runtime_error("The change should survive compacting");
+}
+
+static void testDeduplicate()
+{
+    std::string text = "[";
+    for (int i = 0; i < 500; i++)
+        text += std::string(i > 0 ? "," : "") + "{\"brand\":\"Acme\",\"sizes\":[\"S\",\"M\",\"L\"],\"stock\":{\"warehouse\":\"north\",\"count\":" +
+                std::to_string(i % 5) + "}}";
+    text += "]";
+    JsonDocument document = JsonDocument::createFromString(text);
+    size_t reserved = document.memoryUsage().getBytesReserved();
+
+    size_t reclaimed = document.deduplicate();
+    if (reclaimed <= reserved / 2)
+        throw std::runtime_error("Deduplicating a repetitive document should reclaim most of its memory");
+    if (!writesAs(document, text))
+        throw std::runtime_error("Deduplicating should not change the text");
+
+    // Equal subtrees are stored once and shared.
+    const JsonDocument &constDocument = document;
+    if (&constDocument.getRoot()[0]["sizes"] != &constDocument.getRoot()[1]["sizes"])
+        throw std::runtime_error("Equal arrays should be shared");
+    if (&constDocument.getRoot()[0] != &constDocument.getRoot()[5])
+        throw std::runtime_error("Equal objects should be shared");
+    if (&constDocument.getRoot()[0] == &constDocument.getRoot()[1])
+        throw std::runtime_error("Different objects should not be shared");
+
+    // Changing a shared subtree copies it first, the other places keep the old value.
+    document.getRoot()[0]["sizes"].toArray().addString("XL");
+    if (constDocument.getRoot()[0]["sizes"].toArray().getChildCount() != 4)
+        throw std::runtime_error("The changed array should have the new element");
+    if (constDocument.getRoot()[5]["sizes"].toArray().getChildCount() != 3)
+        throw std::runtime_error("The other copies should be unchanged");
+}
+
+static void testInSitu()
+{
+    std::string text = "{\"plain\": \"abc\", \"escaped\": \"a\\nb\\u00e9\", \"list\": [\"x\", 1.25]}";
+    std::vector<char> buffer(text.begin(), text.end());
+    const char *first = buffer.data();
+    const char *last = first + buffer.size();
+
+    JsonDocument document = JsonDocument::createInSitu(buffer.data(), buffer.size());
+    const JsonObject &root = document.getRoot();
+    JsonStringView plain = root["plain"].toString().view();
+    JsonStringView escaped = root["escaped"].toString().view();
+    if (plain != JsonStringView("abc") || plain.data() < first || plain.data() >= last)
+        throw std::runtime_error("A string should point into the buffer");
+    if (escaped != JsonStringView("a\nb\xc3\xa9"))
+        throw std::runtime_error("A string with escape sequences should be unescaped");
+    if (escaped.data() < first || escaped.data() >= last)
+        throw std::runtime_error("An unescaped string should be stored in the buffer as well");
+    if (!writesAs(document, "{\"plain\":\"abc\",\"escaped\":\"a\\nb\xc3\xa9\",\"list\":[\"x\",1.25]}"))
+        throw std::runtime_error("The document should be written as usual");
+
+    // A copy no longer needs the buffer.
+    JsonDocument copy = document.clone();
+    document = JsonDocument();
+    std::fill(buffer.begin(), buffer.end(), '#');
+    if (copy.getRoot()["plain"].toString().data() != "abc")
+        throw std::runtime_error("A copy should not refer to the buffer");
+
+    // The document can take over a string and keep it alive.
+    JsonDocument owning = JsonDocument::createInSitu(std::string("[\"owned\", true]"));
+    if (!writesAs(owning, "[\"owned\",true]"))
+        throw std::runtime_error("A document should keep the string it took over");
+
+    std::string invalid = "[\"unterminated]";
+    try
+    {
+        JsonDocument::createInSitu(&invalid[0], invalid.size());
+        throw std::logic_error("Invalid text should throw");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+        throw std::runtime_error("Provide the name of a test");
+
+    std::string test = argv[1];
+
+    if (test == "move-subtrees")
+    {
+        testMoveSubtrees();
+    }
+    else if (test == "snapshots")
+    {
+        testSnapshots();
+    }
+    else if (test == "snapshot-references")
+    {
+        testSnapshotReferences();
+    }
+    else if (test == "readme-modify-example")
+    {
+        testReadmeModifyExample();
+    }
+    else if (test == "memory-usage")
+    {
+        testMemoryUsage();
+    }
+    else if (test == "deep-documents")
+    {
+        testDeepDocuments();
+    }
+    else if (test == "clone")
+    {
+        testClone();
+    }
+    else if (test == "compact")
+    {
+        testCompact();
+    }
+    else if (test == "deduplicate")
+    {
+        testDeduplicate();
+    }
+    else if (test == "in-situ")
+    {
+        testInSitu();
+    }
+    else
+    {
+        throw std::runtime_error("Unknown test: " + test);
+    }
+}
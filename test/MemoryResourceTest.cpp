@@ -0,0 +1,173 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "Json.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace json;
+
+// Counts the bytes that have been allocated and not given back yet, the memory itself comes from malloc.
+class CountingResource : public JsonMemoryResource
+{
+public:
+    CountingResource() : outstanding(0), allocations(0)
+    {
+    }
+
+    std::atomic<size_t> outstanding;
+    std::atomic<size_t> allocations;
+
+private:
+    void *doAllocate(size_t bytes, size_t alignment) override
+    {
+        void *pointer = getMalloc()->allocate(bytes, alignment);
+        outstanding += bytes;
+        allocations++;
+        return pointer;
+    }
+
+    void doDeallocate(void *pointer, size_t bytes, size_t alignment) noexcept override
+    {
+        outstanding -= bytes;
+        getMalloc()->deallocate(pointer, bytes, alignment);
+    }
+
+    bool doIsEqual(const JsonMemoryResource &other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+// Returns true if the document is written like a document parsed from the text, without indentation so deep documents stay small.
+static bool writesAs(const JsonDocument &document, const std::string &text)
+{
+    return document.toString(0) == JsonDocument::createFromString(text).toString(0);
+}
+
+static void testMemoryResources()
+{
+    const std::string text = "{\"name\": \"a string value\", \"list\": [1, 2, {\"nested\": true}]}";
+
+    // Every allocation of a document, including its pool, comes from the resource and goes back to it.
+    CountingResource counting;
+    {
+        std::shared_ptr<JsonStringPool> pool = JsonStringPool::createShared(0, &counting);
+        JsonDocument document = JsonDocument::createFromString(text, pool, &counting);
+        if (counting.outstanding <= 0)
+            throw std::runtime_error("The document should allocate from the resource");
+        if (!writesAs(document, "{\"name\":\"a string value\",\"list\":[1,2,{\"nested\":true}]}"))
+            throw std::runtime_error("The document should be parsed as usual");
+        JsonDocument copy = document.clone();
+        if (!copy.getRoot().equals(document.getRoot()))
+            throw std::runtime_error("A copy should be made from the same resource");
+    }
+    if (counting.outstanding != 0)
+        throw std::runtime_error("Every allocation should be given back");
+
+    // A reclaimer gives the memory back to the resource, a snapshot keeps the nodes it shares.
+    {
+        JsonReclaimer reclaimer(2);
+        JsonDocument document = JsonDocument::createFromString(text, nullptr, &counting);
+        JsonDocument kept = JsonDocument::createFromString(text, nullptr, &counting);
+        JsonDocument snapshot = kept.snapshot();
+        size_t before = counting.outstanding;
+        reclaimer.reclaim(std::move(document));
+        reclaimer.reclaim(std::move(kept));
+        reclaimer.drain();
+        if (counting.outstanding >= before)
+            throw std::runtime_error("The memory of the reclaimed document should be given back");
+        if (!writesAs(snapshot, text))
+            throw std::runtime_error("The snapshot should keep its nodes");
+    }
+    if (counting.outstanding != 0)
+        throw std::runtime_error("All memory should be given back once the snapshot is gone");
+
+    // The default resource is used when no resource is given.
+    JsonMemoryResource *previous = JsonMemoryResource::setDefault(&counting);
+    {
+        JsonDocument document = JsonDocument::createFromString(text);
+        if (counting.outstanding <= 0)
+            throw std::runtime_error("A document should use the default resource");
+    }
+    if (JsonMemoryResource::setDefault(previous) != &counting)
+        throw std::runtime_error("setDefault() should return the previous resource");
+    if (counting.outstanding != 0)
+        throw std::runtime_error("The default resource should get every allocation back");
+
+    // A monotonic resource uses its buffer first and never gives memory back one allocation at a time.
+    alignas(std::max_align_t) char buffer[4096];
+    JsonMonotonicResource monotonic(buffer, sizeof(buffer), &counting);
+    void *first = monotonic.allocate(100);
+    if (first < static_cast<void *>(buffer) || first >= static_cast<void *>(buffer + sizeof(buffer)))
+        throw std::runtime_error("The buffer should be used first");
+    monotonic.allocate(8192);
+    if (counting.outstanding <= 0)
+        throw std::runtime_error("A large allocation should come from the upstream resource");
+    monotonic.release();
+    if (counting.outstanding != 0)
+        throw std::runtime_error("release() should give everything back upstream");
+
+    // A pool resource hands out a freed block again.
+    JsonPoolResource pool(&counting);
+    void *block = pool.allocate(48);
+    pool.deallocate(block, 48);
+    if (pool.allocate(40) != block)
+        throw std::runtime_error("A freed block should be reused for a request of the same size class");
+    for (int i = 0; i < 3; i++)
+        JsonDocument::createFromString(text, nullptr, &pool);
+    size_t allocations = counting.allocations;
+    for (int i = 0; i < 10; i++)
+        JsonDocument::createFromString(text, nullptr, &pool);
+    if (counting.allocations != allocations)
+        throw std::runtime_error("Documents of the same size should reuse the blocks of the pool");
+
+    std::vector<int, JsonResourceAllocator<int>> vector{JsonResourceAllocator<int>(&monotonic)};
+    vector.assign(100, 7);
+    if (vector.size() != 100 || vector[99] != 7)
+        throw std::runtime_error("A standard container should work with a resource");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+        throw std::runtime_error("Provide the name of a test");
+
+    std::string test = argv[1];
+
+    if (test == "memory-resources")
+    {
+        testMemoryResources();
+    }
+    else
+    {
+        throw std::runtime_error("Unknown test: " + test);
+    }
+}
@@ -0,0 +1,136 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "Json.hpp"
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+using namespace json;
+
+static void testNodeTypes()
+{
+    static_assert(!std::is_polymorphic<JsonNode>::value, "A JsonNode should not have a vtable");
+
+    JsonDocument document = JsonDocument::createFromString("[[], {}, true, null, 1.5, \"text\"]");
+    const JsonArray &root = document.getRoot();
+    const JsonNodeType types[] = {JsonNodeType::Array, JsonNodeType::Object, JsonNodeType::Bool,
+                                  JsonNodeType::Null, JsonNodeType::Number, JsonNodeType::String};
+    for (size_t i = 0; i < 6; i++)
+    {
+        if (root[i].getType() != types[i])
+            throw std::runtime_error("The node should have the type it was parsed as");
+    }
+
+    if (!root[2].toBool().data())
+        throw std::runtime_error("The bool should be true");
+    if (root[4].toNumber().data() != 1.5)
+        throw std::runtime_error("The number should be 1.5");
+    if (root[5].toString().data() != "text")
+        throw std::runtime_error("The string should be text");
+
+    try
+    {
+        root[5].toArray();
+        throw std::logic_error("Converting a string to an array should throw");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+    try
+    {
+        const JsonObject &object = root[0];
+        (void)object;
+        throw std::logic_error("Converting an array to an object should throw");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+
+    // A std::unique_ptr<JsonNode> destroys a node created with new as the type it was created as.
+    std::unique_ptr<JsonNode> node(new JsonString("owned"));
+    JsonDocument owned(std::move(node));
+    if (owned.getRoot().getType() != JsonNodeType::String)
+        throw std::runtime_error("The root should be a string");
+    if (owned.getRoot().toString().data() != "owned")
+        throw std::runtime_error("The root should hold its value");
+}
+
+static void testValueAssignment()
+{
+    JsonDocument document = JsonDocument::createFromString("{\"flag\": false, \"count\": 1, \"name\": \"a\"}");
+    JsonObject &root = document.getRoot();
+
+    // Assigning a value changes the node in place, it keeps its parent and its position.
+    JsonBool &flag = root["flag"];
+    flag = true;
+    JsonNumber &count = root["count"];
+    count = 2.5;
+    JsonString &name = root["name"];
+    name = std::string("b");
+    if (&root["flag"] != &flag || &root["count"] != &count || &root["name"] != &name)
+        throw std::runtime_error("Assigning a value should not replace the node");
+    if (!flag.hasParent() || !count.hasParent() || !name.hasParent())
+        throw std::runtime_error("Assigning a value should not change the parent of the node");
+    if (!root["flag"].toBool().data() || root["count"].toNumber().data() != 2.5 || root["name"].toString().data() != "b")
+        throw std::runtime_error("The nodes should hold the assigned values");
+
+    // The values can be changed through data() as well.
+    flag.data() = false;
+    count.data() = 3;
+    if (root["flag"].toBool().data() || root["count"].toNumber().data() != 3)
+        throw std::runtime_error("The nodes should hold the values set through data()");
+
+    // Nodes without a parent can be assigned too.
+    JsonBool alone(false);
+    alone = true;
+    JsonNumber number(1);
+    number = 4;
+    if (!alone.data() || number.data() != 4)
+        throw std::runtime_error("A node without a parent should hold the assigned value");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+        throw std::runtime_error("Provide the name of a test");
+
+    std::string test = argv[1];
+
+    if (test == "node-types")
+    {
+        testNodeTypes();
+    }
+    else if (test == "value-assignment")
+    {
+        testValueAssignment();
+    }
+    else
+    {
+        throw std::runtime_error("Unknown test: " + test);
+    }
+}
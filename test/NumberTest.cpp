@@ -0,0 +1,236 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "Json.hpp"
+#include "JsonParser.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace json;
+
+// Writes the document without whitespace, which only works for documents without strings.
+static std::string withoutSpaces(const JsonDocument &document)
+{
+    std::string text = document.toString();
+    text.erase(std::remove_if(text.begin(), text.end(), [](char c) { return std::isspace(static_cast<unsigned char>(c)) != 0; }), text.end());
+    return text;
+}
+
+// Writes a number with the shortest text, or with the given number of decimals.
+static std::string formatNumber(double value, int decimals = -1)
+{
+    char buffer[JsonNumber::maximumFormatSize];
+    char *end = decimals < 0 ? JsonNumber::format(value, buffer) : JsonNumber::format(value, decimals, buffer);
+    return std::string(buffer, end);
+}
+
+static void testLazyNumbers()
+{
+    JsonDocument document = JsonDocument::createFromString("[1.50, 1e5, -0, 12345678901234567890, 1e400, 3]");
+    const JsonArray &numbers = document.getRoot();
+    if (numbers[0].toNumber().getText() != JsonStringView("1.50"))
+        throw std::runtime_error("A number should keep its text");
+    if (numbers[0].toNumber().data() != 1.5)
+        throw std::runtime_error("The text should be decoded when the value is read");
+    if (numbers[1].toNumber().isInteger() || !numbers[5].toNumber().isInteger())
+        throw std::runtime_error("Only plain integers should be integers");
+    if (!numbers[3].toNumber().hasText())
+        throw std::runtime_error("A large integer should keep its text");
+    if (numbers[5].toNumber().getInteger() != 3)
+        throw std::runtime_error("An integer should be converted exactly");
+    try
+    {
+        numbers[3].toNumber().getInteger();
+        throw std::logic_error("An integer too large for int64_t should throw");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+    if (withoutSpaces(document) != "[1.50,1e5,-0,12345678901234567890,1e400,3]")
+        throw std::runtime_error("Every number should be written with its text");
+
+    // A copy keeps the text as well.
+    JsonDocument copy = document.clone();
+    if (copy.getRoot()[0].toNumber().getText() != JsonStringView("1.50"))
+        throw std::runtime_error("A copy should keep the text of a number");
+
+    // An array of numbers is only packed if every number is written back the way it was read.
+    const char *kept[] = {"12345678901234567890", "1e5", "1e400", "1.50", "0.10"};
+    for (const char *number : kept)
+    {
+        std::string text = "[";
+        for (int i = 0; i < 8; i++)
+            text += std::string(i > 0 ? "," : "") + number;
+        text += "]";
+        JsonDocument array = JsonDocument::createFromString(text);
+        if (array.getRoot().toArray().isPacked())
+            throw std::runtime_error("An array that would lose the text of a number should not be packed");
+        if (array.getRoot().toArray().pack())
+            throw std::runtime_error("pack() should not lose the text of a number");
+        if (withoutSpaces(array) != text)
+            throw std::runtime_error("Every number should be written back unchanged: " + text);
+    }
+    JsonDocument packed = JsonDocument::createFromString("[1,2.5,-3,0.1,1e21,1e-7,100,-0]");
+    if (!packed.getRoot().toArray().isPacked())
+        throw std::runtime_error("An array of numbers in their shortest form should be packed");
+    if (withoutSpaces(packed) != "[1,2.5,-3,0.1,1e21,1e-7,100,-0]")
+        throw std::runtime_error("A packed array should be written back unchanged");
+
+    // A modified number is written from its value.
+    JsonNumber &first = document.getRoot()[0];
+    first = 2.25;
+    if (first.hasText() || withoutSpaces(document).find("[2.25,") != 0)
+        throw std::runtime_error("A modified number should be written from its value");
+}
+
+static void testNumbersWithoutArena()
+{
+    // A tree parsed without an arena keeps the text of its numbers like a document does.
+    const std::string text = "[1.50, 1e400, 12345678901234567890, -0.0, 1.0E+2]";
+    std::istringstream input(text);
+    JsonNodePtr root = JsonParser::parse(input);
+    const JsonArray &numbers = root->toArray();
+    const char *texts[] = {"1.50", "1e400", "12345678901234567890", "-0.0", "1.0E+2"};
+    for (size_t i = 0; i < 5; i++)
+    {
+        if (numbers[i].toNumber().getText() != JsonStringView(texts[i]))
+            throw std::runtime_error(std::string("A number should keep its text: ") + texts[i]);
+    }
+
+    JsonDocument document(std::move(root));
+    if (withoutSpaces(document) != "[1.50,1e400,12345678901234567890,-0.0,1.0E+2]")
+        throw std::runtime_error("Every number should be written with its text");
+    if (document.toString() != JsonDocument::createFromString(text).toString())
+        throw std::runtime_error("A tree without an arena should be written like a document");
+
+    // A modified number no longer needs its text.
+    document.getRoot()[1].toNumber() = 2.5;
+    if (document.getRoot()[1].toNumber().hasText() || withoutSpaces(document) != "[1.50,2.5,12345678901234567890,-0.0,1.0E+2]")
+        throw std::runtime_error("A modified number should be written from its value");
+}
+
+static void testNumberFormatting()
+{
+    const std::pair<double, const char *> shortest[] = {
+        {0.1, "0.1"}, {0.3, "0.3"}, {-1.5, "-1.5"}, {100, "100"}, {-0.0, "-0"}, {2.0 / 3, "0.6666666666666666"},
+        {1e20, "100000000000000000000"}, {1e21, "1e21"}, {1e-6, "0.000001"}, {1e-7, "1e-7"}, {1e300, "1e300"},
+        {5e-324, "5e-324"}, {1.7976931348623157e308, "1.7976931348623157e308"}, {9007199254740993.0, "9007199254740992"}};
+    for (const std::pair<double, const char *> &number : shortest)
+    {
+        if (formatNumber(number.first) != number.second)
+            throw std::runtime_error(std::string("A number should be written as ") + number.second);
+    }
+
+    if (formatNumber(1.005, 2) != "1.01")
+        throw std::runtime_error("The shortest text should be rounded half up");
+    if (formatNumber(2.5, 0) != "3" || formatNumber(-0.125, 2) != "-0.13")
+        throw std::runtime_error("Rounding should work away from zero");
+    if (formatNumber(-0.001, 2) != "0.00" || formatNumber(-0.4, 0) != "0" || formatNumber(-0.005, 2) != "-0.01")
+        throw std::runtime_error("A value that rounds to zero should be written without a sign");
+    if (formatNumber(1e22, 2) != "1e22")
+        throw std::runtime_error("Large values should not get decimals");
+
+    char buffer[JsonNumber::maximumFormatSize];
+    if (std::string(buffer, JsonNumber::formatInteger(std::numeric_limits<int64_t>::min(), buffer)) != "-9223372036854775808")
+        throw std::runtime_error("The smallest integer should be written");
+    if (std::string(buffer, JsonNumber::formatInteger(std::numeric_limits<uint64_t>::max(), buffer)) != "18446744073709551615")
+        throw std::runtime_error("The largest unsigned integer should be written");
+    if (std::string(buffer, JsonNumber::formatInteger(int64_t(0), buffer)) != "0")
+        throw std::runtime_error("Zero should be written");
+
+    // Any bit pattern should read back as the same value.
+    std::mt19937_64 random(42);
+    for (int i = 0; i < 100000; i++)
+    {
+        uint64_t bits = random();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        if (!std::isfinite(value))
+            continue;
+        std::string text = formatNumber(value);
+        if (JsonNumber::parse(text) != value || !JsonNumber::formatsAs(value, text))
+            throw std::runtime_error("A number should read back as the same value: " + text);
+    }
+
+    // Infinity and NaN have no JSON text, but a parsed number keeps the text it was read with.
+    JsonDocument document = JsonDocument::createFromString("[1e400, -1e400, 1.5]");
+    JsonFormat decimals = JsonFormat::compact();
+    decimals.decimals = 1;
+    if (document.toString(decimals) != "[1e400,-1e400,1.5]")
+        throw std::runtime_error("Parsed numbers out of range should keep their text");
+    document.getRoot().toArray().getChild(0).toNumber() = std::numeric_limits<double>::infinity();
+    try
+    {
+        document.toString();
+        throw std::logic_error("Infinity should not be written");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+    document.getRoot().toArray().getChild(0).toNumber() = std::numeric_limits<double>::quiet_NaN();
+    try
+    {
+        document.toString();
+        throw std::logic_error("NaN should not be written");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+        throw std::runtime_error("Provide the name of a test");
+
+    std::string test = argv[1];
+
+    if (test == "lazy-numbers")
+    {
+        testLazyNumbers();
+    }
+    else if (test == "numbers-without-arena")
+    {
+        testNumbersWithoutArena();
+    }
+    else if (test == "number-formatting")
+    {
+        testNumberFormatting();
+    }
+    else
+    {
+        throw std::runtime_error("Unknown test: " + test);
+    }
+}
@@ -0,0 +1,190 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "Json.hpp"
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace json;
+
+// Returns true if the document is written like a document parsed from the text, without indentation so deep documents stay small.
+static bool writesAs(const JsonDocument &document, const std::string &text)
+{
+    return document.toString(0) == JsonDocument::createFromString(text).toString(0);
+}
+
+static void testShapes()
+{
+    JsonDocument document = JsonDocument::createFromString(
+        "[{\"x\": 1, \"y\": 2}, {\"x\": 3, \"y\": 4}, {\"y\": 5, \"x\": 6}]");
+    JsonArray &points = document.getRoot();
+    const JsonShape *shape = points[0].toObject().getShape();
+    if (shape == nullptr)
+        throw std::runtime_error("A parsed object should use a shape");
+    if (shape->size() != 2 || shape->getName(1) != JsonStringView("y"))
+        throw std::runtime_error("The shape should hold the names in order");
+    if (points[1].toObject().getShape() != shape)
+        throw std::runtime_error("Objects with the same names should share a shape");
+    if (points[2].toObject().getShape() == shape)
+        throw std::runtime_error("Objects with the names in another order should not share a shape");
+    if (points[2]["x"].toNumber().data() != 6)
+        throw std::runtime_error("A member should be found through the shape");
+
+    // Adding a name moves the object to another shape, and removing one gives the object names of its own.
+    points[0].toObject().setNumber("z", 7);
+    if (points[0].toObject().getShape() == shape)
+        throw std::runtime_error("An object with a new name should change its shape");
+    if (points[1].toObject().getShape() != shape)
+        throw std::runtime_error("The other objects should keep their shape");
+    points[1].toObject().removeChild("x");
+    if (points[1].toObject().getShape() != nullptr)
+        throw std::runtime_error("An object should store its own names after a removal");
+    if (!writesAs(document, "[{\"x\":1,\"y\":2,\"z\":7},{\"y\":4},{\"y\":5,\"x\":6}]"))
+        throw std::runtime_error("The text should follow the changes");
+}
+
+static void testInsertionOrder()
+{
+    JsonDocument document = JsonDocument::create();
+    JsonObject &object = document.setObjectAsRoot();
+    object.setNumber("zebra", 1);
+    object.setNumber("apple", 2);
+    object.setNumber("mango", 3);
+
+    const char *names[] = {"zebra", "apple", "mango"};
+    size_t index = 0;
+    for (auto pair : object)
+    {
+        if (pair.first != JsonStringView(names[index++]))
+            throw std::runtime_error("The members should be visited in insertion order");
+    }
+    if (index != 3)
+        throw std::runtime_error("Every member should be visited");
+
+    // Replacing a member keeps its position, removing one keeps the order of the others.
+    object.setNumber("zebra", 4);
+    object.removeChild("apple");
+    if (!writesAs(document, "{\"zebra\":4,\"mango\":3}"))
+        throw std::runtime_error("The text should keep the insertion order");
+
+    // Large objects are indexed, every member must still be found after removals.
+    JsonObject &large = object.setObject("large");
+    for (int i = 0; i < 1000; i++)
+        large.setNumber("key" + std::to_string(i), i);
+    for (int i = 0; i < 1000; i += 3)
+        large.removeChild("key" + std::to_string(i));
+    for (int i = 0; i < 1000; i++)
+    {
+        std::string name = "key" + std::to_string(i);
+        if (large.hasChild(name) != (i % 3 != 0))
+            throw std::runtime_error("A member should be found exactly when it was not removed");
+        if (i % 3 != 0)
+            if (large[name].toNumber().data() != i)
+                throw std::runtime_error("A member should hold its value");
+    }
+    if (large.getNameAt(0) != JsonStringView("key1"))
+        throw std::runtime_error("The first remaining member should come first");
+    if (large.getChildCount() != 666)
+        throw std::runtime_error("The removed members should be gone");
+}
+
+static void testKeyLookup()
+{
+    JsonDocument document = JsonDocument::createFromString(
+        "[{\"id\": 1, \"name\": \"a\"}, {\"id\": 2, \"name\": \"b\"}, {\"name\": \"c\", \"id\": 3}, {\"name\": \"d\"}]");
+    const JsonArray &rows = document.getRoot();
+
+    // The same key works for objects with the same shape, another shape and without the name.
+    JsonKey id("id");
+    if (id.hash() != JsonStringView("id").hash())
+        throw std::runtime_error("The key should hash like the name");
+    for (int i = 0; i < 3; i++)
+    {
+        if (rows[i][id].toNumber().data() != i + 1)
+            throw std::runtime_error("The key should find the member in every object");
+    }
+    if (rows[3].toObject().hasChild(id))
+        throw std::runtime_error("The key should not be found in an object without the name");
+    try
+    {
+        rows[3].toObject().getChild(id);
+        throw std::runtime_error("Looking up a missing key should throw");
+    }
+    catch (const std::out_of_range &)
+    {
+    }
+
+    // The key also works in a document with another pool and in a document without a pool.
+    std::istringstream input("{\"name\": \"e\", \"id\": 5}");
+    JsonDocument unpooled = JsonDocument::createFromStream(input, nullptr);
+    JsonDocument other = JsonDocument::createFromString("{\"id\": 4}");
+    if (other.getRoot()[id].toNumber().data() != 4)
+        throw std::runtime_error("The key should work with another pool");
+    if (unpooled.getRoot()[id].toNumber().data() != 5)
+        throw std::runtime_error("The key should work without a pool");
+
+    // Names can be looked up with views that are not null-terminated.
+    const char *text = "identity";
+    if (rows[0][JsonStringView(text, 2)].toNumber().data() != 1)
+        throw std::runtime_error("A view of part of a string should be found");
+    if (rows[1]["name"].toString().data() != "b")
+        throw std::runtime_error("A string literal should be found");
+
+    // A large object is looked up through its index.
+    JsonObject &large = document.getRoot()[3];
+    for (int i = 0; i < 200; i++)
+        large.setNumber("field" + std::to_string(i), i);
+    JsonKey last("field199");
+    if (large[last].toNumber().data() != 199)
+        throw std::runtime_error("The key should be found in a large object");
+    if (large[last].toNumber().data() != 199)
+        throw std::runtime_error("The key should be found again");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+        throw std::runtime_error("Provide the name of a test");
+
+    std::string test = argv[1];
+
+    if (test == "shapes")
+    {
+        testShapes();
+    }
+    else if (test == "insertion-order")
+    {
+        testInsertionOrder();
+    }
+    else if (test == "key-lookup")
+    {
+        testKeyLookup();
+    }
+    else
+    {
+        throw std::runtime_error("Unknown test: " + test);
+    }
+}
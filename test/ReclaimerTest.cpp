@@ -0,0 +1,84 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "Json.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace json;
+
+// Returns true if the document is written like a document parsed from the text, without indentation so deep documents stay small.
+static bool writesAs(const JsonDocument &document, const std::string &text)
+{
+    return document.toString(0) == JsonDocument::createFromString(text).toString(0);
+}
+
+static void testReclaimer()
+{
+    std::string text = "[";
+    for (int i = 0; i < 10000; i++)
+        text += (i > 0 ? ",{\"id\":" : "{\"id\":") + std::to_string(i) + ",\"tags\":[\"a\",\"b\"]}";
+    text += "]";
+
+    JsonReclaimer reclaimer(2);
+    JsonDocument document = JsonDocument::createFromString(text);
+    JsonDocument kept = JsonDocument::createFromString(text);
+    JsonDocument snapshot = kept.snapshot();
+
+    reclaimer.reclaim(std::move(document));
+    if (document.hasRoot())
+        throw std::runtime_error("The reclaimed document should be left empty");
+    reclaimer.reclaim(std::move(kept));
+
+    // A document built with new is freed node by node.
+    JsonNodePtr root(new JsonArray());
+    for (int i = 0; i < 1000; i++)
+        static_cast<JsonArray &>(*root).addArray().addString("node");
+    reclaimer.reclaim(JsonDocument(std::move(root)));
+
+    reclaimer.drain();
+    if (reclaimer.getPendingCount() != 0)
+        throw std::runtime_error("Every document should be freed after drain()");
+    if (!writesAs(snapshot, text))
+        throw std::runtime_error("The snapshot should survive the reclaimed document");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+        throw std::runtime_error("Provide the name of a test");
+
+    std::string test = argv[1];
+
+    if (test == "reclaimer")
+    {
+        testReclaimer();
+    }
+    else
+    {
+        throw std::runtime_error("Unknown test: " + test);
+    }
+}
@@ -0,0 +1,240 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "Json.hpp"
+
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace json;
+
+// Writes the document without whitespace.
+static std::string compact(const JsonDocument &document)
+{
+    return document.toString(JsonFormat::compact());
+}
+
+// Escapes a string the way the serializer does and returns the text.
+static std::string escape(const std::string &value, bool ensureAscii)
+{
+    std::string result;
+    JsonOutputBuffer output(result);
+    JsonString::escape(value, output, ensureAscii);
+    output.flush();
+    return result;
+}
+
+static void testFormats()
+{
+    JsonDocument document = JsonDocument::createFromString("{\"a\": [1, 2.5, {}], \"b\": {\"c\": null, \"d\": []}, \"e\": \"x\", \"f\": true}");
+
+    const std::string fourSpaces =
+        "{\n"
+        "    \"a\": [\n"
+        "        1,\n"
+        "        2.5,\n"
+        "        {}\n"
+        "    ],\n"
+        "    \"b\": {\n"
+        "        \"c\": null,\n"
+        "        \"d\": []\n"
+        "    },\n"
+        "    \"e\": \"x\",\n"
+        "    \"f\": true\n"
+        "}";
+    if (document.toString() != fourSpaces)
+        throw std::runtime_error("The default format should indent with four spaces");
+
+    const std::string twoSpaces =
+        "{\n"
+        "  \"a\": [\n"
+        "    1,\n"
+        "    2.5,\n"
+        "    {}\n"
+        "  ],\n"
+        "  \"b\": {\n"
+        "    \"c\": null,\n"
+        "    \"d\": []\n"
+        "  },\n"
+        "  \"e\": \"x\",\n"
+        "  \"f\": true\n"
+        "}";
+    if (document.toString(JsonFormat::indented(2)) != twoSpaces)
+        throw std::runtime_error("An indented format should use its tab size");
+    if (document.toString(2) != document.toString(JsonFormat::indented(2)))
+        throw std::runtime_error("toString(tabSize) should match the indented format");
+
+    const std::string compactText = "{\"a\":[1,2.5,{}],\"b\":{\"c\":null,\"d\":[]},\"e\":\"x\",\"f\":true}";
+    if (compact(document) != compactText)
+        throw std::runtime_error("The compact format should write no whitespace");
+    if (compact(JsonDocument::createFromString(compactText)) != compactText)
+        throw std::runtime_error("Compact text should round trip");
+    if (compact(JsonDocument::createFromString(document.toString())) != compactText)
+        throw std::runtime_error("Pretty text should read back as the same document");
+
+    JsonFormat decimals = JsonFormat::compact();
+    decimals.decimals = 2;
+    if (document.toString(decimals) != "{\"a\":[1,2.50,{}],\"b\":{\"c\":null,\"d\":[]},\"e\":\"x\",\"f\":true}")
+        throw std::runtime_error("Numbers that are not integers should get exactly the given decimals");
+
+    std::ostringstream stream;
+    document.writeToStream(stream, JsonFormat::compact());
+    if (stream.str() != compactText)
+        throw std::runtime_error("A stream should receive the same text");
+
+    std::string output = "previous content";
+    document.writeToString(output, JsonFormat::compact());
+    if (output != compactText)
+        throw std::runtime_error("writeToString() should replace the content of the string");
+    output.reserve(4096);
+    const char *data = output.data();
+    document.writeToString(output, JsonFormat::compact());
+    if (output != compactText || output.data() != data)
+        throw std::runtime_error("writeToString() should reuse the capacity of the string");
+
+    if (compact(JsonDocument::createFromString("[]")) != "[]" || JsonDocument::createFromString("{}").toString() != "{}")
+        throw std::runtime_error("Empty containers should stay on one line");
+    if (JsonDocument::createFromString("\"text\"").toString() != "\"text\"" || compact(JsonDocument::createFromString("-0.5")) != "-0.5")
+        throw std::runtime_error("A single value should be written as it is");
+}
+
+static void testEscaping()
+{
+    if (escape("q\"\\\b\f\n\r\t\x01\x1f/", false) != "q\\\"\\\\\\b\\f\\n\\r\\t\\u0001\\u001f/")
+        throw std::runtime_error("Quotes, backslashes and control characters should be escaped");
+    if (escape("caf\xC3\xA9 \xF0\x9F\x98\x80", false) != "caf\xC3\xA9 \xF0\x9F\x98\x80")
+        throw std::runtime_error("Other characters should be copied as they are");
+    if (escape("caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80", true) != "caf\\u00e9 \\u20ac \\ud83d\\ude00")
+        throw std::runtime_error("ensureAscii should escape every character beyond ASCII");
+
+    std::string longText(1000, 'a');
+    longText[500] = '\n';
+    if (escape(longText, false) != std::string(500, 'a') + "\\n" + std::string(499, 'a'))
+        throw std::runtime_error("Long runs without escapes should be copied whole");
+
+    // Broken UTF-8 gets one replacement per sequence: a truncated sequence, a stray byte, a continuation byte, an overlong sequence.
+    if (escape("a\xE2\x82" "b\xFF\x80\xC0\x80 \xF0\x9F\x98", true) != "a\\ufffdb\\ufffd\\ufffd\\ufffd \\ufffd")
+        throw std::runtime_error("Invalid sequences should be replaced once each");
+
+    // A surrogate without its pair is stored as three bytes and written back as it was read.
+    JsonDocument document = JsonDocument::createFromString("[\"\\ud800\", \"x\\udfffy\", \"\\ud83d\\ude00\", \"caf\\u00e9\", \"\\u0000\"]");
+    JsonFormat ascii = JsonFormat::compact();
+    ascii.ensureAscii = true;
+    const std::string text = document.toString(ascii);
+    if (text != "[\"\\ud800\",\"x\\udfffy\",\"\\ud83d\\ude00\",\"caf\\u00e9\",\"\\u0000\"]")
+        throw std::runtime_error("Escaped text should round trip with ensureAscii");
+    if (!JsonDocument::createFromString(text).getRoot().equals(document.getRoot()))
+        throw std::runtime_error("The escaped text should read back as the same strings");
+    if (compact(JsonDocument::createFromString(compact(document))) != compact(document))
+        throw std::runtime_error("The text without ensureAscii should round trip too");
+    if (document.getRoot().toArray().getChild(0).toString().escaped() != "\xED\xA0\x80")
+        throw std::runtime_error("escaped() should keep the characters beyond ASCII");
+}
+
+static void testParallelSerialization()
+{
+    // A large array of objects, the same array inside a wrapper object, a large packed array and a small document.
+    std::string items = "[";
+    for (int i = 0; i < 20000; i++)
+        items += (i ? ", " : "") + std::string("{\"id\": ") + std::to_string(i) + ", \"name\": \"item " + std::to_string(i) + "\", \"tags\": [true, null, 0.5]}";
+    items += "]";
+    std::string numbers = "[";
+    for (int i = 0; i < 100000; i++)
+        numbers += (i ? ", " : "") + std::to_string(i) + ".25";
+    numbers += "]";
+
+    std::vector<JsonDocument> documents;
+    documents.push_back(JsonDocument::createFromString(items));
+    documents.push_back(JsonDocument::createFromString("{\"wrapper\": {\"items\": " + items + "}}"));
+    documents.push_back(JsonDocument::createFromString(numbers));
+    documents.push_back(JsonDocument::createFromString("{\"a\": [1, 2], \"b\": {\"c\": \"d\"}}"));
+    documents.push_back(JsonDocument::createFromString("[]"));
+    if (!documents[2].getRoot().toArray().isPacked())
+        throw std::runtime_error("The numbers should be packed");
+
+    const JsonFormat formats[] = {JsonFormat(), JsonFormat::indented(2), JsonFormat::compact()};
+    for (const JsonDocument &document : documents)
+    {
+        for (JsonFormat format : formats)
+        {
+            format.threads = 1;
+            const std::string serial = document.toString(format);
+            for (size_t threads : {0, 2, 4})
+            {
+                format.threads = threads;
+                if (document.toString(format) != serial)
+                    throw std::runtime_error("Several threads should write the same text as one thread");
+
+                std::ostringstream stream;
+                document.writeToStream(stream, format);
+                if (stream.str() != serial)
+                    throw std::runtime_error("A stream should receive the same text from several threads");
+            }
+        }
+    }
+    if (compact(JsonDocument::createFromString(documents[1].toString())) != compact(documents[1]))
+        throw std::runtime_error("The text should read back as the same document");
+
+    // An exception on a worker thread reaches the caller.
+    JsonDocument document = JsonDocument::createFromString(numbers);
+    document.getRoot().toArray().getChild(99999).toNumber() = std::numeric_limits<double>::infinity();
+    JsonFormat format = JsonFormat::compact();
+    format.threads = 4;
+    try
+    {
+        document.toString(format);
+        throw std::logic_error("An error while writing should be thrown by toString()");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+        throw std::runtime_error("Provide the name of a test");
+
+    std::string test = argv[1];
+
+    if (test == "formats")
+    {
+        testFormats();
+    }
+    else if (test == "escaping")
+    {
+        testEscaping();
+    }
+    else if (test == "parallel-serialization")
+    {
+        testParallelSerialization();
+    }
+    else
+    {
+        throw std::runtime_error("Unknown test: " + test);
+    }
+}
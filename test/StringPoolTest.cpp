@@ -0,0 +1,89 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "Json.hpp"
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+using namespace json;
+
+// Returns true if the document is written like a document parsed from the text, without indentation so deep documents stay small.
+static bool writesAs(const JsonDocument &document, const std::string &text)
+{
+    return document.toString(0) == JsonDocument::createFromString(text).toString(0);
+}
+
+static void testStringInterning()
+{
+    JsonStringPool pool(3);
+    std::string first = "name";
+    std::string second = "name";
+    JsonStringView interned = pool.intern(first);
+    if (interned != JsonStringView("name"))
+        throw std::runtime_error("The interned string should be equal to the original");
+    if (pool.intern(second).data() != interned.data())
+        throw std::runtime_error("Equal strings should be interned once");
+    if (pool.find("name").data() != interned.data())
+        throw std::runtime_error("find() should return the interned string");
+    if (pool.find("other").data() != nullptr)
+        throw std::runtime_error("find() should not add a string");
+    if (pool.size() != 1)
+        throw std::runtime_error("The pool should hold one string");
+    if (!pool.shouldInternValue("OK") || pool.shouldInternValue("long value"))
+        throw std::runtime_error("Only short values should be interned");
+
+    // Documents sharing a pool store every name once.
+    std::shared_ptr<JsonStringPool> shared = std::make_shared<JsonStringPool>(8);
+    JsonDocument a = JsonDocument::createFromString("{\"status\": \"OK\", \"id\": 1}", shared);
+    JsonDocument b = JsonDocument::createFromString("{\"status\": \"OK\", \"id\": 2}", shared);
+    const JsonObject &objectA = a.getRoot();
+    const JsonObject &objectB = b.getRoot();
+    if ((*objectA.begin()).first.data() != (*objectB.begin()).first.data())
+        throw std::runtime_error("The documents should share their names");
+    if (objectA["status"].toString().view().data() != objectB["status"].toString().view().data())
+        throw std::runtime_error("Short values should be shared as well");
+    if (a.getStringPool() != shared || b.getStringPool() != shared)
+        throw std::runtime_error("Both documents should use the shared pool");
+    if (!writesAs(b, "{\"status\":\"OK\",\"id\":2}"))
+        throw std::runtime_error("Interning should not change the text");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+        throw std::runtime_error("Provide the name of a test");
+
+    std::string test = argv[1];
+
+    if (test == "string-interning")
+    {
+        testStringInterning();
+    }
+    else
+    {
+        throw std::runtime_error("Unknown test: " + test);
+    }
+}
@@ -0,0 +1,310 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2020 Marcus Alevärn
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "Json.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace json;
+
+// Writes the same content as the document used by testDocumentParity().
+static void writeCustomers(JsonWriter &writer)
+{
+    writer.beginObject();
+    writer.key("customers").beginArray();
+    writer.beginObject().key("name").value("John Doe").key("age").value(45).key("alive").value(true).key("tags").beginArray().endArray().endObject();
+    writer.beginObject().key("name").value(std::string("Jane \"J\" Doe")).key("age").null().key("alive").value(false).key("tags").beginArray().value("a").value(1.5).endArray().endObject();
+    writer.endArray();
+    writer.key("meta").beginObject().endObject();
+    writer.key("count").value(uint64_t(18446744073709551615u));
+    writer.endObject();
+}
+
+static void testDocumentParity()
+{
+    JsonDocument document = JsonDocument::createFromString(
+        "{\"customers\": [{\"name\": \"John Doe\", \"age\": 45, \"alive\": true, \"tags\": []},"
+        " {\"name\": \"Jane \\\"J\\\" Doe\", \"age\": null, \"alive\": false, \"tags\": [\"a\", 1.5]}],"
+        " \"meta\": {}, \"count\": 18446744073709551615}");
+
+    const JsonFormat formats[] = {JsonFormat(), JsonFormat::indented(2), JsonFormat::compact()};
+    for (const JsonFormat &format : formats)
+    {
+        std::string output;
+        JsonWriter writer(output, format);
+        writeCustomers(writer);
+        if (!writer.isComplete() || writer.getDepth() != 0)
+            throw std::runtime_error("The writer should be complete after the root value");
+        writer.flush();
+        if (output != document.toString(format))
+            throw std::runtime_error("A writer should write the same text as the document:\n" + output);
+    }
+
+    std::ostringstream stream;
+    {
+        JsonWriter writer(stream, JsonFormat::compact());
+        writeCustomers(writer);
+    }
+    if (stream.str() != document.toString(JsonFormat::compact()))
+        throw std::runtime_error("A stream should receive the whole text when the writer is destroyed");
+}
+
+static void testScalars()
+{
+    std::string output;
+    JsonWriter writer(output, JsonFormat::compact());
+    writer.beginArray();
+    writer.value(std::numeric_limits<int64_t>::min()).value(std::numeric_limits<uint64_t>::max()).value(-7).value(0u);
+    writer.value(0.1).value(1e21).value(-0.0).value(true).value(false).null();
+    writer.value(static_cast<const char *>(nullptr)).value("tab\there").value(JsonStringView("view"));
+    writer.endArray().flush();
+    if (output != "[-9223372036854775808,18446744073709551615,-7,0,0.1,1e21,-0,true,false,null,null,\"tab\\there\",\"view\"]")
+        throw std::runtime_error("Every kind of value should be written: " + output);
+
+    std::string single;
+    JsonWriter root(single);
+    root.value(42).flush();
+    if (single != "42" || !root.isComplete())
+        throw std::runtime_error("A single value should make a complete document");
+
+    JsonFormat ascii = JsonFormat::compact();
+    ascii.ensureAscii = true;
+    ascii.decimals = 2;
+    std::string escaped;
+    JsonWriter formatted(escaped, ascii);
+    formatted.beginObject().key("caf\xC3\xA9").value(1.005).endObject().flush();
+    if (escaped != "{\"caf\\u00e9\":1.01}")
+        throw std::runtime_error("The format should apply to keys and numbers: " + escaped);
+
+    // Infinity and NaN have no JSON text, nothing is written for them.
+    std::string finite;
+    JsonWriter numbers(finite, JsonFormat::compact());
+    numbers.beginArray();
+    try
+    {
+        numbers.value(std::numeric_limits<double>::infinity());
+        throw std::logic_error("A writer should not write infinity");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+    try
+    {
+        numbers.value(std::numeric_limits<double>::quiet_NaN());
+        throw std::logic_error("A writer should not write NaN");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+    numbers.value(1).endArray().flush();
+    if (finite != "[1]")
+        throw std::runtime_error("Nothing should be written for a number that is rejected");
+}
+
+static void testNestingErrors()
+{
+    std::string output;
+
+    JsonWriter valueWithoutKey(output);
+    valueWithoutKey.beginObject();
+    try
+    {
+        valueWithoutKey.value(1);
+        throw std::logic_error("A value inside an object should need a key");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+    try
+    {
+        valueWithoutKey.beginArray();
+        throw std::logic_error("An array inside an object should need a key");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+
+    JsonWriter secondRoot(output);
+    secondRoot.value(1);
+    try
+    {
+        secondRoot.value(2);
+        throw std::logic_error("A second root value should not be allowed");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+    try
+    {
+        secondRoot.beginObject();
+        throw std::logic_error("A second root object should not be allowed");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+
+    JsonWriter mismatched(output);
+    mismatched.beginArray();
+    try
+    {
+        mismatched.endObject();
+        throw std::logic_error("An array should not be ended as an object");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+    mismatched.endArray();
+    try
+    {
+        mismatched.endArray();
+        throw std::logic_error("Nothing should be left to end");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+
+    JsonWriter keyOutsideObject(output);
+    try
+    {
+        keyOutsideObject.key("a");
+        throw std::logic_error("A key should need an object");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+    keyOutsideObject.beginArray();
+    try
+    {
+        keyOutsideObject.key("a");
+        throw std::logic_error("A key should not be allowed in an array");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+
+    JsonWriter doubleKey(output);
+    doubleKey.beginObject().key("a");
+    try
+    {
+        doubleKey.key("b");
+        throw std::logic_error("A key should not follow a key");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+    try
+    {
+        doubleKey.endObject();
+        throw std::logic_error("An object should not end with a key without a value");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+    if (doubleKey.isComplete() || doubleKey.getDepth() != 1)
+        throw std::runtime_error("The writer should still be inside the object");
+
+    // Nothing is written for a call that throws, so the writer can go on.
+    std::string recovered;
+    JsonWriter writer(recovered, JsonFormat::compact());
+    writer.beginObject();
+    try
+    {
+        writer.value("x");
+        throw std::logic_error("A value without a key should not be allowed");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+    writer.key("a");
+    try
+    {
+        writer.key("b");
+        throw std::logic_error("A key should not follow a key");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+    writer.value("x").endObject().flush();
+    if (recovered != "{\"a\":\"x\"}")
+        throw std::runtime_error("A rejected call should not write anything: " + recovered);
+}
+
+static void testNodeValues()
+{
+    JsonDocument document = JsonDocument::createFromString("{\"list\": [1, 2, {\"deep\": [true]}], \"name\": \"x\"}");
+    const JsonObject &root = document.getRoot().toObject();
+
+    const JsonFormat formats[] = {JsonFormat(), JsonFormat::compact()};
+    for (const JsonFormat &format : formats)
+    {
+        std::string output;
+        JsonWriter writer(output, format);
+        writer.beginObject();
+        writer.key("list").value(root.getChild("list"));
+        writer.key("name").value(root.getChild("name"));
+        writer.endObject().flush();
+        if (output != document.toString(format))
+            throw std::runtime_error("A node should be written at the depth of the writer:\n" + output);
+    }
+
+    std::string whole;
+    JsonWriter writer(whole, JsonFormat::compact());
+    writer.beginArray().value(document.getRoot()).value(document.getRoot()).endArray().flush();
+    const std::string text = document.toString(JsonFormat::compact());
+    if (whole != "[" + text + "," + text + "]")
+        throw std::runtime_error("Whole documents should be written as elements");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+        throw std::runtime_error("Provide the name of a test");
+
+    std::string test = argv[1];
+
+    if (test == "document-parity")
+    {
+        testDocumentParity();
+    }
+    else if (test == "scalars")
+    {
+        testScalars();
+    }
+    else if (test == "nesting-errors")
+    {
+        testNestingErrors();
+    }
+    else if (test == "node-values")
+    {
+        testNodeValues();
+    }
+    else
+    {
+        throw std::runtime_error("Unknown test: " + test);
+    }
+}